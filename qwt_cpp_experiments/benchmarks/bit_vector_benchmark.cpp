@@ -3,12 +3,15 @@
 #include <fstream>
 #include <iostream>
 #include <random>
+#include <string>
+#include <tuple>
 #include <vector>
 #include <thread>
 
 #include <tlx/cmdline_parser.hpp>
 #include <tlx/math.hpp>
 
+#include <pasta/bit_vector/dynamic_bit_vector.hpp>
 #include <pasta/utils/benchmark/do_not_optimize.hpp>
 #include <pasta/utils/reduce_alphabet.hpp>
 #include <pasta/wavelet_tree/wavelet_tree.hpp>
@@ -16,6 +19,8 @@
 #include <sdsl/int_vector.hpp>
 
 #include "../include/wm_int.hpp"
+#include "dependency_chains.hpp"
+#include "parallel_queries.hpp"
 
 class Benchmark {
 
@@ -23,8 +28,14 @@ public:
   size_t bit_size = 10'000'000;
   size_t number_queries = 10'000'000;
   size_t runs = 10;
+  bool parallel = false;
+  std::string thread_counts = "";
+  bool mlp = false;
+  std::string chains = "";
 
   void run() {
+    // Exits for an invalid number of chains, before anything is constructed
+    parse_chains(chains);
 
     auto const access_queries = generate_queries(number_queries);
     auto const rank_queries = generate_queries(number_queries);
@@ -41,10 +52,54 @@ public:
       pasta_bv[i] = bit_dist(gen) % 2;
     }
 
+    if (parallel || mlp) {
+      pasta::FlatRankSelect<> pasta_rs(pasta_bv);
+      run_experiments_queries(
+          access_queries, rank_queries, select_queries, "pasta_bv",
+          pasta_rs.space_usage() + pasta_bv.space_usage(),
+          [&](size_t const query) { return size_t{pasta_bv[query]}; },
+          [&](size_t const query, size_t const pos) {
+            return (query % 2 == 0) ? pasta_rs.rank0(pos)
+                                    : pasta_rs.rank1(pos);
+          },
+          [&](size_t const query, size_t const rank) {
+            return (query % 2 == 0) ? pasta_rs.select0(rank)
+                                    : pasta_rs.select1(rank);
+          });
+
+      sdsl::bit_vector sdsl_bv(bit_size, 0);
+      for (size_t i = 0; i < bit_size; ++i) {
+        sdsl_bv[i] = bit_dist(gen) % 2;
+      }
+      sdsl::bit_vector::rank_0_type sdsl_rank0_support(&sdsl_bv);
+      sdsl::bit_vector::select_0_type sdsl_select0_support(&sdsl_bv);
+      sdsl::bit_vector::rank_1_type sdsl_rank1_support(&sdsl_bv);
+      sdsl::bit_vector::select_1_type sdsl_select1_support(&sdsl_bv);
+      run_experiments_queries(
+          access_queries, rank_queries, select_queries, "sdsl_bv",
+          sdsl::size_in_bytes(sdsl_bv) +
+              sdsl::size_in_bytes(sdsl_rank0_support) +
+              sdsl::size_in_bytes(sdsl_select0_support) +
+              sdsl::size_in_bytes(sdsl_select1_support),
+          [&](size_t const query) { return size_t{sdsl_bv[query]}; },
+          [&](size_t const query, size_t const pos) {
+            return (query % 2 == 0) ? sdsl_rank0_support.rank(pos)
+                                    : sdsl_rank1_support.rank(pos);
+          },
+          [&](size_t const query, size_t const rank) {
+            return (query % 2 == 0) ? sdsl_select0_support.select(rank)
+                                    : sdsl_select1_support.select(rank);
+          });
+      return;
+    }
 
     run_experiments_pasta_latency(pasta_bv, access_queries, rank_queries, select_queries,
 			    "pasta_bv");
 
+    pasta::DynamicBitVector<> dynamic_bv(pasta_bv);
+    run_experiments_dynamic_latency(dynamic_bv, access_queries, rank_queries,
+                                    select_queries, "pasta_dynamic_bv");
+
     sdsl::bit_vector sdsl_bv(bit_size, 0);
     for (size_t i = 0; i < bit_size; ++i) {
       sdsl_bv[i] = bit_dist(gen) % 2;
@@ -177,6 +232,130 @@ private:
 	      << " n_runs=" << runs << std::endl;
   }
 
+  template <typename DynamicBitVector, typename AccessQueries,
+            typename RankQueries, typename SelectQueries>
+  void run_experiments_dynamic_latency(DynamicBitVector& bv,
+                                       AccessQueries& access_queries,
+                                       RankQueries& rank_queries,
+                                       SelectQueries& select_queries,
+                                       std::string name) {
+    tlx::Aggregate<size_t> time_access;
+    tlx::Aggregate<size_t> time_rank;
+    tlx::Aggregate<size_t> time_select;
+    tlx::Aggregate<size_t> time_set;
+    tlx::Aggregate<size_t> time_insert;
+    tlx::Aggregate<size_t> time_erase;
+    for (size_t i = 0; i < runs; ++i) {
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < access_queries.size(); ++i) {
+          size_t const pos = (access_queries[i] + result) % bit_size;
+          result = bv[pos];
+        }
+        time_access.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+	PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < rank_queries.size(); ++i) {
+          size_t const pos = (rank_queries[i] + result) % bit_size;
+	  if (rank_queries[i] % 2 == 0) {
+	    result = bv.rank0(pos);
+	  } else {
+	    result = bv.rank1(pos);
+	  }
+        }
+        time_rank.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+	PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < select_queries.size(); ++i) {
+          size_t pos = (select_queries[i] + (result % 2)) % (bit_size / 3);
+          pos = std::max(size_t{1}, pos);
+	  if (select_queries[i] % 2 == 0) {
+	    result = bv.select0(pos);
+	  } else {
+	    result = bv.select1(pos);
+	  }
+        }
+        time_select.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+	PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      // Updates: the number of bits does not change, as each insertion is
+      // followed by an erasure in the next loop.
+      {
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < access_queries.size(); ++i) {
+          bv.set(access_queries[i] % bit_size, rank_queries[i] % 2);
+        }
+        time_set.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+      }
+
+      {
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < access_queries.size(); ++i) {
+          bv.insert((access_queries[i] + i) % (bit_size + i), i % 2);
+        }
+        time_insert.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+      }
+
+      {
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < access_queries.size(); ++i) {
+          bv.erase(rank_queries[i] % bv.size());
+        }
+        time_erase.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+	PASTA_DO_NOT_OPTIMIZE(bv);
+      }
+    }
+
+    size_t const space = bv.space_usage();
+    for (auto const& [exp, time] :
+         {std::make_pair("access_latency", &time_access),
+          std::make_pair("rank_latency", &time_rank),
+          std::make_pair("select_latency", &time_select),
+          std::make_pair("set_latency", &time_set),
+          std::make_pair("insert_latency", &time_insert),
+          std::make_pair("erase_latency", &time_erase)}) {
+      std::cout << "RESULT algo=" << name
+	        << " exp=" << exp
+	        << " n=" << bit_size
+	        << " logn=" << tlx::integer_log2_ceil(bit_size)
+	        << " min_time_ns=" << time->min() / access_queries.size()
+	        << " max_time_ns=" << time->max() / access_queries.size()
+	        << " avg_time_ns=" << time->avg() / access_queries.size()
+	        << " space_in_bytes=" << space
+	        << " space_in_mib=" << (space / 1024.0 / 1024.0)
+	        << " n_queries=" << access_queries.size()
+	        << " n_runs=" << runs << std::endl;
+    }
+  }
+
   template <typename WaveletMatrix, typename AccessQueries,
 	    typename RankQueries, typename SelectQueries>
   void run_experiments_sdsl_latency(WaveletMatrix& bv, AccessQueries& access_queries,
@@ -288,7 +467,170 @@ private:
 	      << " n_queries=" << select_queries.size()
 	      << " n_runs=" << runs << std::endl;
   }
-  
+
+  // Runs the selected experiments of the -p and -m modes. access(pos),
+  // rank(query, pos), and select(query, rank) answer a query, where the
+  // parity of the query selects between rank0/rank1 and select0/select1.
+  template <typename Access, typename Rank, typename Select>
+  void run_experiments_queries(std::vector<size_t> const& access_queries,
+                               std::vector<size_t> const& rank_queries,
+                               std::vector<size_t> const& select_queries,
+                               std::string name, size_t space, Access access,
+                               Rank rank, Select select) {
+    if (parallel) {
+      run_experiments_parallel_throughput(access_queries, rank_queries,
+                                          select_queries, name, space, access,
+                                          rank, select);
+    }
+    if (mlp) {
+      run_experiments_mlp(access_queries, rank_queries, select_queries, name,
+                          space, access, rank, select);
+    }
+  }
+
+  // Between the latency (one dependency chain) and independent queries: The
+  // queries are answered in k interleaved dependency chains (see
+  // run_dependency_chains), each chaining its queries as the latency
+  // experiments do. The time per query for increasing k shows how much
+  // memory-level parallelism the bit vector can exploit.
+  template <typename Access, typename Rank, typename Select>
+  void run_experiments_mlp(std::vector<size_t> const& access_queries,
+                           std::vector<size_t> const& rank_queries,
+                           std::vector<size_t> const& select_queries,
+                           std::string name, size_t space, Access access,
+                           Rank rank, Select select) {
+    for (size_t const k : parse_chains(chains)) {
+      tlx::Aggregate<size_t> time_access;
+      tlx::Aggregate<size_t> time_rank;
+      tlx::Aggregate<size_t> time_select;
+      size_t result = 0;
+      for (size_t i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        result += run_dependency_chains(
+            k, access_queries, [&](size_t const query, size_t const previous) {
+              return access((query + previous) % bit_size);
+            });
+        time_access.add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start)
+                            .count());
+
+        start = std::chrono::steady_clock::now();
+        result += run_dependency_chains(
+            k, rank_queries, [&](size_t const query, size_t const previous) {
+              return rank(query, (query + previous) % bit_size);
+            });
+        time_rank.add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - start)
+                          .count());
+
+        start = std::chrono::steady_clock::now();
+        result += run_dependency_chains(
+            k, select_queries, [&](size_t const query, size_t const previous) {
+              return select(query,
+                            std::max(size_t{1}, (query + (previous % 2)) %
+                                                    (bit_size / 3)));
+            });
+        time_select.add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start)
+                            .count());
+      }
+      PASTA_DO_NOT_OPTIMIZE(result);
+
+      for (auto const& [exp, time, n_queries] :
+           {std::make_tuple("access_mlp", &time_access, access_queries.size()),
+            std::make_tuple("rank_mlp", &time_rank, rank_queries.size()),
+            std::make_tuple("select_mlp", &time_select,
+                            select_queries.size())}) {
+        std::cout << "RESULT algo=" << name
+                  << " exp=" << exp
+                  << " n=" << bit_size
+                  << " logn=" << tlx::integer_log2_ceil(bit_size)
+                  << " chains=" << k
+                  << " min_time_ns=" << time->min() / double(n_queries)
+                  << " max_time_ns=" << time->max() / double(n_queries)
+                  << " avg_time_ns=" << time->avg() / double(n_queries)
+                  << " space_in_bytes=" << space
+                  << " space_in_mib=" << (space / 1024.0 / 1024.0)
+                  << " n_queries=" << n_queries
+                  << " n_runs=" << runs << std::endl;
+      }
+    }
+  }
+
+  // Core-scaling curves: Each thread answers all queries, starting at a
+  // different query (see for_each_query_from), on the same bit vector. In
+  // contrast to the latency experiments, the queries are independent, i.e.,
+  // this measures the throughput of all threads together.
+  template <typename Access, typename Rank, typename Select>
+  void run_experiments_parallel_throughput(std::vector<size_t> const& access_queries,
+                                           std::vector<size_t> const& rank_queries,
+                                           std::vector<size_t> const& select_queries,
+                                           std::string name, size_t space,
+                                           Access access, Rank rank,
+                                           Select select) {
+    for (size_t const threads : parse_thread_counts(thread_counts)) {
+      std::vector<ThreadResult> results(threads);
+      tlx::Aggregate<size_t> time_access;
+      tlx::Aggregate<size_t> time_rank;
+      tlx::Aggregate<size_t> time_select;
+      for (size_t i = 0; i < runs; ++i) {
+        time_access.add(run_pinned_threads(threads, [&](size_t const thread) {
+          size_t result = 0;
+          for_each_query_from(access_queries,
+                              thread * access_queries.size() / threads,
+                              [&](size_t const query) {
+                                result += access(query % bit_size);
+                              });
+          results[thread].value += result;
+        }));
+        time_rank.add(run_pinned_threads(threads, [&](size_t const thread) {
+          size_t result = 0;
+          for_each_query_from(rank_queries,
+                              thread * rank_queries.size() / threads,
+                              [&](size_t const query) {
+                                result += rank(query, query % bit_size);
+                              });
+          results[thread].value += result;
+        }));
+        time_select.add(run_pinned_threads(threads, [&](size_t const thread) {
+          size_t result = 0;
+          for_each_query_from(select_queries,
+                              thread * select_queries.size() / threads,
+                              [&](size_t const query) {
+                                result += select(
+                                    query,
+                                    std::max(size_t{1},
+                                             query % (bit_size / 3)));
+                              });
+          results[thread].value += result;
+        }));
+      }
+      PASTA_DO_NOT_OPTIMIZE(results);
+
+      for (auto const& [exp, time, n_queries] :
+           {std::make_tuple("access_parallel_throughput", &time_access,
+                            access_queries.size()),
+            std::make_tuple("rank_parallel_throughput", &time_rank,
+                            rank_queries.size()),
+            std::make_tuple("select_parallel_throughput", &time_select,
+                            select_queries.size())}) {
+        double const total_queries = static_cast<double>(n_queries) * threads;
+        std::cout << "RESULT algo=" << name
+                  << " exp=" << exp
+                  << " n=" << bit_size
+                  << " logn=" << tlx::integer_log2_ceil(bit_size)
+                  << " threads=" << threads
+                  << " min_queries_per_s=" << total_queries / (time->max() / 1e9)
+                  << " max_queries_per_s=" << total_queries / (time->min() / 1e9)
+                  << " avg_queries_per_s=" << total_queries / (time->avg() / 1e9)
+                  << " space_in_bytes=" << space
+                  << " space_in_mib=" << (space / 1024.0 / 1024.0)
+                  << " n_queries=" << n_queries
+                  << " n_runs=" << runs << std::endl;
+      }
+    }
+  }
+
 }; // class Benchmark
 
 
@@ -304,6 +646,19 @@ tlx::CmdlineParser cp;
                "Number of queries tested. "
                "Default is 10'000'000.");
   cp.add_bytes('r', "runs", bench.runs, "Number of runs the benchmark is executed.");
+  cp.add_flag('p', "parallel", bench.parallel,
+              "Measure the throughput of multiple threads (pinned to cores) "
+              "querying the same bit vector instead of the latency.");
+  cp.add_flag('m', "mlp", bench.mlp,
+              "Measure the time per query of k interleaved dependency chains "
+              "(memory-level parallelism) instead of the latency.");
+  cp.add_string('t', "threads", bench.thread_counts,
+                "Comma-separated list of thread counts used with -p. Default "
+                "are all powers of two less than the number of hardware "
+                "threads and the number of hardware threads.");
+  cp.add_string('k', "chains", bench.chains,
+                "Comma-separated list of numbers of dependency chains (at "
+                "most 32) used with -m. Default is \"1,2,4,8,16,32\".");
 
   if (!cp.process(argc, argv)) {
     return -1;
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+// The largest number of independent dependency chains
+constexpr size_t max_chains = 32;
+
+// Parses a comma-separated list of numbers of chains (between 1 and
+// max_chains). The default sweep is 1, 2, 4, ..., max_chains. Exits if a
+// number of chains is invalid
+inline std::vector<size_t> parse_chains(std::string const& list) {
+  std::vector<size_t> chains;
+  if (list.empty()) {
+    for (size_t k = 1; k <= max_chains; k *= 2) {
+      chains.push_back(k);
+    }
+    return chains;
+  }
+  std::istringstream stream(list);
+  for (std::string k; std::getline(stream, k, ',');) {
+    size_t chain_count = 0;
+    auto const [end, error] =
+        std::from_chars(k.data(), k.data() + k.size(), chain_count);
+    if (error != std::errc() || end != k.data() + k.size() ||
+        chain_count == 0 || chain_count > max_chains) {
+      std::cerr << "Invalid number of chains " << k << " (must be between 1 "
+                << "and " << max_chains << ")\n";
+      exit(1);
+    }
+    chains.push_back(chain_count);
+  }
+  return chains;
+}
+
+// Answers the queries in Chains interleaved chains: query i belongs to chain
+// i % Chains and depends on the result of the previous query of its chain,
+// i.e., result = query(queries[i], result). With one chain, this is the
+// latency loop. With more chains, the queries of different chains are
+// independent and the CPU can have the cache misses of up to Chains queries
+// in flight. The results of the chains are kept in an array of compile time
+// size, such that they can stay in registers.
+template <size_t Chains, typename Queries, typename Query>
+size_t run_dependency_chains(Queries const& queries, Query query) {
+  std::array<size_t, Chains> results = {};
+  size_t i = 0;
+  for (; i + Chains <= queries.size(); i += Chains) {
+    for (size_t chain = 0; chain < Chains; ++chain) {
+      results[chain] = query(queries[i + chain], results[chain]);
+    }
+  }
+  for (size_t chain = 0; i < queries.size(); ++i, ++chain) {
+    results[chain] = query(queries[i], results[chain]);
+  }
+  size_t result = 0;
+  for (auto const chain_result : results) {
+    result += chain_result;
+  }
+  return result;
+}
+
+// Calls run_dependency_chains with the compile time number of chains equal
+// to chains (between 1 and max_chains)
+template <typename Queries, typename Query>
+size_t run_dependency_chains(size_t const chains, Queries const& queries,
+                             Query query) {
+  size_t result = 0;
+  [&]<size_t... K>(std::index_sequence<K...>) {
+    ((chains == K + 1
+          ? (result = run_dependency_chains<K + 1>(queries, query), true)
+          : false) ||
+     ...);
+  }(std::make_index_sequence<max_chains>{});
+  return result;
+}
+
+/******************************************************************************/
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tlx/math.hpp>
+
+#include <pasta/utils/benchmark/do_not_optimize.hpp>
+#include <pasta/utils/histogram.hpp>
+
+// Input, queries, and latency loops shared by the benchmarks of the wavelet
+// matrix variants (sharded and appendable)
+
+// Reads the prefix of size prefix_size of a file (the whole file if
+// prefix_size is 0) and sets prefix_size to the size of the text
+inline std::vector<uint8_t> load_text(std::string const& input_path,
+                                      size_t& prefix_size) {
+  std::ifstream stream(input_path.c_str(), std::ios::in | std::ios::binary);
+  if (!stream) {
+    std::cerr << "File " << input_path << " not found\n";
+    exit(1);
+  }
+  stream.seekg(0, std::ios::end);
+  uint64_t size = stream.tellg();
+  if (prefix_size > 0) {
+    size = std::min(prefix_size, size);
+  }
+  prefix_size = size;
+  stream.seekg(0);
+  std::vector<uint8_t> text(size);
+  stream.read(reinterpret_cast<char *>(text.data()), size);
+  stream.close();
+  return text;
+}
+
+inline std::vector<size_t>
+generate_access_queries(std::vector<uint8_t> const& text,
+                        size_t const number_queries) {
+  std::random_device rnd_device;
+  std::mt19937 mersenne_engine(rnd_device());
+  std::uniform_int_distribution<uint64_t> dist(0, text.size() - 1);
+
+  std::vector<size_t> random_queries(number_queries);
+  for (size_t i = 0; i < number_queries; ++i) {
+    random_queries[i] = dist(mersenne_engine);
+  }
+  return random_queries;
+}
+
+// Random positions with symbols drawn from the text
+inline std::vector<std::pair<size_t, uint8_t>>
+generate_rank_queries(std::vector<uint8_t> const& text,
+                      size_t const number_queries) {
+  std::random_device rnd_device;
+  std::mt19937 mersenne_engine(rnd_device());
+  std::uniform_int_distribution<uint64_t> dist(0, text.size() - 1);
+
+  std::vector<std::pair<size_t, uint8_t>> random_queries(number_queries);
+  for (size_t i = 0; i < number_queries; ++i) {
+    random_queries[i] = std::make_pair(dist(mersenne_engine),
+                                       text[dist(mersenne_engine)]);
+  }
+  return random_queries;
+}
+
+// Symbols drawn from the text with ranks up to their number of occurrences
+inline std::vector<std::pair<size_t, uint8_t>>
+generate_select_queries(std::vector<uint8_t> const& text,
+                        size_t const number_queries) {
+  pasta::Histogram hist(text.begin(), text.end());
+
+  std::random_device rnd_device;
+  std::mt19937 mersenne_engine(rnd_device());
+  std::uniform_int_distribution<uint64_t> dist(0, text.size() - 1);
+
+  std::vector<std::pair<size_t, uint8_t>> random_queries(number_queries);
+  for (size_t i = 0; i < number_queries; ++i) {
+    uint8_t const random_char = text[dist(mersenne_engine)];
+    std::uniform_int_distribution<uint64_t> dist_hist(1, hist[random_char]);
+    random_queries[i] = std::make_pair(dist_hist(mersenne_engine),
+                                       random_char);
+  }
+  return random_queries;
+}
+
+struct LatencyTimes {
+  tlx::Aggregate<size_t> access;
+  tlx::Aggregate<size_t> rank;
+  tlx::Aggregate<size_t> select;
+}; // struct LatencyTimes
+
+// Runs the access, rank, and select latency loops runs times. Each query
+// depends on the result of the previous one, hence, the queries cannot be
+// overlapped.
+template <typename WaveletMatrix, typename AccessQueries,
+          typename RankQueries, typename SelectQueries>
+LatencyTimes measure_latency(WaveletMatrix& wm,
+                             AccessQueries const& access_queries,
+                             RankQueries const& rank_queries,
+                             SelectQueries const& select_queries,
+                             size_t const prefix_size, size_t const runs) {
+  LatencyTimes times;
+  for (size_t i = 0; i < runs; ++i) {
+    {
+      size_t result = 0;
+      auto const start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < access_queries.size(); ++i) {
+        size_t const pos = (access_queries[i] + result) % prefix_size;
+        result = wm[pos];
+      }
+      times.access.add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - start)
+        .count());
+      PASTA_DO_NOT_OPTIMIZE(result);
+    }
+
+    {
+      size_t result = 0;
+      auto const start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < rank_queries.size(); ++i) {
+        size_t const pos = (rank_queries[i].first + result) % prefix_size;
+        result = wm.rank(pos, rank_queries[i].second);
+      }
+      times.rank.add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - start)
+        .count());
+      PASTA_DO_NOT_OPTIMIZE(result);
+    }
+
+    {
+      size_t result = 0;
+      auto const start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < select_queries.size(); ++i) {
+        size_t pos = (select_queries[i].first - 1 + (result % 2));
+        pos = std::max(size_t{1}, pos);
+        result = wm.select(pos, select_queries[i].second);
+      }
+      times.select.add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - start)
+        .count());
+      PASTA_DO_NOT_OPTIMIZE(result);
+    }
+  }
+  return times;
+}
+
+// Prints the RESULT line of a latency experiment. parameters contains the
+// experiment specific key-value pairs (e.g., " shards=4"), which are printed
+// after the experiment.
+inline void print_latency_result(std::string const& name,
+                                 std::string const& exp,
+                                 std::string const& parameters,
+                                 std::string const& input_path,
+                                 size_t const n,
+                                 tlx::Aggregate<size_t> const& time,
+                                 size_t const n_queries, size_t const space,
+                                 size_t const runs) {
+  std::cout << "RESULT algo=" << name
+	    << " exp=" << exp
+	    << parameters
+	    << " input=" << input_path
+	    << " n=" << n
+	    << " logn=" << tlx::integer_log2_ceil(n)
+	    << " min_time_ns=" << time.min() / n_queries
+	    << " max_time_ns=" << time.max() / n_queries
+	    << " avg_time_ns=" << time.avg() / n_queries
+	    << " space_in_bytes=" << space
+	    << " space_in_mib=" << (space / 1024.0 / 1024.0)
+	    << " n_queries=" << n_queries
+	    << " n_runs=" << runs << std::endl;
+}
+
+/******************************************************************************/
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#  include <cerrno>
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+// Thread counts of the core-scaling curves: all powers of two less than the
+// number of hardware threads and the number of hardware threads itself
+inline std::vector<size_t> default_thread_counts() {
+  size_t const max_threads =
+      std::max<size_t>(1, std::thread::hardware_concurrency());
+  std::vector<size_t> thread_counts;
+  for (size_t threads = 1; threads < max_threads; threads *= 2) {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(max_threads);
+  return thread_counts;
+}
+
+// Parses a comma-separated list of thread counts (the default thread counts
+// if the list is empty)
+inline std::vector<size_t> parse_thread_counts(std::string const& list) {
+  if (list.empty()) {
+    return default_thread_counts();
+  }
+  std::vector<size_t> thread_counts;
+  std::istringstream stream(list);
+  for (std::string threads; std::getline(stream, threads, ',');) {
+    if (!threads.empty() && std::stoul(threads) > 0) {
+      thread_counts.push_back(std::stoul(threads));
+    }
+  }
+  return thread_counts;
+}
+
+// The result of one thread, which has a cache line of its own, such that the
+// threads do not write to the same cache line (false sharing)
+struct alignas(64) ThreadResult {
+  size_t value = 0;
+}; // struct ThreadResult
+
+#ifdef __linux__
+// The CPUs the process may run on (e.g., restricted by taskset or a cgroup),
+// in increasing order
+inline std::vector<int> const& allowed_cpus() {
+  static std::vector<int> const cpus = []() {
+    std::vector<int> cpus;
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &cpu_set) == 0) {
+      for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &cpu_set)) {
+          cpus.push_back(cpu);
+        }
+      }
+    } else {
+      std::cerr << "Could not get the allowed CPUs: " << std::strerror(errno)
+                << std::endl;
+    }
+    return cpus;
+  }();
+  return cpus;
+}
+#endif
+
+// Pins the calling thread to the core-th CPU the process may run on
+// (wrapping around if there are fewer CPUs). Threads are pinned to the CPUs
+// in order, i.e., the first threads use one core each before the
+// hyper-threads (if the cores are numbered this way, as on Linux). If the
+// thread cannot be pinned, an error is printed and the thread is not pinned.
+inline void pin_to_core(size_t const core) {
+#ifdef __linux__
+  auto const& cpus = allowed_cpus();
+  if (cpus.empty()) {
+    return;
+  }
+  int const cpu = cpus[core % cpus.size()];
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu, &cpu_set);
+  int const error =
+      pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set);
+  if (error != 0) {
+    std::cerr << "Could not pin thread to CPU " << cpu << ": "
+              << std::strerror(error) << std::endl;
+  }
+#else
+  (void)core;
+#endif
+}
+
+// Runs query_stream(thread) on threads pinned threads and returns the time
+// (in nanoseconds) until all threads have finished. The time is measured once
+// all threads have been started and pinned, which is not part of the
+// measurement.
+template <typename QueryStream>
+size_t run_pinned_threads(size_t const threads, QueryStream query_stream) {
+  std::atomic<size_t> ready = 0;
+  std::atomic<bool> start = false;
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (size_t thread = 0; thread < threads; ++thread) {
+    workers.emplace_back([&, thread]() {
+      pin_to_core(thread);
+      ready.fetch_add(1, std::memory_order_release);
+      while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      query_stream(thread);
+    });
+  }
+  while (ready.load(std::memory_order_acquire) < threads) {
+    std::this_thread::yield();
+  }
+  auto const begin = std::chrono::steady_clock::now();
+  start.store(true, std::memory_order_release);
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - begin)
+      .count();
+}
+
+// Calls function for all queries, starting with the query at offset and
+// wrapping around. Thus, each thread answers its own query stream (a
+// rotation of the same queries), without storing the queries once per thread
+template <typename Queries, typename Function>
+void for_each_query_from(Queries const& queries, size_t const offset,
+                         Function function) {
+  for (size_t i = offset; i < queries.size(); ++i) {
+    function(queries[i]);
+  }
+  for (size_t i = 0; i < offset && i < queries.size(); ++i) {
+    function(queries[i]);
+  }
+}
+
+/******************************************************************************/
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+#  define QUERY_TIMER_RDTSC
+#endif
+
+// Times single queries using the time stamp counter (rdtsc at the start and
+// rdtscp at the end, both fenced with lfence, such that the query can neither
+// start before the first nor end after the second read). Without a time stamp
+// counter, steady_clock is used. The overhead of an empty measurement is
+// measured once and subtracted from each measurement.
+class QueryTimer {
+
+public:
+  QueryTimer() {
+    calibrate();
+  }
+
+  static uint64_t start() {
+#ifdef QUERY_TIMER_RDTSC
+    _mm_lfence();
+    uint64_t const ticks = __rdtsc();
+    _mm_lfence();
+    return ticks;
+#else
+    return now();
+#endif
+  }
+
+  static uint64_t stop() {
+#ifdef QUERY_TIMER_RDTSC
+    unsigned int aux;
+    uint64_t const ticks = __rdtscp(&aux);
+    _mm_lfence();
+    return ticks;
+#else
+    return now();
+#endif
+  }
+
+  static char const* name() {
+#ifdef QUERY_TIMER_RDTSC
+    return "rdtsc";
+#else
+    return "steady_clock";
+#endif
+  }
+
+  // Time between start and stop (without the overhead) in nanoseconds
+  double elapsed_ns(uint64_t const start, uint64_t const stop) const {
+    uint64_t const ticks = stop - start;
+    return (ticks > overhead_ticks_ ? ticks - overhead_ticks_ : 0) *
+           ns_per_tick_;
+  }
+
+  double overhead_ns() const {
+    return overhead_ticks_ * ns_per_tick_;
+  }
+
+private:
+  double ns_per_tick_ = 1.0;
+  uint64_t overhead_ticks_ = 0;
+
+  static uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  void calibrate() {
+    // The smallest time of an empty measurement is the overhead that is
+    // contained in every measurement
+    overhead_ticks_ = UINT64_MAX;
+    for (size_t i = 0; i < 10'000; ++i) {
+      uint64_t const begin = start();
+      overhead_ticks_ = std::min(overhead_ticks_, stop() - begin);
+    }
+#ifdef QUERY_TIMER_RDTSC
+    // The time stamp counter runs at a constant frequency (on all CPUs we
+    // use), which is measured against steady_clock for 20 ms
+    uint64_t const begin_ns = now();
+    uint64_t const begin_ticks = start();
+    while (now() - begin_ns < 20'000'000) {
+    }
+    uint64_t const end_ticks = stop();
+    ns_per_tick_ = static_cast<double>(now() - begin_ns) /
+                   static_cast<double>(end_ticks - begin_ticks);
+#endif
+  }
+}; // class QueryTimer
+
+// Histogram of latencies (in nanoseconds) with logarithmic buckets: Each
+// power of two is divided into 16 buckets, hence, a percentile is reported
+// with a relative error of at most 1/16.
+class LatencyHistogram {
+  static constexpr size_t SubBuckets = 16;
+  static constexpr size_t SubBits = 4;
+
+public:
+  void add(double const latency_ns) {
+    uint64_t const value = static_cast<uint64_t>(latency_ns);
+    ++buckets_[bucket(value)];
+    ++count_;
+    max_ = std::max(max_, value);
+  }
+
+  uint64_t count() const {
+    return count_;
+  }
+
+  uint64_t max() const {
+    return max_;
+  }
+
+  // Smallest latency such that at least the fraction p of all latencies is
+  // at most this latency (rounded up to the end of its bucket)
+  uint64_t percentile(double const p) const {
+    uint64_t const rank = std::max<uint64_t>(
+        1, static_cast<uint64_t>(std::ceil(p * count_)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+      seen += buckets_[i];
+      if (seen >= rank) {
+        return std::min(last_value(i), max_);
+      }
+    }
+    return max_;
+  }
+
+private:
+  std::array<uint64_t, (64 - SubBits + 1) * SubBuckets> buckets_ = {};
+  uint64_t count_ = 0;
+  uint64_t max_ = 0;
+
+  static size_t bucket(uint64_t const value) {
+    if (value < SubBuckets) {
+      return value;
+    }
+    size_t const exponent = std::bit_width(value) - 1;
+    size_t const sub_bucket =
+        (value >> (exponent - SubBits)) & (SubBuckets - 1);
+    return (exponent - SubBits + 1) * SubBuckets + sub_bucket;
+  }
+
+  static uint64_t last_value(size_t const bucket) {
+    if (bucket < SubBuckets) {
+      return bucket;
+    }
+    size_t const exponent = bucket / SubBuckets + SubBits - 1;
+    uint64_t const first = (SubBuckets + bucket % SubBuckets)
+                           << (exponent - SubBits);
+    return first + (uint64_t{1} << (exponent - SubBits)) - 1;
+  }
+}; // class LatencyHistogram
+
+// Answers the queries as dependency chain (result = query(queries[i],
+// result)), as in the latency experiments, and times every sample_rate-th
+// query individually
+template <typename Queries, typename Query>
+size_t sample_latencies(Queries const& queries, size_t const sample_rate,
+                        QueryTimer const& timer, LatencyHistogram& histogram,
+                        Query query) {
+  size_t result = 0;
+  for (size_t i = 0; i < queries.size(); ++i) {
+    if (i % sample_rate == 0) {
+      uint64_t const start = timer.start();
+      result = query(queries[i], result);
+      uint64_t const stop = timer.stop();
+      histogram.add(timer.elapsed_ns(start, stop));
+    } else {
+      result = query(queries[i], result);
+    }
+  }
+  return result;
+}
+
+/******************************************************************************/
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+// One result of an experiment, i.e., the ordered key-value pairs of a
+// RESULT line
+class Record {
+
+public:
+  struct Field {
+    std::string key;
+    std::string value;
+    bool is_number;
+  };
+
+  template <typename Value>
+  Record& add(std::string const& key, Value const& value) {
+    std::ostringstream stream;
+    stream << value;
+    // Non-finite numbers (e.g., an infinite throughput) are written as strings
+    bool is_number = std::is_arithmetic_v<Value>;
+    if constexpr (std::is_floating_point_v<Value>) {
+      is_number = std::isfinite(value);
+    }
+    fields_.push_back({key, stream.str(), is_number});
+    return *this;
+  }
+
+  std::vector<Field> const& fields() const {
+    return fields_;
+  }
+
+private:
+  std::vector<Field> fields_;
+}; // class Record
+
+// Writes records as RESULT lines (text), JSON lines (json), or a CSV table
+// (csv). For json and csv, each record also contains the machine and build
+// metadata, such that results of different benchmark boxes can be merged.
+// As the fields differ between experiments, the CSV table is written at the
+// end, using the union of all fields as columns.
+class ResultWriter {
+
+public:
+  static bool is_format(std::string const& format) {
+    return format == "text" || format == "json" || format == "csv";
+  }
+
+  void set_format(std::string const& format) {
+    format_ = format;
+    if (format_ != "text") {
+      metadata_ = machine_and_build_metadata();
+    }
+  }
+
+  void write(Record const& record) {
+    if (format_ == "json") {
+      write_json(record);
+    } else if (format_ == "csv") {
+      records_.push_back(record);
+    } else {
+      std::cout << "RESULT";
+      for (auto const& field : record.fields()) {
+        std::cout << ' ' << field.key << '=' << field.value;
+      }
+      std::cout << std::endl;
+    }
+  }
+
+  void finish() {
+    if (format_ == "csv") {
+      write_csv();
+    }
+  }
+
+private:
+  std::string format_ = "text";
+  std::vector<Record::Field> metadata_;
+  std::vector<Record> records_;
+
+  static std::vector<Record::Field> machine_and_build_metadata() {
+    Record metadata;
+
+    char hostname[256] = {0};
+    gethostname(hostname, sizeof(hostname) - 1);
+    metadata.add("host", std::string(hostname));
+
+    std::string cpu = "unknown";
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    for (std::string line; std::getline(cpuinfo, line);) {
+      if (line.rfind("model name", 0) == 0) {
+        cpu = line.substr(line.find(':') + 2);
+        break;
+      }
+    }
+    metadata.add("cpu", cpu);
+    metadata.add("hardware_threads", std::thread::hardware_concurrency());
+
+    std::time_t const now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ",
+                  std::gmtime(&now));
+    metadata.add("date", std::string(date));
+
+    metadata.add("compiler", std::string(__VERSION__));
+#ifdef NDEBUG
+    metadata.add("build_type", std::string("release"));
+#else
+    metadata.add("build_type", std::string("debug"));
+#endif
+    std::string isa = "generic";
+#ifdef __BMI2__
+    isa += "+bmi2";
+#endif
+#ifdef __AVX2__
+    isa += "+avx2";
+#endif
+#ifdef __AVX512F__
+    isa += "+avx512f";
+#endif
+    metadata.add("isa", isa);
+    return metadata.fields();
+  }
+
+  // JSON strings escape quotes and backslashes with a backslash, CSV fields
+  // escape quotes with another quote
+  static std::string escape(std::string const& value, bool const json) {
+    std::string escaped;
+    for (char const c : value) {
+      if (c == '"') {
+        escaped += json ? '\\' : '"';
+      } else if (json && c == '\\') {
+        escaped += '\\';
+      }
+      escaped += c;
+    }
+    return escaped;
+  }
+
+  void write_json(Record const& record) const {
+    char separator = '{';
+    for (auto const* fields : {&metadata_, &record.fields()}) {
+      for (auto const& field : *fields) {
+        std::cout << separator << '"' << field.key << "\":";
+        if (field.is_number) {
+          std::cout << field.value;
+        } else {
+          std::cout << '"' << escape(field.value, true) << '"';
+        }
+        separator = ',';
+      }
+    }
+    std::cout << '}' << std::endl;
+  }
+
+  void write_csv() const {
+    std::vector<std::string> columns;
+    for (auto const& field : metadata_) {
+      columns.push_back(field.key);
+    }
+    for (auto const& record : records_) {
+      for (auto const& field : record.fields()) {
+        if (std::find(columns.begin(), columns.end(), field.key) ==
+            columns.end()) {
+          columns.push_back(field.key);
+        }
+      }
+    }
+
+    for (size_t i = 0; i < columns.size(); ++i) {
+      std::cout << (i > 0 ? "," : "") << columns[i];
+    }
+    std::cout << '\n';
+    for (auto const& record : records_) {
+      for (size_t i = 0; i < columns.size(); ++i) {
+        std::cout << (i > 0 ? "," : "");
+        for (auto const* fields : {&metadata_, &record.fields()}) {
+          auto const it = std::find_if(
+              fields->begin(), fields->end(),
+              [&](auto const& field) { return field.key == columns[i]; });
+          if (it != fields->end() && it->is_number) {
+            std::cout << it->value;
+            break;
+          } else if (it != fields->end()) {
+            std::cout << '"' << escape(it->value, false) << '"';
+            break;
+          }
+        }
+      }
+      std::cout << '\n';
+    }
+    std::cout << std::flush;
+  }
+}; // class ResultWriter
+
+/******************************************************************************/
@@ -9,6 +9,9 @@
 #include <tlx/cmdline_parser.hpp>
 #include <tlx/math.hpp>
 
+#include <pasta/utils/benchmark/do_not_optimize.hpp>
+
+#include <pasta/utils/byte_alphabet.hpp>
 #include <pasta/utils/reduce_alphabet.hpp>
 
 
@@ -21,9 +24,13 @@ public:
   size_t alphabet_size_;
   size_t prefix_size = {0};
   std::string input_path = "";
+  size_t runs = 5;
+  size_t threads = std::thread::hardware_concurrency();
 
   void run() {
     load_text();
+    run_histogram();
+    run_remap();
     reduce_alphabet();
 
     std::cout << "RESULT algo=pasta_construction"
@@ -35,6 +42,98 @@ public:
     
 private:
 
+  // The setup is executed before each run and is not measured
+  template <typename Setup, typename Function>
+  tlx::Aggregate<size_t> measure(Setup&& setup, Function&& function) {
+    tlx::Aggregate<size_t> time;
+    for (size_t i = 0; i < runs; ++i) {
+      setup();
+      auto const start = std::chrono::steady_clock::now();
+      function();
+      time.add(std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now() - start)
+                   .count());
+    }
+    return time;
+  }
+
+  void print_result(std::string const& algo, std::string const& impl,
+                    size_t const used_threads,
+                    tlx::Aggregate<size_t> const& time) {
+    std::cout << "RESULT algo=" << algo
+	      << " impl=" << impl
+	      << " threads=" << used_threads
+	      << " input=" << input_path
+	      << " n=" << input_.size()
+	      << " logn=" << tlx::integer_log2_ceil(input_.size())
+	      << " min_time_us=" << time.min()
+	      << " max_time_us=" << time.max()
+	      << " avg_time_us=" << time.avg()
+	      << " n_runs=" << runs << std::endl;
+  }
+
+  // One table, four tables, and four tables per thread
+  void run_histogram() {
+    print_result("histogram", "single_table", 1, measure([]() {}, [&]() {
+      pasta::Histogram<std::vector<uint8_t>::const_iterator> const hist(
+          input_.cbegin(), input_.cend());
+      PASTA_DO_NOT_OPTIMIZE(hist);
+    }));
+    print_result("histogram", "multi_table", 1, measure([]() {}, [&]() {
+      auto const hist = pasta::byte_histogram(input_.data(), input_.size());
+      PASTA_DO_NOT_OPTIMIZE(hist);
+    }));
+    print_result("histogram", "multi_table", threads,
+                 measure([]() {}, [&]() {
+      auto const hist =
+          pasta::byte_histogram(input_.data(), input_.size(), threads);
+      PASTA_DO_NOT_OPTIMIZE(hist);
+    }));
+  }
+
+  // Each run remaps a fresh copy of the text, as remapping the same text
+  // again would change it (unless the mapping is the identity)
+  void run_remap() {
+    auto const hist = pasta::byte_histogram(input_.data(), input_.size());
+    pasta::ByteMapping mapping = {0};
+    for (size_t symbol = 0, rank = 0; symbol < hist.size(); ++symbol) {
+      if (hist[symbol] > 0) {
+        mapping[symbol] = rank++;
+      }
+    }
+    std::vector<uint8_t> text(input_.size());
+    auto const copy_text = [&]() {
+      std::copy(input_.begin(), input_.end(), text.begin());
+    };
+
+    print_result("remap", "scalar", 1, measure(copy_text, [&]() {
+      pasta::remap_bytes_scalar(text.data(), text.size(), mapping);
+    }));
+    if (pasta::remap_bytes_simd_supported()) {
+      print_result("remap", "avx2", 1, measure(copy_text, [&]() {
+        pasta::remap_bytes(text.data(), text.size(), mapping, hist);
+      }));
+      print_result("remap", "avx2", threads, measure(copy_text, [&]() {
+        pasta::remap_bytes(text.data(), text.size(), mapping, hist, threads);
+      }));
+    }
+
+    // Complete alphabet reduction (histogram and remapping)
+    print_result("reduce_alphabet", "histogram_scalar", 1,
+                 measure(copy_text, [&]() {
+      pasta::reduce_alphabet(text.begin(), text.end());
+    }));
+    print_result("reduce_alphabet", "byte_alphabet", 1,
+                 measure(copy_text, [&]() {
+      pasta::reduce_byte_alphabet(text.data(), text.data() + text.size());
+    }));
+    print_result("reduce_alphabet", "byte_alphabet", threads,
+                 measure(copy_text, [&]() {
+      pasta::reduce_byte_alphabet(text.data(), text.data() + text.size(),
+                                  nullptr, threads);
+    }));
+  }
+
   void load_text() {
     // Read prefix of file
     std::ifstream stream(input_path.c_str(), std::ios::in | std::ios::binary);
@@ -74,6 +173,11 @@ tlx::CmdlineParser cp;
                "Size (in bytes unless stated "
                "otherwise) of the string that use to test our suffix array "
                "construction algorithms.");
+  cp.add_bytes('r', "runs", bench.runs,
+               "Number of runs the timings are measured.");
+  cp.add_bytes('t', "threads", bench.threads,
+               "Number of threads used by the parallel histogram and "
+               "remapping (default number of hardware threads).");
 
   if (!cp.process(argc, argv)) {
     return -1;
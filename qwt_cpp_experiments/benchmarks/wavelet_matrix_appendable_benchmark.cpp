@@ -0,0 +1,167 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <tlx/cmdline_parser.hpp>
+#include <tlx/math.hpp>
+
+#include <pasta/utils/reduce_alphabet.hpp>
+#include <pasta/wavelet_tree/appendable_wavelet_matrix.hpp>
+#include <pasta/wavelet_tree/wavelet_tree.hpp>
+
+#include "latency_queries.hpp"
+
+class Benchmark {
+
+private:
+  std::vector<uint8_t> input_;
+  size_t alphabet_size_;
+
+public:
+
+  size_t prefix_size = {0};
+  std::string input_path = "";
+  size_t number_queries = 1'000'000;
+  size_t buffer_size = 4096;
+  size_t runs = 5;
+
+  void run() {
+    input_ = load_text(input_path, prefix_size);
+    // Compute effective alphabet and effective alphabet size
+    alphabet_size_ = pasta::reduce_alphabet(input_.begin(), input_.end());
+
+    auto const access_queries = generate_access_queries(input_,
+                                                        number_queries);
+    auto const rank_queries = generate_rank_queries(input_, number_queries);
+    auto const select_queries = generate_select_queries(input_,
+                                                        number_queries);
+
+    // Baseline: static wavelet matrix built once for the whole text
+    {
+      auto const start = std::chrono::steady_clock::now();
+      auto pasta_wm = pasta::make_wm<pasta::BitVector>(input_.begin(),
+                                                       input_.end(),
+                                                       alphabet_size_);
+      size_t const construction_time =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - start)
+        .count();
+      std::cout << "RESULT algo=pasta_wm"
+	        << " exp=construction"
+	        << " input=" << input_path
+	        << " n=" << input_.size()
+	        << " logn=" << tlx::integer_log2_ceil(input_.size())
+	        << " construction_time_ms=" << construction_time / 1'000'000
+	        << " time_per_symbol_ns="
+	        << (construction_time / static_cast<double>(input_.size()))
+	        << std::endl;
+      run_experiments_latency(pasta_wm, access_queries, rank_queries,
+                              select_queries, "pasta_wm",
+                              pasta_wm.space_usage());
+    }
+
+    for (bool const background_merge : {false, true}) {
+      std::string const name = background_merge ?
+        "pasta_appendable_wm_background" : "pasta_appendable_wm_foreground";
+      pasta::AppendableWaveletMatrix<pasta::BitVector, uint8_t> awm(
+          alphabet_size_, buffer_size, background_merge);
+
+      auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < input_.size(); ++i) {
+        awm.append(input_[i]);
+      }
+      size_t const append_time =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - start)
+        .count();
+      size_t const segments_after_append = awm.segments();
+
+      start = std::chrono::steady_clock::now();
+      awm.wait_for_merge();
+      size_t const wait_time =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - start)
+        .count();
+
+      auto const& stats = awm.merge_statistics();
+      std::cout << "RESULT algo=" << name
+	        << " exp=append"
+	        << " input=" << input_path
+	        << " n=" << input_.size()
+	        << " logn=" << tlx::integer_log2_ceil(input_.size())
+	        << " buffer_size=" << buffer_size
+	        << " append_time_ms=" << append_time / 1'000'000
+	        << " append_time_per_symbol_ns="
+	        << (append_time / static_cast<double>(input_.size()))
+	        << " append_throughput_mib_s="
+	        << ((input_.size() / 1024.0 / 1024.0) /
+	            (append_time / 1'000'000'000.0))
+	        << " wait_for_merge_time_ms=" << wait_time / 1'000'000
+	        << " merges=" << stats.merges
+	        << " merged_symbols=" << stats.merged_symbols
+	        << " merge_amplification="
+	        << (stats.merged_symbols / static_cast<double>(input_.size()))
+	        << " merge_time_ms=" << stats.merge_time_ns / 1'000'000
+	        << " segments_after_append=" << segments_after_append
+	        << " segments=" << awm.segments() << std::endl;
+
+      run_experiments_latency(awm, access_queries, rank_queries,
+                              select_queries, name, awm.space_usage());
+    }
+  }
+
+private:
+
+  template <typename WaveletMatrix, typename AccessQueries,
+            typename RankQueries, typename SelectQueries>
+  void run_experiments_latency(WaveletMatrix& wm,
+                               AccessQueries& access_queries,
+                               RankQueries& rank_queries,
+                               SelectQueries& select_queries,
+                               std::string name, size_t space) {
+    auto const times = measure_latency(wm, access_queries, rank_queries,
+                                       select_queries, prefix_size, runs);
+    std::string const parameters =
+        " buffer_size=" + std::to_string(buffer_size);
+    print_latency_result(name, "access_latency", parameters, input_path,
+                         input_.size(), times.access, access_queries.size(),
+                         space, runs);
+    print_latency_result(name, "rank_latency", parameters, input_path,
+                         input_.size(), times.rank, rank_queries.size(),
+                         space, runs);
+    print_latency_result(name, "select_latency", parameters, input_path,
+                         input_.size(), times.select, select_queries.size(),
+                         space, runs);
+  }
+
+}; // class Benchmark
+
+
+int32_t main(int argc, char *argv[]) {
+  tlx::CmdlineParser cp;
+
+  cp.set_description("Appendable Wavelet Matrix Benchmark");
+
+  Benchmark bench;
+
+  cp.add_param_string("input", bench.input_path, "Path to input file.");
+  cp.add_bytes('n', "size", bench.prefix_size,
+               "Size (in bytes unless stated otherwise) of the prefix of the "
+               "input that is used.");
+  cp.add_bytes('q', "queries", bench.number_queries,
+               "Number of queries per query type. Default is 1'000'000.");
+  cp.add_bytes('b', "buffer_size", bench.buffer_size,
+               "Number of symbols in the write buffer. Default is 4096.");
+  cp.add_bytes('r', "runs", bench.runs, "Number of runs the benchmark is executed.");
+
+  if (!cp.process(argc, argv)) {
+    return -1;
+  }
+
+  bench.run();
+
+  return 0;
+}
+
+/******************************************************************************/
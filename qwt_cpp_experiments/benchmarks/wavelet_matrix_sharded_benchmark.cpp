@@ -0,0 +1,171 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tlx/cmdline_parser.hpp>
+#include <tlx/math.hpp>
+
+#include <pasta/utils/reduce_alphabet.hpp>
+#include <pasta/wavelet_tree/sharded_wavelet_matrix.hpp>
+#include <pasta/wavelet_tree/wavelet_tree.hpp>
+
+#include "latency_queries.hpp"
+
+class Benchmark {
+
+private:
+  std::vector<uint8_t> input_;
+  size_t alphabet_size_;
+
+public:
+
+  size_t prefix_size = {0};
+  std::string input_path = "";
+  size_t number_queries = 1'000'000;
+  size_t max_shards = 64;
+  size_t threads = std::thread::hardware_concurrency();
+  size_t runs = 5;
+
+  void run() {
+    input_ = load_text(input_path, prefix_size);
+    // Compute effective alphabet and effective alphabet size
+    alphabet_size_ = pasta::reduce_alphabet(input_.begin(), input_.end());
+
+    auto const access_queries = generate_access_queries(input_,
+                                                        number_queries);
+    auto const rank_queries = generate_rank_queries(input_, number_queries);
+    auto const select_queries = generate_select_queries(input_,
+                                                        number_queries);
+
+    // Baseline: one monolithic wavelet matrix built by a single thread
+    {
+      tlx::Aggregate<size_t> construction_time;
+      for (size_t i = 0; i + 1 < runs; ++i) {
+        auto const start = std::chrono::steady_clock::now();
+        auto pasta_wm = pasta::make_wm<pasta::BitVector>(input_.begin(),
+                                                         input_.end(),
+                                                         alphabet_size_);
+        construction_time.add(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+      }
+      // The last construction is kept for the queries.
+      auto const start = std::chrono::steady_clock::now();
+      auto pasta_wm = pasta::make_wm<pasta::BitVector>(input_.begin(),
+                                                       input_.end(),
+                                                       alphabet_size_);
+      construction_time.add(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+        .count());
+      run_experiments_latency(pasta_wm, access_queries, rank_queries,
+                              select_queries, "pasta_wm", 1, 1,
+                              construction_time, pasta_wm.space_usage());
+    }
+
+    for (size_t shards = 1; shards <= max_shards; shards *= 2) {
+      size_t const shard_size = tlx::div_ceil(input_.size(), shards);
+      tlx::Aggregate<size_t> construction_time;
+      for (size_t i = 0; i + 1 < runs; ++i) {
+        auto const start = std::chrono::steady_clock::now();
+        auto sharded_wm = pasta::make_sharded_wm<pasta::BitVector>(
+            input_.begin(), input_.end(), alphabet_size_, shard_size,
+            threads);
+        construction_time.add(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+      }
+      // The last construction is kept for the queries.
+      auto const start = std::chrono::steady_clock::now();
+      auto sharded_wm = pasta::make_sharded_wm<pasta::BitVector>(
+          input_.begin(), input_.end(), alphabet_size_, shard_size, threads);
+      construction_time.add(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+        .count());
+      run_experiments_latency(sharded_wm, access_queries, rank_queries,
+                              select_queries, "pasta_sharded_wm",
+                              sharded_wm.shards(), threads, construction_time,
+                              sharded_wm.space_usage());
+    }
+  }
+
+private:
+
+  template <typename WaveletMatrix, typename AccessQueries,
+            typename RankQueries, typename SelectQueries>
+  void run_experiments_latency(WaveletMatrix& wm,
+                               AccessQueries& access_queries,
+                               RankQueries& rank_queries,
+                               SelectQueries& select_queries,
+                               std::string name, size_t const shards,
+                               size_t const used_threads,
+                               tlx::Aggregate<size_t> const& construction_time,
+                               size_t space) {
+    std::cout << "RESULT algo=" << name
+	      << " exp=construction"
+	      << " shards=" << shards
+	      << " threads=" << used_threads
+	      << " input=" << input_path
+	      << " n=" << input_.size()
+	      << " logn=" << tlx::integer_log2_ceil(input_.size())
+	      << " min_construction_time_ms=" << construction_time.min()
+	      << " max_construction_time_ms=" << construction_time.max()
+	      << " avg_construction_time_ms=" << construction_time.avg()
+	      << " space_in_bytes=" << space
+	      << " space_in_mib=" << (space / 1024.0 / 1024.0)
+	      << " n_runs=" << runs << std::endl;
+
+    auto const times = measure_latency(wm, access_queries, rank_queries,
+                                       select_queries, prefix_size, runs);
+    std::string const parameters = " shards=" + std::to_string(shards) +
+                                   " threads=" + std::to_string(used_threads);
+    print_latency_result(name, "access_latency", parameters, input_path,
+                         input_.size(), times.access, access_queries.size(),
+                         space, runs);
+    print_latency_result(name, "rank_latency", parameters, input_path,
+                         input_.size(), times.rank, rank_queries.size(),
+                         space, runs);
+    print_latency_result(name, "select_latency", parameters, input_path,
+                         input_.size(), times.select, select_queries.size(),
+                         space, runs);
+  }
+
+}; // class Benchmark
+
+
+int32_t main(int argc, char *argv[]) {
+  tlx::CmdlineParser cp;
+
+  cp.set_description("Sharded Wavelet Matrix Benchmark");
+
+  Benchmark bench;
+
+  cp.add_param_string("input", bench.input_path, "Path to input file.");
+  cp.add_bytes('n', "size", bench.prefix_size,
+               "Size (in bytes unless stated otherwise) of the prefix of the "
+               "input that is used.");
+  cp.add_bytes('q', "queries", bench.number_queries,
+               "Number of queries per query type. Default is 1'000'000.");
+  cp.add_bytes('s', "max_shards", bench.max_shards,
+               "Maximum number of shards. The number of shards is doubled "
+               "from 1 up to this value. Default is 64.");
+  cp.add_bytes('t', "threads", bench.threads,
+               "Number of threads used to build the shards. Default is the "
+               "number of hardware threads.");
+  cp.add_bytes('r', "runs", bench.runs, "Number of runs the benchmark is executed.");
+
+  if (!cp.process(argc, argv)) {
+    return -1;
+  }
+
+  bench.run();
+
+  return 0;
+}
+
+/******************************************************************************/
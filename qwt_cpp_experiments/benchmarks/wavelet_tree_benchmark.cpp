@@ -1,8 +1,11 @@
 #include <algorithm>
 #include <chrono>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <random>
+#include <sstream>
+#include <tuple>
 #include <vector>
 #include <thread>
 
@@ -10,7 +13,9 @@
 #include <tlx/math.hpp>
 
 #include <pasta/utils/benchmark/do_not_optimize.hpp>
+#include <pasta/utils/benchmark/memory_monitor.hpp>
 #include <pasta/utils/reduce_alphabet.hpp>
+#include <pasta/wavelet_tree/occurrence_table.hpp>
 #include <pasta/wavelet_tree/wavelet_tree.hpp>
 
 #include <sdsl/int_vector.hpp>
@@ -18,7 +23,12 @@
 // #include <sdsl/wt_huff.hpp>
 // #include <sdsl/construct.hpp>
 
+#include "../include/pasta_support.hpp"
 #include "../include/wm_int.hpp"
+#include "dependency_chains.hpp"
+#include "parallel_queries.hpp"
+#include "query_timer.hpp"
+#include "result_writer.hpp"
 
 #include <sdsl/wt_huff.hpp>
 #include <sdsl/wavelet_trees.hpp>
@@ -26,12 +36,28 @@
 #include <sdsl/util.hpp>
 
 
+// A data structure that can be selected from the command line. Running it
+// constructs the data structure and runs the selected experiments. Data
+// structures that are not run by default must be selected by name.
+struct Structure {
+  std::string name;
+  std::string description;
+  bool by_default;
+  std::function<void()> run;
+};
+
 class Benchmark {
 
 private:
   std::vector<uint8_t> input_;
   size_t alphabet_size_;
   size_t number_queries_;
+  pasta::MemoryMonitor& mem_monitor_ = pasta::MemoryMonitor::instance();
+  ResultWriter writer_;
+
+  std::vector<size_t> access_queries_;
+  std::vector<std::pair<size_t, uint8_t>> rank_queries_;
+  std::vector<std::pair<size_t, uint8_t>> select_queries_;
 
 public:
 
@@ -39,55 +65,259 @@ public:
   std::string input_path = "";
   size_t number_queries = 10'000'000;
   size_t runs = 10;
+  std::string structures = "default";
+  std::string experiments = "latency,allocations";
+  std::string format = "text";
+  std::string thread_counts = "";
+  std::string chains = "";
+  size_t sample_rate = 100;
+  bool list = false;
+
+  // All data structures in the order they are run. Data structures are only
+  // constructed if they are selected, and destroyed before the next one is
+  // constructed.
+  std::vector<Structure> registry() {
+    return {
+      {"pasta_wm", "pasta wavelet matrix", true, [&]() {
+        run_structure("pasta_wm", [&]() {
+          return pasta::make_wm<pasta::BitVector>(input_.begin(), input_.end(),
+                                                  alphabet_size_);
+        });
+      }},
+      {"pasta_wt", "pasta wavelet tree", false, [&]() {
+        run_structure("pasta_wt", [&]() {
+          return pasta::make_wt<pasta::BitVector>(input_.begin(), input_.end(),
+                                                  alphabet_size_);
+        });
+      }},
+      // Small alphabets (e.g., DNA) can be answered by an occurrence table
+      {"pasta_occ", "pasta occurrence table (at most 16 symbols)", true,
+       [&]() {
+        if (alphabet_size_ <= 4) {
+          run_structure("pasta_occ", [&]() {
+            return pasta::OccurrenceTable<2>(input_.begin(), input_.end(),
+                                             alphabet_size_);
+          });
+        } else if (alphabet_size_ <= 16) {
+          run_structure("pasta_occ", [&]() {
+            return pasta::OccurrenceTable<4>(input_.begin(), input_.end(),
+                                             alphabet_size_);
+          });
+        } else {
+          std::cerr << "Skipping pasta_occ, the alphabet has more than 16 "
+                    << "symbols\n";
+        }
+      }},
+      {"sdsl_wm", "sdsl wavelet matrix (wm_int)", true, [&]() {
+        run_structure("sdsl_wm", [&]() {
+          auto sdsl_input = make_sdsl_input();
+          return sdsl::wm_int<>(sdsl_input, sdsl_input.size());
+        });
+      }},
+      // The same wavelet matrix using pasta's rank and select data structures
+      {"sdsl_wm_pasta_flat", "sdsl_wm with pasta::FlatRankSelect", true,
+       [&]() {
+        run_structure("sdsl_wm_pasta_flat", [&]() {
+          auto sdsl_input = make_sdsl_input();
+          return sdsl::wm_int<sdsl::bit_vector, sdsl::rank_support_pasta_flat<>,
+                              sdsl::select_support_pasta_flat<1>,
+                              sdsl::select_support_pasta_flat<0>>(
+              sdsl_input, sdsl_input.size());
+        });
+      }},
+      {"sdsl_wm_pasta_wide", "sdsl_wm with pasta::WideRankSelect", true,
+       [&]() {
+        run_structure("sdsl_wm_pasta_wide", [&]() {
+          auto sdsl_input = make_sdsl_input();
+          return sdsl::wm_int<sdsl::bit_vector, sdsl::rank_support_pasta_wide<>,
+                              sdsl::select_support_pasta_wide<1>,
+                              sdsl::select_support_pasta_wide<0>>(
+              sdsl_input, sdsl_input.size());
+        });
+      }},
+      {"sdsl_huffwt", "sdsl Huffman-shaped wavelet tree", true, [&]() {
+        run_structure("sdsl_huffwt", [&]() {
+          std::string input_clone(input_.begin(), input_.end());
+          sdsl::wt_huff<> sdsl_hwt;
+          construct_im(sdsl_hwt, input_clone, 1);
+          return sdsl_hwt;
+        });
+      }},
+      {"sdsl_huffwt_rrr", "sdsl Huffman-shaped wavelet tree with RRR", true,
+       [&]() {
+        run_structure("sdsl_huffwt_rrr", [&]() {
+          std::string input_clone(input_.begin(), input_.end());
+          sdsl::wt_huff<sdsl::rrr_vector<>> sdsl_hwt;
+          construct_im(sdsl_hwt, input_clone, 1);
+          return sdsl_hwt;
+        });
+      }},
+    };
+  }
 
   void run() {
+    auto const registered = registry();
+    if (list) {
+      for (auto const& structure : registered) {
+        std::cout << structure.name << "\t" << structure.description
+                  << (structure.by_default ? " (default)" : "") << '\n';
+      }
+      return;
+    }
+
+    auto const selected_structures = split(structures);
+    for (auto const& name : selected_structures) {
+      if (name != "default" && name != "all" &&
+          std::none_of(registered.begin(), registered.end(),
+                       [&](auto const& s) { return s.name == name; })) {
+        std::cerr << "Unknown structure " << name << " (see --list)\n";
+        exit(1);
+      }
+    }
+    for (auto const& name : split(experiments)) {
+      if (name != "latency" && name != "throughput" &&
+          name != "tail_latency" && name != "parallel_throughput" &&
+          name != "mlp" && name != "construction" && name != "allocations") {
+        std::cerr << "Unknown experiment " << name << '\n';
+        exit(1);
+      }
+    }
+    // Exits for an invalid number of chains, before anything is constructed
+    parse_chains(chains);
+    if (sample_rate == 0) {
+      std::cerr << "The sample rate must be at least 1\n";
+      exit(1);
+    }
+    if (!ResultWriter::is_format(format)) {
+      std::cerr << "Unknown format " << format << '\n';
+      exit(1);
+    }
+    writer_.set_format(format);
+
     load_text();
     reduce_alphabet();
 
-    auto const access_queries = generate_queries(number_queries, input_);
-    auto const rank_queries = generate_rank_queries(number_queries, input_);
-    auto const select_queries = generate_select_queries(number_queries, input_);
+    access_queries_ = generate_queries(number_queries, input_);
+    rank_queries_ = generate_rank_queries(number_queries, input_);
+    select_queries_ = generate_select_queries(number_queries, input_);
 
-    std::cout << "rank_queries.size() " << rank_queries.size() << '\n';
+    for (auto const& structure : registered) {
+      if (selected(selected_structures, "all") ||
+          (structure.by_default &&
+           selected(selected_structures, "default")) ||
+          selected(selected_structures, structure.name)) {
+        structure.run();
+      }
+    }
+    writer_.finish();
+  }
     
-    auto pasta_wm = pasta::make_wm<pasta::BitVector>(input_.begin(), input_.end(),
-                                                     alphabet_size_);
+private:
 
-    run_experiments_latency(pasta_wm, access_queries, rank_queries, select_queries,
-			    "pasta_wm", pasta_wm.space_usage());
-    // run_experiments_throughput(pasta_wm, access_queries, rank_queries, select_queries,
-		// 	       "pasta_wm", pasta_wm.space_usage());
+  static std::vector<std::string> split(std::string const& list) {
+    std::vector<std::string> names;
+    std::istringstream stream(list);
+    for (std::string name; std::getline(stream, name, ',');) {
+      if (!name.empty()) {
+        names.push_back(name);
+      }
+    }
+    return names;
+  }
 
+  static bool selected(std::vector<std::string> const& names,
+                       std::string const& name) {
+    return std::find(names.begin(), names.end(), name) != names.end();
+  }
 
+  bool run_experiment(std::string const& name) const {
+    return selected(split(experiments), name);
+  }
+
+  // sdsl's construction consumes its input, hence, each construction uses a
+  // fresh copy
+  sdsl::int_vector<8> make_sdsl_input() const {
     sdsl::int_vector<8> sdsl_input(input_.size(), 0);
     for (size_t i = 0; i < input_.size(); ++i) {
       sdsl_input[i] = input_[i];
     }
-    
-    sdsl::wm_int sdsl_wm(sdsl_input, sdsl_input.size());
-
-    run_experiments_latency(sdsl_wm, access_queries, rank_queries, select_queries,
-		    "sdsl_wm", sdsl::size_in_bytes(sdsl_wm));
-    // run_experiments_throughput(sdsl_wm, access_queries, rank_queries, select_queries,
-		// 	    "sdsl_wm", sdsl::size_in_bytes(sdsl_wm));
-
-    std::string input_clone(input_.begin(), input_.end());
-    sdsl::wt_huff<> sdsl_hwt;
-    construct_im(sdsl_hwt, input_clone, 1);
+    return sdsl_input;
+  }
 
-    run_experiments_latency(sdsl_hwt, access_queries, rank_queries, select_queries,
-		    "sdsl_huffwt", sdsl::size_in_bytes(sdsl_hwt));
-    // run_experiments_throughput(sdsl_hwt, access_queries, rank_queries, select_queries,
-		// 	    "sdsl_huffwt", sdsl::size_in_bytes(sdsl_hwt));
+  template <typename Structure>
+  static size_t space_usage(Structure const& structure) {
+    if constexpr (requires { structure.space_usage(); }) {
+      return structure.space_usage();
+    } else {
+      return sdsl::size_in_bytes(structure);
+    }
+  }
 
-    sdsl::wt_huff<sdsl::rrr_vector<>> sdsl_hwt2;
-    construct_im(sdsl_hwt2, input_clone, 1);
+  // Constructs the data structure (runs times, if the construction is
+  // measured) and runs the selected experiments on the last one. The data
+  // structures are constructed in place, as not all of them can be moved.
+  template <typename Factory>
+  void run_structure(std::string const& name, Factory factory) {
+    bool const construction = run_experiment("construction");
+    size_t const construction_runs = construction ? runs : 1;
+    tlx::Aggregate<size_t> time_construction;
+    for (size_t i = 0; i < construction_runs; ++i) {
+      auto const start = std::chrono::steady_clock::now();
+      auto structure = factory();
+      time_construction.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count());
+      if (i + 1 < construction_runs) {
+        continue;
+      }
 
-    run_experiments_latency(sdsl_hwt2, access_queries, rank_queries, select_queries,
-		    "sdsl_huffwt_rrr", sdsl::size_in_bytes(sdsl_hwt2));
+      size_t const space = space_usage(structure);
+      if (construction) {
+        writer_.write(Record()
+                          .add("algo", name)
+                          .add("exp", "construction")
+                          .add("input", input_path)
+                          .add("n", input_.size())
+                          .add("logn", tlx::integer_log2_ceil(input_.size()))
+                          .add("min_time_ms",
+                               time_construction.min() / 1'000'000.0)
+                          .add("max_time_ms",
+                               time_construction.max() / 1'000'000.0)
+                          .add("avg_time_ms",
+                               time_construction.avg() / 1'000'000.0)
+                          .add("space_in_bytes", space)
+                          .add("space_in_mib", space / 1024.0 / 1024.0)
+                          .add("n_runs", construction_runs));
+      }
+      if (run_experiment("latency")) {
+        run_experiments_latency(structure, access_queries_, rank_queries_,
+                                select_queries_, name, space);
+      }
+      if (run_experiment("tail_latency")) {
+        run_experiments_tail_latency(structure, access_queries_,
+                                     rank_queries_, select_queries_, name,
+                                     space);
+      }
+      if (run_experiment("throughput")) {
+        run_experiments_throughput(structure, access_queries_, rank_queries_,
+                                   select_queries_, name, space);
+      }
+      if (run_experiment("parallel_throughput")) {
+        run_experiments_parallel_throughput(structure, access_queries_,
+                                            rank_queries_, select_queries_,
+                                            name, space);
+      }
+      if (run_experiment("mlp")) {
+        run_experiments_mlp(structure, access_queries_, rank_queries_,
+                            select_queries_, name, space);
+      }
+      if (run_experiment("allocations")) {
+        run_allocation_check(structure, access_queries_, rank_queries_,
+                             select_queries_, name);
+      }
+    }
   }
-    
-private:
 
   void load_text() {
     // Read prefix of file
@@ -157,6 +387,46 @@ private:
     return random_queries;
   }
 
+  // Counts the heap allocations of each query loop, which should be zero,
+  // e.g., to avoid allocator contention when querying from many threads
+  template <typename WaveletMatrix, typename AccessQueries,
+            typename RankQueries, typename SelectQueries>
+  void run_allocation_check(WaveletMatrix& wm, AccessQueries& access_queries,
+                            RankQueries& rank_queries,
+                            SelectQueries& select_queries, std::string name) {
+    size_t result = 0;
+    mem_monitor_.reset();
+    for (size_t i = 0; i < access_queries.size(); ++i) {
+      result += wm[access_queries[i] % prefix_size];
+    }
+    size_t const access_allocations = mem_monitor_.get().number_malloc;
+
+    mem_monitor_.reset();
+    for (size_t i = 0; i < rank_queries.size(); ++i) {
+      result += wm.rank(rank_queries[i].first % prefix_size,
+                        rank_queries[i].second);
+    }
+    size_t const rank_allocations = mem_monitor_.get().number_malloc;
+
+    mem_monitor_.reset();
+    for (size_t i = 0; i < select_queries.size(); ++i) {
+      result += wm.select(select_queries[i].first, select_queries[i].second);
+    }
+    size_t const select_allocations = mem_monitor_.get().number_malloc;
+    PASTA_DO_NOT_OPTIMIZE(result);
+
+    writer_.write(Record()
+                      .add("algo", name)
+                      .add("exp", "heap_allocations")
+                      .add("input", input_path)
+                      .add("n", input_.size())
+                      .add("logn", tlx::integer_log2_ceil(input_.size()))
+                      .add("access_allocations", access_allocations)
+                      .add("rank_allocations", rank_allocations)
+                      .add("select_allocations", select_allocations)
+                      .add("n_queries", access_queries.size()));
+  }
+
   template <typename WaveletMatrix, typename AccessQueries,
 	    typename RankQueries, typename SelectQueries>
   void run_experiments_latency(WaveletMatrix& wm, AccessQueries& access_queries,
@@ -179,7 +449,7 @@ private:
           std::chrono::duration_cast<std::chrono::nanoseconds>(
                        std::chrono::steady_clock::now() - start)
           .count());
-	std::cout << "result " << result << '\n';
+        PASTA_DO_NOT_OPTIMIZE(result);
       }
 
       {
@@ -193,7 +463,7 @@ private:
           std::chrono::duration_cast<std::chrono::nanoseconds>(
                                                                std::chrono::steady_clock::now() - start)
           .count());
-	std::cout << "result " << result << '\n';
+        PASTA_DO_NOT_OPTIMIZE(result);
       }
 
       
@@ -210,49 +480,119 @@ private:
           std::chrono::duration_cast<std::chrono::nanoseconds>(
                                                                std::chrono::steady_clock::now() - start)
           .count());
-	std::cout << "result " << result << '\n';
+        PASTA_DO_NOT_OPTIMIZE(result);
       }
       
     }
 
-    std::cout << "RESULT algo=" << name
-	      << " exp=" << "access_latency"
-	      << " input=" << input_path
-	      << " n=" << input_.size()
-	      << " logn=" << tlx::integer_log2_ceil(input_.size())
-	      << " min_time_ns=" << time_access.min() / access_queries.size()
-	      << " max_time_ns=" << time_access.max() / access_queries.size()
-	      << " avg_time_ns=" << time_access.avg() / access_queries.size()
-	      << " space_in_bytes=" << space
-	      << " space_in_mib=" << (space / 1024.0 / 1024.0)
-	      << " n_queries=" << access_queries.size()
-	      << " n_runs=" << runs << std::endl;
-
-    std::cout << "RESULT algo=" << name
-	      << " exp=" << "rank_latency"
-	      << " input=" << input_path
-	      << " n=" << input_.size()
-	      << " logn=" << tlx::integer_log2_ceil(input_.size())
-	      << " min_time_ns=" << time_rank.min() / rank_queries.size()
-	      << " max_time_ns=" << time_rank.max() / rank_queries.size()
-	      << " avg_time_ns=" << time_rank.avg() / rank_queries.size()
-	      << " space_in_bytes=" << space
-	      << " space_in_mib=" << (space / 1024.0 / 1024.0)
-	      << " n_queries=" << rank_queries.size()
-	      << " n_runs=" << runs << std::endl;;
-
-    std::cout << "RESULT algo=" << name
-	      << " exp=" << "select_latency"
-	      << " input=" << input_path
-	      << " n=" << input_.size()
-	      << " logn=" << tlx::integer_log2_ceil(input_.size())
-	      << " min_time_ns=" << time_select.min() / select_queries.size()
-	      << " max_time_ns=" << time_select.max() / select_queries.size()
-	      << " avg_time_ns=" << time_select.avg() / select_queries.size()
-	      << " space_in_bytes=" << space
-	      << " space_in_mib=" << (space / 1024.0 / 1024.0)
-	      << " n_queries=" << select_queries.size()
-	      << " n_runs=" << runs << std::endl;
+    writer_.write(Record()
+                      .add("algo", name)
+                      .add("exp", "access_latency")
+                      .add("input", input_path)
+                      .add("n", input_.size())
+                      .add("logn", tlx::integer_log2_ceil(input_.size()))
+                      .add("min_time_ns", time_access.min() / access_queries.size())
+                      .add("max_time_ns", time_access.max() / access_queries.size())
+                      .add("avg_time_ns", time_access.avg() / access_queries.size())
+                      .add("space_in_bytes", space)
+                      .add("space_in_mib", (space / 1024.0 / 1024.0))
+                      .add("n_queries", access_queries.size())
+                      .add("n_runs", runs));
+
+    writer_.write(Record()
+                      .add("algo", name)
+                      .add("exp", "rank_latency")
+                      .add("input", input_path)
+                      .add("n", input_.size())
+                      .add("logn", tlx::integer_log2_ceil(input_.size()))
+                      .add("min_time_ns", time_rank.min() / rank_queries.size())
+                      .add("max_time_ns", time_rank.max() / rank_queries.size())
+                      .add("avg_time_ns", time_rank.avg() / rank_queries.size())
+                      .add("space_in_bytes", space)
+                      .add("space_in_mib", (space / 1024.0 / 1024.0))
+                      .add("n_queries", rank_queries.size())
+                      .add("n_runs", runs));
+
+    writer_.write(Record()
+                      .add("algo", name)
+                      .add("exp", "select_latency")
+                      .add("input", input_path)
+                      .add("n", input_.size())
+                      .add("logn", tlx::integer_log2_ceil(input_.size()))
+                      .add("min_time_ns", time_select.min() / select_queries.size())
+                      .add("max_time_ns", time_select.max() / select_queries.size())
+                      .add("avg_time_ns", time_select.avg() / select_queries.size())
+                      .add("space_in_bytes", space)
+                      .add("space_in_mib", (space / 1024.0 / 1024.0))
+                      .add("n_queries", select_queries.size())
+                      .add("n_runs", runs));
+  }
+
+  // The latency experiment only reports the average latency of the loop.
+  // Here, the same chained queries are answered, but every sample_rate-th
+  // query is timed individually (see QueryTimer) and its latency is added to
+  // a histogram, which gives the percentiles of the latency over all runs.
+  template <typename WaveletMatrix, typename AccessQueries,
+            typename RankQueries, typename SelectQueries>
+  void run_experiments_tail_latency(WaveletMatrix& wm,
+                                    AccessQueries& access_queries,
+                                    RankQueries& rank_queries,
+                                    SelectQueries& select_queries,
+                                    std::string name, size_t space) {
+    QueryTimer const timer;
+    LatencyHistogram histogram_access;
+    LatencyHistogram histogram_rank;
+    LatencyHistogram histogram_select;
+    size_t result = 0;
+    for (size_t i = 0; i < runs; ++i) {
+      result += sample_latencies(
+          access_queries, sample_rate, timer, histogram_access,
+          [&](auto const& query, size_t const previous) {
+            return size_t{wm[(query * (previous + 42)) % prefix_size]};
+          });
+      result += sample_latencies(
+          rank_queries, sample_rate, timer, histogram_rank,
+          [&](auto const& query, size_t const previous) {
+            return size_t{wm.rank((query.first + previous) % prefix_size,
+                                  query.second)};
+          });
+      result += sample_latencies(
+          select_queries, sample_rate, timer, histogram_select,
+          [&](auto const& query, size_t const previous) {
+            size_t const rank =
+                std::max(size_t{1}, query.first - 1 + (previous % 2));
+            return size_t{wm.select(rank, query.second)};
+          });
+    }
+    PASTA_DO_NOT_OPTIMIZE(result);
+
+    for (auto const& [exp, histogram, n_queries] :
+         {std::make_tuple("access_tail_latency", &histogram_access,
+                          access_queries.size()),
+          std::make_tuple("rank_tail_latency", &histogram_rank,
+                          rank_queries.size()),
+          std::make_tuple("select_tail_latency", &histogram_select,
+                          select_queries.size())}) {
+      writer_.write(Record()
+                        .add("algo", name)
+                        .add("exp", exp)
+                        .add("input", input_path)
+                        .add("n", input_.size())
+                        .add("logn", tlx::integer_log2_ceil(input_.size()))
+                        .add("timer", std::string(QueryTimer::name()))
+                        .add("timer_overhead_ns", timer.overhead_ns())
+                        .add("p50_ns", histogram->percentile(0.5))
+                        .add("p90_ns", histogram->percentile(0.9))
+                        .add("p99_ns", histogram->percentile(0.99))
+                        .add("p999_ns", histogram->percentile(0.999))
+                        .add("max_ns", histogram->max())
+                        .add("space_in_bytes", space)
+                        .add("space_in_mib", space / 1024.0 / 1024.0)
+                        .add("n_samples", histogram->count())
+                        .add("sample_rate", sample_rate)
+                        .add("n_queries", n_queries)
+                        .add("n_runs", runs));
+    }
   }
 
   template <typename WaveletMatrix, typename AccessQueries,
@@ -269,14 +609,14 @@ private:
         size_t result = 0;
         auto const start = std::chrono::steady_clock::now();
         for (size_t i = 0; i < access_queries.size(); ++i) {
-          result += wm[access_queries[i]];
+          result += wm[access_queries[i] % prefix_size];
         }
 
         time_access.add(
           std::chrono::duration_cast<std::chrono::nanoseconds>(
                        std::chrono::steady_clock::now() - start)
           .count());
-	std::cout << "result " << result << '\n';
+        PASTA_DO_NOT_OPTIMIZE(result);
       }
 
       {
@@ -289,14 +629,14 @@ private:
           std::chrono::duration_cast<std::chrono::nanoseconds>(
                                                                std::chrono::steady_clock::now() - start)
           .count());
-	std::cout << "result " << result << '\n';
+        PASTA_DO_NOT_OPTIMIZE(result);
       }
 
       
       {
         size_t result = 0;
         auto const start = std::chrono::steady_clock::now();
-        for (size_t i = 0; i < rank_queries.size(); ++i) {
+        for (size_t i = 0; i < select_queries.size(); ++i) {
           result += wm.select(select_queries[i].first, select_queries[i].second);
         }
         
@@ -304,52 +644,204 @@ private:
           std::chrono::duration_cast<std::chrono::nanoseconds>(
                                                                std::chrono::steady_clock::now() - start)
           .count());
-	std::cout << "result " << result << '\n';
+        PASTA_DO_NOT_OPTIMIZE(result);
       }
       
     }
 
-    std::cout << "RESULT algo=" << name
-	      << " exp=" << "access_throughput"
-	      << " input=" << input_path
-	      << " n=" << input_.size()
-	      << " logn=" << tlx::integer_log2_ceil(input_.size())
-	      << " min_throughput_ms=" << access_queries.size() / (time_access.max() / 1000.0 / 1000.0)
-	      << " max_throughput_ms=" << access_queries.size() / (time_access.min() / 1000.0 / 1000.0)
-	      << " avg_throughput_ms=" << access_queries.size() / (time_access.avg() / 1000.0 / 1000.0)
-	      << " space_in_bytes=" << space
-	      << " space_in_mib=" << (space / 1024.0 / 1024.0)
-	      << " n_queries=" << access_queries.size()
-	      << " n_runs=" << runs << std::endl;
-
-    std::cout << "RESULT algo=" << name
-	      << " exp=" << "rank_throughput"
-	      << " input=" << input_path
-	      << " n=" << input_.size()
-	      << " logn=" << tlx::integer_log2_ceil(input_.size())
-	      << " min_throughput_ms=" << rank_queries.size() / (time_rank.max() / 1000.0 / 1000.0)
-	      << " max_throughput_ms=" << rank_queries.size() / (time_rank.min() / 1000.0 / 1000.0)
-	      << " avg_throughput_ms=" << rank_queries.size() / (time_rank.avg() / 1000.0 / 1000.0)
-	      << " space_in_bytes=" << space
-	      << " space_in_mib=" << (space / 1024.0 / 1024.0)
-	      << " n_queries=" << rank_queries.size()
-	      << " n_runs=" << runs << std::endl;;
-
-    std::cout << "RESULT algo=" << name
-	      << " exp=" << "select_throughput"
-	      << " input=" << input_path
-	      << " n=" << input_.size()
-	      << " logn=" << tlx::integer_log2_ceil(input_.size())
-	      << " min_throughput_ms=" << select_queries.size() / (time_select.max() / 1000.0 / 1000.0)
-	      << " max_throughput_ms=" << select_queries.size() / (time_select.min() / 1000.0 / 1000.0)
-	      << " avg_throughput_ms=" << select_queries.size() / (time_select.avg() / 1000.0 / 1000.0)
-	      << " space_in_bytes=" << space
-	      << " space_in_mib=" << (space / 1024.0 / 1024.0)
-	      << " n_queries=" << select_queries.size()
-	      << " n_runs=" << runs << std::endl;    
+    writer_.write(Record()
+                      .add("algo", name)
+                      .add("exp", "access_throughput")
+                      .add("input", input_path)
+                      .add("n", input_.size())
+                      .add("logn", tlx::integer_log2_ceil(input_.size()))
+                      .add("min_throughput_ms", access_queries.size() / (time_access.max() / 1000.0 / 1000.0))
+                      .add("max_throughput_ms", access_queries.size() / (time_access.min() / 1000.0 / 1000.0))
+                      .add("avg_throughput_ms", access_queries.size() / (time_access.avg() / 1000.0 / 1000.0))
+                      .add("space_in_bytes", space)
+                      .add("space_in_mib", (space / 1024.0 / 1024.0))
+                      .add("n_queries", access_queries.size())
+                      .add("n_runs", runs));
+
+    writer_.write(Record()
+                      .add("algo", name)
+                      .add("exp", "rank_throughput")
+                      .add("input", input_path)
+                      .add("n", input_.size())
+                      .add("logn", tlx::integer_log2_ceil(input_.size()))
+                      .add("min_throughput_ms", rank_queries.size() / (time_rank.max() / 1000.0 / 1000.0))
+                      .add("max_throughput_ms", rank_queries.size() / (time_rank.min() / 1000.0 / 1000.0))
+                      .add("avg_throughput_ms", rank_queries.size() / (time_rank.avg() / 1000.0 / 1000.0))
+                      .add("space_in_bytes", space)
+                      .add("space_in_mib", (space / 1024.0 / 1024.0))
+                      .add("n_queries", rank_queries.size())
+                      .add("n_runs", runs));
+
+    writer_.write(Record()
+                      .add("algo", name)
+                      .add("exp", "select_throughput")
+                      .add("input", input_path)
+                      .add("n", input_.size())
+                      .add("logn", tlx::integer_log2_ceil(input_.size()))
+                      .add("min_throughput_ms", select_queries.size() / (time_select.max() / 1000.0 / 1000.0))
+                      .add("max_throughput_ms", select_queries.size() / (time_select.min() / 1000.0 / 1000.0))
+                      .add("avg_throughput_ms", select_queries.size() / (time_select.avg() / 1000.0 / 1000.0))
+                      .add("space_in_bytes", space)
+                      .add("space_in_mib", (space / 1024.0 / 1024.0))
+                      .add("n_queries", select_queries.size())
+                      .add("n_runs", runs));    
+  }
+
+
+  // Between the latency (one dependency chain) and the throughput (no
+  // dependencies) experiments: The queries are answered in k interleaved
+  // dependency chains (see run_dependency_chains), each chaining its queries
+  // as the latency experiment does. The time per query for increasing k
+  // shows how much memory-level parallelism the data structure can exploit,
+  // i.e., how much batching or prefetching the queries would pay off.
+  template <typename WaveletMatrix, typename AccessQueries,
+            typename RankQueries, typename SelectQueries>
+  void run_experiments_mlp(WaveletMatrix& wm, AccessQueries& access_queries,
+                           RankQueries& rank_queries,
+                           SelectQueries& select_queries, std::string name,
+                           size_t space) {
+    for (size_t const k : parse_chains(chains)) {
+      tlx::Aggregate<size_t> time_access;
+      tlx::Aggregate<size_t> time_rank;
+      tlx::Aggregate<size_t> time_select;
+      size_t result = 0;
+      for (size_t i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        result += run_dependency_chains(
+            k, access_queries, [&](auto const& query, size_t const previous) {
+              return size_t{wm[(query * (previous + 42)) % prefix_size]};
+            });
+        time_access.add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start)
+                            .count());
+
+        start = std::chrono::steady_clock::now();
+        result += run_dependency_chains(
+            k, rank_queries, [&](auto const& query, size_t const previous) {
+              return size_t{wm.rank((query.first + previous) % prefix_size,
+                                    query.second)};
+            });
+        time_rank.add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - start)
+                          .count());
+
+        start = std::chrono::steady_clock::now();
+        result += run_dependency_chains(
+            k, select_queries, [&](auto const& query, size_t const previous) {
+              size_t const rank =
+                  std::max(size_t{1}, query.first - 1 + (previous % 2));
+              return size_t{wm.select(rank, query.second)};
+            });
+        time_select.add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start)
+                            .count());
+      }
+      PASTA_DO_NOT_OPTIMIZE(result);
+
+      for (auto const& [exp, time, n_queries] :
+           {std::make_tuple("access_mlp", &time_access, access_queries.size()),
+            std::make_tuple("rank_mlp", &time_rank, rank_queries.size()),
+            std::make_tuple("select_mlp", &time_select,
+                            select_queries.size())}) {
+        writer_.write(Record()
+                          .add("algo", name)
+                          .add("exp", exp)
+                          .add("input", input_path)
+                          .add("n", input_.size())
+                          .add("logn", tlx::integer_log2_ceil(input_.size()))
+                          .add("chains", k)
+                          .add("min_time_ns", time->min() / double(n_queries))
+                          .add("max_time_ns", time->max() / double(n_queries))
+                          .add("avg_time_ns", time->avg() / double(n_queries))
+                          .add("space_in_bytes", space)
+                          .add("space_in_mib", space / 1024.0 / 1024.0)
+                          .add("n_queries", n_queries)
+                          .add("n_runs", runs));
+      }
+    }
+  }
+
+  // Each thread answers all queries, starting at a different query (see
+  // for_each_query_from), on the same data structure. The throughput is the
+  // number of queries answered by all threads per second. Plotting it for
+  // the different thread counts shows where the memory bandwidth saturates.
+  template <typename WaveletMatrix, typename AccessQueries,
+            typename RankQueries, typename SelectQueries>
+  void run_experiments_parallel_throughput(WaveletMatrix& wm,
+                                           AccessQueries& access_queries,
+                                           RankQueries& rank_queries,
+                                           SelectQueries& select_queries,
+                                           std::string name, size_t space) {
+    for (size_t const threads : parse_thread_counts(thread_counts)) {
+      std::vector<ThreadResult> results(threads);
+      tlx::Aggregate<size_t> time_access;
+      tlx::Aggregate<size_t> time_rank;
+      tlx::Aggregate<size_t> time_select;
+      for (size_t i = 0; i < runs; ++i) {
+        time_access.add(run_pinned_threads(threads, [&](size_t const thread) {
+          size_t result = 0;
+          for_each_query_from(access_queries,
+                              thread * access_queries.size() / threads,
+                              [&](auto const& query) {
+                                result += wm[query % prefix_size];
+                              });
+          results[thread].value += result;
+        }));
+        time_rank.add(run_pinned_threads(threads, [&](size_t const thread) {
+          size_t result = 0;
+          for_each_query_from(rank_queries,
+                              thread * rank_queries.size() / threads,
+                              [&](auto const& query) {
+                                result += wm.rank(query.first, query.second);
+                              });
+          results[thread].value += result;
+        }));
+        time_select.add(run_pinned_threads(threads, [&](size_t const thread) {
+          size_t result = 0;
+          for_each_query_from(select_queries,
+                              thread * select_queries.size() / threads,
+                              [&](auto const& query) {
+                                result += wm.select(query.first, query.second);
+                              });
+          results[thread].value += result;
+        }));
+      }
+      PASTA_DO_NOT_OPTIMIZE(results);
+
+      for (auto const& [exp, time, n_queries] :
+           {std::make_tuple("access_parallel_throughput", &time_access,
+                            access_queries.size()),
+            std::make_tuple("rank_parallel_throughput", &time_rank,
+                            rank_queries.size()),
+            std::make_tuple("select_parallel_throughput", &time_select,
+                            select_queries.size())}) {
+        double const total_queries = static_cast<double>(n_queries) * threads;
+        writer_.write(Record()
+                          .add("algo", name)
+                          .add("exp", exp)
+                          .add("input", input_path)
+                          .add("n", input_.size())
+                          .add("logn", tlx::integer_log2_ceil(input_.size()))
+                          .add("threads", threads)
+                          .add("min_queries_per_s",
+                               total_queries / (time->max() / 1e9))
+                          .add("max_queries_per_s",
+                               total_queries / (time->min() / 1e9))
+                          .add("avg_queries_per_s",
+                               total_queries / (time->avg() / 1e9))
+                          .add("space_in_bytes", space)
+                          .add("space_in_mib", space / 1024.0 / 1024.0)
+                          .add("n_queries", n_queries)
+                          .add("n_runs", runs));
+      }
+    }
   }
 
-  
 }; // class Benchmark
 
 
@@ -360,7 +852,7 @@ tlx::CmdlineParser cp;
 
   Benchmark bench;
 
-  cp.add_param_string("input", bench.input_path, "Path to input file.");
+  cp.add_opt_param_string("input", bench.input_path, "Path to input file.");
   cp.add_bytes('n', "size", bench.prefix_size,
                "Size (in bytes unless stated "
                "otherwise) of the string that use to test our suffix array "
@@ -369,6 +861,31 @@ tlx::CmdlineParser cp;
                "Number of queries tested. "
                "Default is 10'000'000.");
   cp.add_bytes('r', "runs", bench.runs, "Number of runs the benchmark is executed.");
+  cp.add_string('s', "structures", bench.structures,
+                "Comma-separated list of data structures (see --list), "
+                "\"default\", or \"all\". Default is \"default\".");
+  cp.add_string('e', "experiments", bench.experiments,
+                "Comma-separated list of experiments: latency, "
+                "tail_latency, throughput, parallel_throughput, mlp, "
+                "construction, allocations. Default is "
+                "\"latency,allocations\".");
+  cp.add_bytes('S', "sample_rate", bench.sample_rate,
+               "Every this many queries, one query is timed individually by "
+               "tail_latency. Default is 100.");
+  cp.add_string('t', "threads", bench.thread_counts,
+                "Comma-separated list of thread counts used by "
+                "parallel_throughput. Default are all powers of two less "
+                "than the number of hardware threads and the number of "
+                "hardware threads.");
+  cp.add_string('k', "chains", bench.chains,
+                "Comma-separated list of numbers of independent dependency "
+                "chains (at most 32) used by mlp. Default is "
+                "\"1,2,4,8,16,32\".");
+  cp.add_string('f', "format", bench.format,
+                "Output format: text (RESULT lines), json (one object per "
+                "line), or csv. Default is text.");
+  cp.add_flag('l', "list", bench.list,
+              "List all data structures and exit.");
 
   if (!cp.process(argc, argv)) {
     return -1;
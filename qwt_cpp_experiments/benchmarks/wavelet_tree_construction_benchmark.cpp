@@ -10,7 +10,12 @@
 #include <tlx/math.hpp>
 
 #include <pasta/utils/benchmark/do_not_optimize.hpp>
+#include <pasta/utils/benchmark/memory_monitor.hpp>
 #include <pasta/utils/reduce_alphabet.hpp>
+#include <pasta/wavelet_tree/level_wise_construction.hpp>
+#include <pasta/wavelet_tree/mapped_text.hpp>
+#include <pasta/wavelet_tree/packed_span.hpp>
+#include <pasta/wavelet_tree/semi_external_construction.hpp>
 #include <pasta/wavelet_tree/wavelet_tree.hpp>
 
 #include <sdsl/int_vector.hpp>
@@ -29,21 +34,27 @@ class Benchmark
 
 private:
   std::vector<uint8_t> input_;
+  pasta::MemoryMonitor& mem_monitor_ = pasta::MemoryMonitor::instance();
 
 public:
   size_t alphabet_size_;
   size_t prefix_size = {0};
   std::string input_path = "";
   size_t runs = 5;
+  size_t memory_budget = 64 * 1024 * 1024;
+  std::string tmp_dir = ".";
 
   void run()
   {
     load_text();
     reduce_alphabet();
 
+    // The peak memory usage includes the text (the clone)
     tlx::Aggregate<size_t> pasta_construction_time;
+    tlx::Aggregate<size_t> pasta_construction_peak;
     for (size_t i = 0; i < runs; ++i)
     {
+      mem_monitor_.reset();
       std::vector<uint8_t> v_clone = input_;
       auto const start = std::chrono::steady_clock::now();
       auto pasta_wm = pasta::make_wm<pasta::BitVector>(v_clone.begin(), v_clone.end(),
@@ -52,6 +63,7 @@ public:
           std::chrono::duration_cast<std::chrono::milliseconds>(
               std::chrono::steady_clock::now() - start)
               .count());
+      pasta_construction_peak.add(mem_monitor_.get().peak);
       // std::cout << "pasta_wm[0] " << pasta_wm[0] << '\n';
     }
     std::cout << "RESULT algo=pasta_construction"
@@ -61,34 +73,82 @@ public:
               << " min_construction_time_ms=" << pasta_construction_time.min()
               << " max_construction_time_ms=" << pasta_construction_time.max()
               << " avg_construction_time_ms=" << pasta_construction_time.avg()
+              << " peak_memory_bytes=" << pasta_construction_peak.max()
               << " n_runs=" << runs << std::endl;
 
-    tlx::Aggregate<size_t> sdsl_construction_time;
+    tlx::Aggregate<size_t> consuming_construction_time;
+    tlx::Aggregate<size_t> consuming_construction_peak;
     for (size_t i = 0; i < runs; ++i)
     {
-      sdsl::int_vector<8> sdsl_input(input_.size(), 0);
-      for (size_t j = 0; j < input_.size(); ++j)
-      {
-        sdsl_input[j] = input_[j];
-      }
+      mem_monitor_.reset();
+      std::vector<uint8_t> v_clone = input_;
       auto const start = std::chrono::steady_clock::now();
-      sdsl::wm_int sdsl_wm(sdsl_input, sdsl_input.size());
+      auto pasta_wm = pasta::make_wm<pasta::BitVector>(std::move(v_clone),
+                                                       alphabet_size_);
+      consuming_construction_time.add(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count());
+      consuming_construction_peak.add(mem_monitor_.get().peak);
+    }
+    std::cout << "RESULT algo=pasta_consuming_construction"
+              << " input=" << input_path
+              << " n=" << input_.size()
+              << " logn=" << tlx::integer_log2_ceil(input_.size())
+              << " min_construction_time_ms=" << consuming_construction_time.min()
+              << " max_construction_time_ms=" << consuming_construction_time.max()
+              << " avg_construction_time_ms=" << consuming_construction_time.avg()
+              << " peak_memory_bytes=" << consuming_construction_peak.max()
+              << " n_runs=" << runs << std::endl;
+
+    run_time_to_index();
+    run_prefix_counting<false>();
+    run_prefix_counting<true>();
+    run_level_wise_construction(pasta::LevelWiseKernels::SCALAR);
+    if (pasta::level_wise_simd_supported())
+    {
+      run_level_wise_construction(pasta::LevelWiseKernels::AUTO);
+    }
 
-      sdsl_construction_time.add(
+    // The text is read from the file again, i.e., it is never kept in memory
+    tlx::Aggregate<size_t> semi_external_construction_time;
+    tlx::Aggregate<size_t> semi_external_construction_peak;
+    for (size_t i = 0; i < runs; ++i)
+    {
+      mem_monitor_.reset();
+      auto const start = std::chrono::steady_clock::now();
+      auto pasta_wm = pasta::make_wm_semi_external<pasta::BitVector>(
+          input_path, memory_budget, prefix_size);
+      semi_external_construction_time.add(
           std::chrono::duration_cast<std::chrono::milliseconds>(
               std::chrono::steady_clock::now() - start)
               .count());
-      // std::cout << "sdsl_wm[0] " << sdsl_wm[0] << '\n';
+      semi_external_construction_peak.add(mem_monitor_.get().peak);
     }
-    std::cout << "RESULT algo=sdsl_construction"
+    std::cout << "RESULT algo=pasta_semi_external_construction"
               << " input=" << input_path
               << " n=" << input_.size()
               << " logn=" << tlx::integer_log2_ceil(input_.size())
-              << " min_construction_time_ms=" << sdsl_construction_time.min()
-              << " max_construction_time_ms=" << sdsl_construction_time.max()
-              << " avg_construction_time_ms=" << sdsl_construction_time.avg()
+              << " min_construction_time_ms=" << semi_external_construction_time.min()
+              << " max_construction_time_ms=" << semi_external_construction_time.max()
+              << " avg_construction_time_ms=" << semi_external_construction_time.avg()
+              << " memory_budget=" << memory_budget
+              << " peak_memory_bytes=" << semi_external_construction_peak.max()
               << " n_runs=" << runs << std::endl;
 
+    // Texts with small alphabets can be indexed without unpacking them
+    if (alphabet_size_ <= 4)
+    {
+      run_packed_construction<2>();
+    }
+    else if (alphabet_size_ <= 16)
+    {
+      run_packed_construction<4>();
+    }
+
+    run_sdsl_construction("");
+    run_sdsl_construction(tmp_dir);
+
     tlx::Aggregate<size_t> sdsl_hwt_construction_time;
     for (size_t i = 0; i < runs; ++i)
     {
@@ -113,6 +173,175 @@ public:
               << " n_runs=" << runs << std::endl;
   }
 
+private:
+  // Time from the file on disk to the wavelet matrix of the text over its
+  // effective alphabet (the file is in the page cache after the first run)
+  void run_time_to_index()
+  {
+    tlx::Aggregate<size_t> ifstream_time;
+    tlx::Aggregate<size_t> mmap_time;
+    for (size_t i = 0; i < runs; ++i)
+    {
+      auto start = std::chrono::steady_clock::now();
+      {
+        std::vector<uint8_t> text(prefix_size);
+        std::ifstream stream(input_path.c_str(), std::ios::in | std::ios::binary);
+        stream.read(reinterpret_cast<char *>(text.data()), prefix_size);
+        size_t const alphabet_size =
+            pasta::reduce_alphabet(text.begin(), text.end());
+        auto pasta_wm = pasta::make_wm<pasta::BitVector>(text.begin(), text.end(),
+                                                         alphabet_size);
+        PASTA_DO_NOT_OPTIMIZE(pasta_wm);
+      }
+      ifstream_time.add(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count());
+
+      start = std::chrono::steady_clock::now();
+      {
+        pasta::MappedText const text(input_path, prefix_size);
+        auto pasta_wm = pasta::make_wm<pasta::BitVector>(text);
+        PASTA_DO_NOT_OPTIMIZE(pasta_wm);
+      }
+      mmap_time.add(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count());
+    }
+    for (auto const& [loader, time] : {std::pair{"ifstream", ifstream_time},
+                                       std::pair{"mmap", mmap_time}})
+    {
+      std::cout << "RESULT algo=pasta_time_to_index"
+                << " loader=" << loader
+                << " input=" << input_path
+                << " n=" << input_.size()
+                << " logn=" << tlx::integer_log2_ceil(input_.size())
+                << " min_construction_time_ms=" << time.min()
+                << " max_construction_time_ms=" << time.max()
+                << " avg_construction_time_ms=" << time.avg()
+                << " n_runs=" << runs << std::endl;
+    }
+  }
+
+  // Only the levels are computed (without rank and select support) to compare
+  // scattering the bits directly and buffering them per bit prefix
+  template <bool BufferedScatter>
+  void run_prefix_counting()
+  {
+    size_t const levels = tlx::integer_log2_ceil(alphabet_size_);
+    tlx::Aggregate<size_t> construction_time;
+    for (size_t i = 0; i < runs; ++i)
+    {
+      pasta::BitVector bv(input_.size() * levels, 0);
+      auto const start = std::chrono::steady_clock::now();
+      pasta::prefix_counting<pasta::WaveletTypes::MATRIX, BufferedScatter>(
+          input_.begin(), input_.end(), levels, bv);
+      construction_time.add(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count());
+      PASTA_DO_NOT_OPTIMIZE(bv);
+    }
+    std::cout << "RESULT algo=pasta_prefix_counting"
+              << " scatter=" << (BufferedScatter ? "buffered" : "direct")
+              << " input=" << input_path
+              << " n=" << input_.size()
+              << " logn=" << tlx::integer_log2_ceil(input_.size())
+              << " min_construction_time_ms=" << construction_time.min()
+              << " max_construction_time_ms=" << construction_time.max()
+              << " avg_construction_time_ms=" << construction_time.avg()
+              << " n_runs=" << runs << std::endl;
+  }
+
+  void run_level_wise_construction(pasta::LevelWiseKernels const kernels)
+  {
+    tlx::Aggregate<size_t> construction_time;
+    for (size_t i = 0; i < runs; ++i)
+    {
+      auto const start = std::chrono::steady_clock::now();
+      auto pasta_wm = pasta::make_wm_level_wise<pasta::BitVector>(
+          input_, alphabet_size_, kernels);
+      construction_time.add(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count());
+    }
+    std::cout << "RESULT algo=pasta_level_wise_construction"
+              << " kernels="
+              << (kernels == pasta::LevelWiseKernels::SCALAR ? "scalar"
+                                                             : "avx2_bmi2")
+              << " input=" << input_path
+              << " n=" << input_.size()
+              << " logn=" << tlx::integer_log2_ceil(input_.size())
+              << " min_construction_time_ms=" << construction_time.min()
+              << " max_construction_time_ms=" << construction_time.max()
+              << " avg_construction_time_ms=" << construction_time.avg()
+              << " n_runs=" << runs << std::endl;
+  }
+
+  // An empty temporary directory results in the in-memory construction
+  void run_sdsl_construction(std::string const& dir)
+  {
+    tlx::Aggregate<size_t> construction_time;
+    for (size_t i = 0; i < runs; ++i)
+    {
+      sdsl::int_vector<8> sdsl_input(input_.size(), 0);
+      for (size_t j = 0; j < input_.size(); ++j)
+      {
+        sdsl_input[j] = input_[j];
+      }
+      auto const start = std::chrono::steady_clock::now();
+      sdsl::wm_int sdsl_wm(sdsl_input, sdsl_input.size(), 0, dir);
+
+      construction_time.add(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count());
+    }
+    std::cout << "RESULT algo="
+              << (dir.empty() ? "sdsl_construction"
+                              : "sdsl_semi_external_construction")
+              << " input=" << input_path
+              << " n=" << input_.size()
+              << " logn=" << tlx::integer_log2_ceil(input_.size())
+              << " min_construction_time_ms=" << construction_time.min()
+              << " max_construction_time_ms=" << construction_time.max()
+              << " avg_construction_time_ms=" << construction_time.avg()
+              << " n_runs=" << runs << std::endl;
+  }
+
+  template <size_t BitsPerSymbol>
+  void run_packed_construction()
+  {
+    // The packed text is the input, i.e., packing is not measured.
+    std::vector<uint64_t> const packed =
+        pasta::pack_symbols<BitsPerSymbol>(input_.begin(), input_.end());
+    pasta::PackedSpan<BitsPerSymbol> const span(packed, input_.size());
+
+    tlx::Aggregate<size_t> construction_time;
+    for (size_t i = 0; i < runs; ++i)
+    {
+      auto const start = std::chrono::steady_clock::now();
+      auto pasta_wm = pasta::make_wm<pasta::BitVector>(span, alphabet_size_);
+      construction_time.add(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count());
+    }
+    std::cout << "RESULT algo=pasta_packed_construction"
+              << " bits_per_symbol=" << BitsPerSymbol
+              << " input=" << input_path
+              << " n=" << input_.size()
+              << " logn=" << tlx::integer_log2_ceil(input_.size())
+              << " min_construction_time_ms=" << construction_time.min()
+              << " max_construction_time_ms=" << construction_time.max()
+              << " avg_construction_time_ms=" << construction_time.avg()
+              << " input_bytes=" << (packed.size() * sizeof(uint64_t))
+              << " unpacked_input_bytes=" << input_.size()
+              << " n_runs=" << runs << std::endl;
+  }
+
 private:
   void
   load_text()
@@ -158,6 +387,12 @@ int32_t main(int argc, char *argv[])
                "otherwise) of the string that use to test our suffix array "
                "construction algorithms.");
   cp.add_bytes('r', "runs", bench.runs, "Number of runs the benchmark is executed.");
+  cp.add_bytes('m', "memory_budget", bench.memory_budget,
+               "Number of bytes used to buffer the text during the "
+               "semi-external construction (default 64 MiB).");
+  cp.add_string('t', "tmp_dir", bench.tmp_dir,
+                "Directory for the temporary files of the semi-external "
+                "sdsl construction (default current directory).");
 
   if (!cp.process(argc, argv))
   {
@@ -0,0 +1,509 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <tlx/cmdline_parser.hpp>
+#include <tlx/math.hpp>
+
+#include <pasta/utils/benchmark/do_not_optimize.hpp>
+#include <pasta/utils/reduce_alphabet.hpp>
+#include <pasta/wavelet_tree/wavelet_tree.hpp>
+
+struct RangeQuery {
+  size_t start;
+  size_t end;
+  uint8_t lower;
+  uint8_t upper;
+}; // struct RangeQuery
+
+class Benchmark {
+
+private:
+  std::vector<uint8_t> input_;
+  size_t alphabet_size_;
+
+public:
+
+  size_t prefix_size = {0};
+  std::string input_path = "";
+  size_t number_queries = 1'000'000;
+  size_t range_width = 1024;
+  size_t top_k = 10;
+  size_t extract_symbols = 64 * 1024 * 1024;
+  size_t runs = 10;
+
+  void run() {
+    load_text();
+    reduce_alphabet();
+
+    auto const queries = generate_range_queries(number_queries, input_);
+
+    auto pasta_wm = pasta::make_wm<pasta::BitVector>(input_.begin(), input_.end(),
+                                                     alphabet_size_);
+    run_experiments_latency(pasta_wm, queries, "pasta_wm",
+                            pasta_wm.space_usage());
+
+    auto pasta_wt = pasta::make_wt<pasta::BitVector>(input_.begin(), input_.end(),
+                                                     alphabet_size_);
+    run_experiments_latency(pasta_wt, queries, "pasta_wt",
+                            pasta_wt.space_usage());
+  }
+
+private:
+
+  void load_text() {
+    // Read prefix of file
+    std::ifstream stream(input_path.c_str(), std::ios::in | std::ios::binary);
+    if (!stream) {
+      std::cerr << "File " << input_path << " not found\n";
+      exit(1);
+    }
+    stream.seekg(0, std::ios::end);
+    uint64_t size = stream.tellg();
+    if (prefix_size > 0) {
+      size = std::min(prefix_size, size);
+    }
+    prefix_size = size;
+    stream.seekg(0);
+    input_.resize(size);
+    stream.read(reinterpret_cast<char *>(input_.data()), size);
+    stream.close();
+  }
+
+  void reduce_alphabet() {
+    // Compute effective alphabet and effective alphabet size
+    alphabet_size_ = pasta::reduce_alphabet(input_.begin(), input_.end());
+  }
+
+  std::vector<RangeQuery> generate_range_queries(size_t const number_queries,
+                                                 std::vector<uint8_t> const& input) {
+    std::random_device rnd_device;
+    std::mt19937 mersenne_engine(rnd_device());
+    size_t const width = std::max(size_t{1}, std::min(range_width, input.size()));
+    std::uniform_int_distribution<uint64_t> dist(0, input.size() - width);
+    std::uniform_int_distribution<uint64_t> symbol_dist(0, input.size() - 1);
+
+    std::vector<RangeQuery> random_queries(number_queries);
+    for (size_t i = 0; i < number_queries; ++i) {
+      size_t const start = dist(mersenne_engine);
+      uint8_t const a = input[symbol_dist(mersenne_engine)];
+      uint8_t const b = input[symbol_dist(mersenne_engine)];
+      random_queries[i] = RangeQuery{start, start + width,
+                                     std::min(a, b), std::max(a, b)};
+    }
+    return random_queries;
+  }
+
+  void print_result(std::string const& name, std::string const& exp,
+                    tlx::Aggregate<size_t> const& time, size_t const n_queries,
+                    size_t const space) {
+    std::cout << "RESULT algo=" << name
+	      << " exp=" << exp
+	      << " input=" << input_path
+	      << " n=" << input_.size()
+	      << " logn=" << tlx::integer_log2_ceil(input_.size())
+	      << " range_width=" << range_width
+	      << " k=" << top_k
+	      << " min_time_ns=" << time.min() / n_queries
+	      << " max_time_ns=" << time.max() / n_queries
+	      << " avg_time_ns=" << time.avg() / n_queries
+	      << " space_in_bytes=" << space
+	      << " space_in_mib=" << (space / 1024.0 / 1024.0)
+	      << " n_queries=" << n_queries
+	      << " n_runs=" << runs << std::endl;
+  }
+
+  template <typename WaveletMatrix, typename RangeQueries>
+  void run_experiments_latency(WaveletMatrix& wm, RangeQueries& queries,
+			       std::string name, size_t space) {
+
+    tlx::Aggregate<size_t> time_quantile;
+    tlx::Aggregate<size_t> time_count_less;
+    tlx::Aggregate<size_t> time_count_range;
+    tlx::Aggregate<size_t> time_next_value;
+    tlx::Aggregate<size_t> time_top_k;
+    tlx::Aggregate<size_t> time_mode;
+    tlx::Aggregate<size_t> time_majority;
+    tlx::Aggregate<size_t> time_distinct;
+    tlx::Aggregate<size_t> time_distinct_rank;
+    tlx::Aggregate<size_t> time_intersect;
+    tlx::Aggregate<size_t> time_intersect_rank;
+    tlx::Aggregate<size_t> time_occurrences;
+    tlx::Aggregate<size_t> time_occurrences_prefetch;
+    tlx::Aggregate<size_t> time_occurrences_select;
+    tlx::Aggregate<size_t> time_extract;
+    tlx::Aggregate<size_t> time_extract_access;
+    size_t number_occurrences = 0;
+
+    // Only a prefix of the queries is used for the extraction, such that at
+    // most (roughly) extract_symbols symbols are decoded per run.
+    size_t const number_extract_queries = std::min(
+        queries.size(),
+        std::max(size_t{1}, extract_symbols / std::max(size_t{1},
+                                                       range_width)));
+    size_t number_extracted = 0;
+    std::vector<uint8_t> snippet;
+
+    // The result of the previous query is used in the next one to prevent the
+    // queries from being answered in parallel.
+    for (size_t i = 0; i < runs; ++i) {
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          size_t const width = queries[i].end - queries[i].start;
+          size_t const k = (width / 2 + result) % width;
+          result = wm.quantile(queries[i].start, queries[i].end, k);
+        }
+        time_quantile.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          uint8_t const symbol = queries[i].upper ^ (result & 1);
+          result = wm.count_less(queries[i].start, queries[i].end, symbol);
+        }
+        time_count_less.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          uint8_t const lower = queries[i].lower & ~(result & 1);
+          result = wm.count_range(queries[i].start, queries[i].end, lower,
+                                  queries[i].upper);
+        }
+        time_count_range.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          uint8_t const symbol = queries[i].lower ^ (result & 1);
+          result = wm.next_value(queries[i].start, queries[i].end, symbol)
+                       .value_or(0);
+        }
+        time_next_value.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          size_t const offset =
+              std::min<size_t>(result & 1, queries[i].end - queries[i].start - 1);
+          auto const top = wm.top_k(queries[i].start + offset, queries[i].end,
+                                    top_k);
+          result = top.front().second;
+        }
+        time_top_k.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          size_t const offset =
+              std::min<size_t>(result & 1, queries[i].end - queries[i].start - 1);
+          result = wm.mode(queries[i].start + offset, queries[i].end).second;
+        }
+        time_mode.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          size_t const offset =
+              std::min<size_t>(result & 1, queries[i].end - queries[i].start - 1);
+          result = wm.majority(queries[i].start + offset, queries[i].end)
+                       .value_or(0);
+        }
+        time_majority.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          wm.distinct(queries[i].start, queries[i].end,
+                      [&](uint8_t const symbol, size_t const frequency) {
+                        result += symbol * frequency;
+                      });
+        }
+        time_distinct.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        // Baseline: two rank queries for each symbol of the alphabet
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          for (size_t symbol = 0; symbol < alphabet_size_; ++symbol) {
+            size_t const frequency =
+                wm.rank(queries[i].end, symbol) -
+                wm.rank(queries[i].start, symbol);
+            if (frequency > 0) {
+              result += symbol * frequency;
+            }
+          }
+        }
+        time_distinct_rank.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          auto const& other = queries[(i + 1) % queries.size()];
+          std::array<std::pair<size_t, size_t>, 2> const ranges = {
+            std::pair{queries[i].start, queries[i].end},
+            std::pair{other.start, other.end}};
+          wm.intersect(ranges, [&](uint8_t const symbol,
+                                   std::span<size_t const> frequencies) {
+            result += symbol * std::min(frequencies[0], frequencies[1]);
+          });
+        }
+        time_intersect.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        // Baseline: four rank queries for each symbol of the alphabet
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          auto const& other = queries[(i + 1) % queries.size()];
+          for (size_t symbol = 0; symbol < alphabet_size_; ++symbol) {
+            size_t const frequency =
+                wm.rank(queries[i].end, symbol) -
+                wm.rank(queries[i].start, symbol);
+            if (frequency == 0) {
+              continue;
+            }
+            size_t const other_frequency =
+                wm.rank(other.end, symbol) - wm.rank(other.start, symbol);
+            if (other_frequency > 0) {
+              result += symbol * std::min(frequency, other_frequency);
+            }
+          }
+        }
+        time_intersect_rank.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      // The symbols of the queries are sampled from the text, i.e., frequent
+      // symbols are queried more often.
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          for (size_t const position : wm.occurrences(
+                   queries[i].start, queries[i].end, queries[i].upper)) {
+            result += position;
+          }
+        }
+        time_occurrences.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          for (size_t const position : wm.template occurrences<true>(
+                   queries[i].start, queries[i].end, queries[i].upper)) {
+            result += position;
+          }
+        }
+        time_occurrences_prefetch.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        // Baseline: one select query per occurrence
+        size_t result = 0;
+        number_occurrences = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          size_t const rank_start = wm.rank(queries[i].start, queries[i].upper);
+          size_t const rank_end = wm.rank(queries[i].end, queries[i].upper);
+          for (size_t rank = rank_start + 1; rank <= rank_end; ++rank) {
+            result += wm.select(rank, queries[i].upper);
+          }
+          number_occurrences += rank_end - rank_start;
+        }
+        time_occurrences_select.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        size_t result = 0;
+        number_extracted = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < number_extract_queries; ++i) {
+          size_t const width = queries[i].end - queries[i].start;
+          snippet.resize(width);
+          wm.extract(queries[i].start, queries[i].end, snippet.begin());
+          result += snippet[width / 2];
+          number_extracted += width;
+        }
+        time_extract.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        // Baseline: one access per position
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < number_extract_queries; ++i) {
+          size_t const width = queries[i].end - queries[i].start;
+          snippet.resize(width);
+          for (size_t j = 0; j < width; ++j) {
+            snippet[j] = wm[queries[i].start + j];
+          }
+          result += snippet[width / 2];
+        }
+        time_extract_access.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+    }
+
+    print_result(name, "quantile_latency", time_quantile, queries.size(), space);
+    print_result(name, "count_less_latency", time_count_less, queries.size(),
+                 space);
+    print_result(name, "count_range_latency", time_count_range, queries.size(),
+                 space);
+    print_result(name, "next_value_latency", time_next_value, queries.size(),
+                 space);
+    print_result(name, "top_k_latency", time_top_k, queries.size(), space);
+    print_result(name, "mode_latency", time_mode, queries.size(), space);
+    print_result(name, "majority_latency", time_majority, queries.size(),
+                 space);
+    print_result(name, "distinct_latency", time_distinct, queries.size(),
+                 space);
+    print_result(name, "distinct_rank_loop_latency", time_distinct_rank,
+                 queries.size(), space);
+    print_result(name, "intersect_latency", time_intersect, queries.size(),
+                 space);
+    print_result(name, "intersect_rank_loop_latency", time_intersect_rank,
+                 queries.size(), space);
+    // The following times are per occurrence and not per query.
+    number_occurrences = std::max(size_t{1}, number_occurrences);
+    print_result(name, "occurrences_per_occurrence", time_occurrences,
+                 number_occurrences, space);
+    print_result(name, "occurrences_prefetch_per_occurrence",
+                 time_occurrences_prefetch, number_occurrences, space);
+    print_result(name, "occurrences_select_per_occurrence",
+                 time_occurrences_select, number_occurrences, space);
+    // The following times are per extracted symbol.
+    number_extracted = std::max(size_t{1}, number_extracted);
+    print_result(name, "extract_per_symbol", time_extract, number_extracted,
+                 space);
+    print_result(name, "extract_access_loop_per_symbol", time_extract_access,
+                 number_extracted, space);
+  }
+
+}; // class Benchmark
+
+
+int32_t main(int argc, char *argv[]) {
+  tlx::CmdlineParser cp;
+
+  cp.set_description("Wavelet Tree/Wavelet Matrix Range Query Benchmark");
+
+  Benchmark bench;
+
+  cp.add_param_string("input", bench.input_path, "Path to input file.");
+  cp.add_bytes('n', "size", bench.prefix_size,
+               "Size (in bytes unless stated otherwise) of the prefix of the "
+               "input that is used.");
+  cp.add_bytes('q', "queries", bench.number_queries,
+               "Number of queries tested. "
+               "Default is 1'000'000.");
+  cp.add_bytes('w', "width", bench.range_width,
+               "Number of positions in each query interval. Default is 1024.");
+  cp.add_bytes('k', "top_k", bench.top_k,
+               "Number of most frequent symbols reported by top_k. "
+               "Default is 10.");
+  cp.add_bytes('e', "extract_symbols", bench.extract_symbols,
+               "Number of symbols (roughly) extracted per run. Default is "
+               "64MiB.");
+  cp.add_bytes('r', "runs", bench.runs, "Number of runs the benchmark is executed.");
+
+  if (!cp.process(argc, argv)) {
+    return -1;
+  }
+
+  bench.run();
+
+  return 0;
+}
+
+/******************************************************************************/
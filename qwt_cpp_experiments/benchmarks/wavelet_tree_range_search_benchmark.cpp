@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <tlx/cmdline_parser.hpp>
+#include <tlx/math.hpp>
+
+#include <pasta/utils/benchmark/do_not_optimize.hpp>
+#include <pasta/utils/benchmark/memory_monitor.hpp>
+#include <pasta/utils/reduce_alphabet.hpp>
+#include <pasta/wavelet_tree/wavelet_tree.hpp>
+
+#include <sdsl/int_vector.hpp>
+
+#include "../include/wm_int.hpp"
+
+struct RangeSearchQuery {
+  size_t start;
+  size_t end;
+  uint8_t lower;
+  uint8_t upper;
+}; // struct RangeSearchQuery
+
+class Benchmark {
+
+private:
+  std::vector<uint8_t> input_;
+  size_t alphabet_size_;
+  pasta::MemoryMonitor& mem_monitor_ = pasta::MemoryMonitor::instance();
+
+public:
+
+  size_t prefix_size = {0};
+  std::string input_path = "";
+  size_t number_small_queries = 100'000;
+  size_t number_wide_queries = 1'000;
+  size_t small_width = 64;
+  size_t wide_width = 65'536;
+  size_t runs = 10;
+
+  void run() {
+    load_text();
+    reduce_alphabet();
+
+    // Small rectangles cover few positions and an eighth of the alphabet,
+    // wide rectangles cover many positions and half of the alphabet.
+    auto const small_queries = generate_queries(number_small_queries,
+                                                small_width,
+                                                std::max(size_t{1}, alphabet_size_ / 8));
+    auto const wide_queries = generate_queries(number_wide_queries, wide_width,
+                                               std::max(size_t{1}, alphabet_size_ / 2));
+
+    auto pasta_wm = pasta::make_wm<pasta::BitVector>(input_.begin(), input_.end(),
+                                                     alphabet_size_);
+    run_pasta_experiments(pasta_wm, small_queries, "pasta_wm", "small",
+                          pasta_wm.space_usage());
+    run_pasta_experiments(pasta_wm, wide_queries, "pasta_wm", "wide",
+                          pasta_wm.space_usage());
+
+    sdsl::int_vector<8> sdsl_input(input_.size(), 0);
+    for (size_t i = 0; i < input_.size(); ++i) {
+      sdsl_input[i] = input_[i];
+    }
+    sdsl::wm_int sdsl_wm(sdsl_input, sdsl_input.size());
+
+    run_sdsl_experiments(sdsl_wm, small_queries, "sdsl_wm", "small",
+                         sdsl::size_in_bytes(sdsl_wm));
+    run_sdsl_experiments(sdsl_wm, wide_queries, "sdsl_wm", "wide",
+                         sdsl::size_in_bytes(sdsl_wm));
+  }
+
+private:
+
+  void load_text() {
+    // Read prefix of file
+    std::ifstream stream(input_path.c_str(), std::ios::in | std::ios::binary);
+    if (!stream) {
+      std::cerr << "File " << input_path << " not found\n";
+      exit(1);
+    }
+    stream.seekg(0, std::ios::end);
+    uint64_t size = stream.tellg();
+    if (prefix_size > 0) {
+      size = std::min(prefix_size, size);
+    }
+    prefix_size = size;
+    stream.seekg(0);
+    input_.resize(size);
+    stream.read(reinterpret_cast<char *>(input_.data()), size);
+    stream.close();
+  }
+
+  void reduce_alphabet() {
+    // Compute effective alphabet and effective alphabet size
+    alphabet_size_ = pasta::reduce_alphabet(input_.begin(), input_.end());
+  }
+
+  std::vector<RangeSearchQuery> generate_queries(size_t const number_queries,
+                                                 size_t width,
+                                                 size_t const symbol_width) {
+    std::random_device rnd_device;
+    std::mt19937 mersenne_engine(rnd_device());
+    width = std::max(size_t{1}, std::min(width, input_.size()));
+    std::uniform_int_distribution<uint64_t> dist(0, input_.size() - width);
+    std::uniform_int_distribution<uint64_t> symbol_dist(0, input_.size() - 1);
+
+    std::vector<RangeSearchQuery> random_queries(number_queries);
+    for (size_t i = 0; i < number_queries; ++i) {
+      size_t const start = dist(mersenne_engine);
+      size_t const lower = input_[symbol_dist(mersenne_engine)];
+      size_t const upper = std::min(alphabet_size_ - 1, lower + symbol_width - 1);
+      random_queries[i] = RangeSearchQuery{start, start + width,
+                                           static_cast<uint8_t>(lower),
+                                           static_cast<uint8_t>(upper)};
+    }
+    return random_queries;
+  }
+
+  void print_result(std::string const& name, std::string const& exp,
+                    std::string const& shape,
+                    tlx::Aggregate<size_t> const& time, size_t const n_queries,
+                    size_t const n_points, size_t const space) {
+    std::cout << "RESULT algo=" << name
+	      << " exp=" << exp
+	      << " shape=" << shape
+	      << " input=" << input_path
+	      << " n=" << input_.size()
+	      << " logn=" << tlx::integer_log2_ceil(input_.size())
+	      << " min_time_ns=" << time.min() / n_queries
+	      << " max_time_ns=" << time.max() / n_queries
+	      << " avg_time_ns=" << time.avg() / n_queries
+	      << " avg_points=" << (n_points / static_cast<double>(n_queries))
+	      << " space_in_bytes=" << space
+	      << " space_in_mib=" << (space / 1024.0 / 1024.0)
+	      << " n_queries=" << n_queries
+	      << " n_runs=" << runs << std::endl;
+  }
+
+  template <typename WaveletMatrix, typename Queries>
+  void run_pasta_experiments(WaveletMatrix& wm, Queries& queries,
+                             std::string name, std::string shape,
+                             size_t space) {
+    tlx::Aggregate<size_t> time_count;
+    tlx::Aggregate<size_t> time_report;
+    tlx::Aggregate<size_t> time_report_sorted;
+    size_t points = 0;
+
+    for (size_t i = 0; i < runs; ++i) {
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          result += wm.range_search_2d(queries[i].start, queries[i].end,
+                                       queries[i].lower, queries[i].upper);
+        }
+        time_count.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        points = result;
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          wm.range_search_2d(queries[i].start, queries[i].end, queries[i].lower,
+                             queries[i].upper,
+                             [&](size_t const position, uint8_t const symbol) {
+                               result += position + symbol;
+                             });
+        }
+        time_report.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          wm.range_search_2d_sorted(queries[i].start, queries[i].end,
+                                    queries[i].lower, queries[i].upper,
+                                    [&](size_t const position,
+                                        uint8_t const symbol) {
+                                      result += position + symbol;
+                                    });
+        }
+        time_report_sorted.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+    }
+
+    print_result(name, "range_search_2d_count", shape, time_count,
+                 queries.size(), points, space);
+    print_result(name, "range_search_2d_report", shape, time_report,
+                 queries.size(), points, space);
+    print_result(name, "range_search_2d_report_sorted", shape,
+                 time_report_sorted, queries.size(), points, space);
+  }
+
+  template <typename WaveletMatrix, typename Queries>
+  void run_sdsl_experiments(WaveletMatrix& wm, Queries& queries,
+                            std::string name, std::string shape,
+                            size_t space) {
+    tlx::Aggregate<size_t> time_count;
+    tlx::Aggregate<size_t> time_report;
+    size_t points = 0;
+    // The reported points are written to the same vector for all queries
+    typename WaveletMatrix::point_vec_type point_vec;
+
+    for (size_t i = 0; i < runs; ++i) {
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          // sdsl uses inclusive bounds for the positions
+          result += wm.range_search_2d(queries[i].start, queries[i].end - 1,
+                                       queries[i].lower, queries[i].upper,
+                                       point_vec, false);
+        }
+        time_count.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        points = result;
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+
+      {
+        size_t result = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+          wm.range_search_2d(queries[i].start, queries[i].end - 1,
+                             queries[i].lower, queries[i].upper, point_vec,
+                             true);
+          for (auto const& point : point_vec) {
+            result += point.first + point.second;
+          }
+        }
+        time_report.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+          .count());
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+    }
+
+    print_result(name, "range_search_2d_count", shape, time_count,
+                 queries.size(), points, space);
+    print_result(name, "range_search_2d_report", shape, time_report,
+                 queries.size(), points, space);
+
+    // Neither counting nor reporting into the (already grown) vector should
+    // allocate memory
+    size_t result = 0;
+    mem_monitor_.reset();
+    for (size_t i = 0; i < queries.size(); ++i) {
+      result += wm.range_search_2d(queries[i].start, queries[i].end - 1,
+                                   queries[i].lower, queries[i].upper,
+                                   point_vec, false);
+    }
+    size_t const count_allocations = mem_monitor_.get().number_malloc;
+    mem_monitor_.reset();
+    for (size_t i = 0; i < queries.size(); ++i) {
+      result += wm.range_search_2d(queries[i].start, queries[i].end - 1,
+                                   queries[i].lower, queries[i].upper,
+                                   point_vec, true);
+    }
+    size_t const report_allocations = mem_monitor_.get().number_malloc;
+    PASTA_DO_NOT_OPTIMIZE(result);
+    std::cout << "RESULT algo=" << name
+	      << " exp=" << "heap_allocations"
+	      << " shape=" << shape
+	      << " input=" << input_path
+	      << " n=" << input_.size()
+	      << " logn=" << tlx::integer_log2_ceil(input_.size())
+	      << " count_allocations=" << count_allocations
+	      << " report_allocations=" << report_allocations
+	      << " n_queries=" << queries.size() << std::endl;
+  }
+
+}; // class Benchmark
+
+
+int32_t main(int argc, char *argv[]) {
+  tlx::CmdlineParser cp;
+
+  cp.set_description("Wavelet Matrix 2D Range Search Benchmark");
+
+  Benchmark bench;
+
+  cp.add_param_string("input", bench.input_path, "Path to input file.");
+  cp.add_bytes('n', "size", bench.prefix_size,
+               "Size (in bytes unless stated otherwise) of the prefix of the "
+               "input that is used.");
+  cp.add_bytes('q', "small_queries", bench.number_small_queries,
+               "Number of small rectangles queried. Default is 100'000.");
+  cp.add_bytes('Q', "wide_queries", bench.number_wide_queries,
+               "Number of wide rectangles queried. Default is 1'000.");
+  cp.add_bytes('w', "small_width", bench.small_width,
+               "Number of positions in small rectangles. Default is 64.");
+  cp.add_bytes('W', "wide_width", bench.wide_width,
+               "Number of positions in wide rectangles. Default is 65'536.");
+  cp.add_bytes('r', "runs", bench.runs, "Number of runs the benchmark is executed.");
+
+  if (!cp.process(argc, argv)) {
+    return -1;
+  }
+
+  bench.run();
+
+  return 0;
+}
+
+/******************************************************************************/
@@ -22,6 +22,7 @@
 
 #include "pasta/utils/benchmark/malloc.hpp"
 
+#include <algorithm>
 #include <cstddef>
 #include <iostream>
 #include <ostream>
@@ -37,6 +38,8 @@ namespace pasta {
 struct MemoryMonitorStats {
   //! The current memory peak.
   size_t cur_peak;
+  //! The maximum of \c cur_peak since the last reset.
+  size_t peak;
   //! The sum of all memory that has been allocated.
   size_t total_size_malloc;
   //! The sum of all memory that has been freed.
@@ -52,6 +55,7 @@ struct MemoryMonitorStats {
    * \brief Constructor. Setting all members.
    *
    * \param _cur_peak The current memory peak.
+   * \param _peak The maximum of \c _cur_peak since the last reset.
    * \param _total_size_malloc The sum of all memory that has been allocated.
    * \param _total_size_free The sum of all memory that has been freed.
    * \param _number_malloc The amount of malloc-calls.
@@ -60,12 +64,14 @@ struct MemoryMonitorStats {
    * \c MemoryMonitor.
    */
   MemoryMonitorStats(size_t const _cur_peak,
+                     size_t const _peak,
                      size_t const _total_size_malloc,
                      size_t const _total_size_free,
                      size_t const _number_malloc,
                      size_t const _number_free,
                      size_t const _uncounted)
       : cur_peak(_cur_peak),
+        peak(_peak),
         total_size_malloc(_total_size_malloc),
         total_size_free(_total_size_free),
         number_malloc(_number_malloc),
@@ -76,6 +82,7 @@ struct MemoryMonitorStats {
 //! Simple output of \c MemoryMonitorStats.
 std::ostream& operator<<(std::ostream& os, const MemoryMonitorStats& mms) {
   os << "cur_peak=" << mms.cur_peak << " "
+     << "peak=" << mms.peak << " "
      << "total_size_malloc=" << mms.total_size_malloc << " "
      << "total_size_free=" << mms.total_size_free << " "
      << "number_malloc=" << mms.number_malloc << " "
@@ -98,7 +105,7 @@ class MemoryMonitor {
   MemoryMonitorStats memory_stats_;
 
   //! Private constructor to enable singleton pattern.
-  MemoryMonitor() : memory_stats_(0, 0, 0, 0, 0, 0) {
+  MemoryMonitor() : memory_stats_(0, 0, 0, 0, 0, 0, 0) {
     MemoryMonitorCallbacks::malloc_callback = MemoryMonitor::malloc_callback;
     MemoryMonitorCallbacks::free_callback = MemoryMonitor::free_callback;
     MemoryMonitorCallbacks::uncounted_callback =
@@ -107,9 +114,11 @@ class MemoryMonitor {
 
   //! Callback for malloc (used in malloc.cpp).
   static void malloc_callback(size_t const size) {
-    instance().memory_stats_.cur_peak += size;
-    instance().memory_stats_.total_size_malloc += size;
-    ++instance().memory_stats_.number_malloc;
+    MemoryMonitorStats& cur_stats = instance().memory_stats_;
+    cur_stats.cur_peak += size;
+    cur_stats.peak = std::max(cur_stats.peak, cur_stats.cur_peak);
+    cur_stats.total_size_malloc += size;
+    ++cur_stats.number_malloc;
   }
 
   //! Callback for free (used in malloc.cpp)
@@ -137,7 +146,7 @@ public:
 
   //! Reset the current measurement. All measurements are set to zero.
   void reset() {
-    instance().memory_stats_ = {0, 0, 0, 0, 0, 0};
+    instance().memory_stats_ = {0, 0, 0, 0, 0, 0, 0};
   }
 
   /*!
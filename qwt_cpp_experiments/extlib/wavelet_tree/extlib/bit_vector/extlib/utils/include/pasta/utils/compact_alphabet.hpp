@@ -0,0 +1,318 @@
+/*******************************************************************************
+ * This file is part of pasta::utils.
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::utils.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/utils/byte_alphabet.hpp"
+#include "pasta/utils/concepts/alphabet.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace pasta {
+
+//! \addtogroup pasta_utils
+//! \{
+
+//! Symbols with 16 or 32 bits, whose alphabet can be compacted.
+template <typename Type>
+concept WideAlphabet =
+    Alphabet<Type> && (std::numeric_limits<Type>::digits == 16 ||
+                       std::numeric_limits<Type>::digits == 32);
+
+/*!
+ * \brief Order preserving mapping of the (sparse) alphabet of a text over 16
+ * or 32 bit symbols to its effective alphabet.
+ *
+ * This is the counterpart of \ref reduce_alphabet() for alphabets that are
+ * too large for a dense histogram. The distinct symbols of the text are
+ * computed in parallel: For 16 bit symbols, each thread marks the symbols of
+ * its chunk in a bit vector of size 2^16. For 32 bit symbols, each thread
+ * collects the distinct symbols of its chunk in a hash set (whose size
+ * depends on the alphabet and not on the text), then the sorted distinct
+ * symbols of all threads are merged.
+ *
+ * The \f$i\f$-th smallest symbol is mapped to \f$i\f$ (plus the smallest
+ * symbol). To map a symbol, its high 16 bits select a bucket of the sorted
+ * distinct symbols, which is searched for the symbol. For 16 bit symbols,
+ * each bucket contains at most one symbol.
+ *
+ * \tparam Symbol Type of the symbols of the text (16 or 32 bits).
+ */
+template <WideAlphabet Symbol>
+class CompactAlphabet {
+  //! Number of bits of a symbol.
+  static constexpr size_t SymbolBits = std::numeric_limits<Symbol>::digits;
+  //! Shift of a symbol to obtain its bucket.
+  static constexpr size_t BucketShift = SymbolBits - 16;
+
+  //! Sorted distinct symbols of the text (reverse mapping).
+  std::vector<Symbol> symbols_;
+  //! For each bucket, the index of its first symbol in \c symbols_.
+  std::vector<uint32_t> bucket_starts_;
+  //! Smallest symbol of the effective alphabet.
+  size_t smallest_symbol_ = 0;
+
+  /*!
+   * \brief Computes the sorted distinct symbols of a text using a hash set
+   * with linear probing.
+   *
+   * \param begin Pointer to the first symbol.
+   * \param end Pointer after the last symbol.
+   * \return Sorted distinct symbols.
+   */
+  static std::vector<Symbol> distinct_symbols(Symbol const* begin,
+                                              Symbol const* const end) {
+    // Slots contain the symbol plus one, such that zero marks empty slots.
+    std::vector<uint64_t> slots(1024, 0);
+    size_t shift = 64 - 10;
+    size_t used = 0;
+    auto const insert = [&](uint64_t const key) {
+      size_t const mask = slots.size() - 1;
+      size_t pos = (key * 0x9E3779B97F4A7C15ULL) >> shift;
+      while (slots[pos] != 0 && slots[pos] != key) {
+        pos = (pos + 1) & mask;
+      }
+      if (slots[pos] == 0) {
+        slots[pos] = key;
+        return true;
+      }
+      return false;
+    };
+    for (; begin != end; ++begin) {
+      if (insert(uint64_t{*begin} + 1) && (++used * 2 > slots.size())) {
+        std::vector<uint64_t> old_slots(slots.size() * 2, 0);
+        std::swap(slots, old_slots);
+        --shift;
+        for (auto const key : old_slots) {
+          if (key != 0) {
+            insert(key);
+          }
+        }
+      }
+    }
+    std::vector<Symbol> symbols;
+    symbols.reserve(used);
+    for (auto const key : slots) {
+      if (key != 0) {
+        symbols.push_back(static_cast<Symbol>(key - 1));
+      }
+    }
+    std::sort(symbols.begin(), symbols.end());
+    return symbols;
+  }
+
+public:
+  //! Default constructor for an empty text.
+  CompactAlphabet() : bucket_starts_((size_t{1} << 16) + 1, 0) {}
+
+  /*!
+   * \brief Constructor. Computes the effective alphabet of a text.
+   *
+   * \param text Pointer to the first symbol of the text.
+   * \param size Number of symbols.
+   * \param threads Number of threads.
+   * \param smallest_symbol The smallest symbol used in the effective alphabet
+   * (this allows to reserve some symbols as sentinels).
+   */
+  CompactAlphabet(Symbol const* const text,
+                  size_t const size,
+                  size_t const threads = 1,
+                  size_t const smallest_symbol = 0)
+      : smallest_symbol_(smallest_symbol) {
+    if constexpr (SymbolBits == 16) {
+      std::vector<std::array<uint64_t, 1024>> occ(
+          std::max<size_t>(1, threads));
+      for_each_chunk(
+          size, threads, [&](size_t const thread, size_t i, size_t const end) {
+            auto& local_occ = occ[thread];
+            local_occ.fill(0ULL);
+            for (; i < end; ++i) {
+              local_occ[text[i] / 64] |= 1ULL << (text[i] % 64);
+            }
+          });
+      for (size_t word = 0; word < 1024; ++word) {
+        uint64_t bits = 0ULL;
+        for (auto const& local_occ : occ) {
+          bits |= local_occ[word];
+        }
+        for (; bits != 0ULL; bits &= bits - 1) {
+          symbols_.push_back(
+              static_cast<Symbol>(word * 64 + std::countr_zero(bits)));
+        }
+      }
+    } else {
+      std::vector<std::vector<Symbol>> distinct(std::max<size_t>(1, threads));
+      for_each_chunk(
+          size,
+          threads,
+          [&](size_t const thread, size_t const begin, size_t const end) {
+            distinct[thread] = distinct_symbols(text + begin, text + end);
+          });
+      if (distinct.size() == 1) {
+        symbols_ = std::move(distinct.front());
+      } else {
+        // The distinct symbols are small compared to the text, hence, there
+        // is no need to merge them in parallel.
+        for (auto& local : distinct) {
+          symbols_.insert(symbols_.end(), local.begin(), local.end());
+          std::vector<Symbol>().swap(local);
+        }
+        std::sort(symbols_.begin(), symbols_.end());
+        symbols_.erase(std::unique(symbols_.begin(), symbols_.end()),
+                       symbols_.end());
+      }
+    }
+    bucket_starts_.resize((size_t{1} << 16) + 1, 0);
+    for (auto const symbol : symbols_) {
+      ++bucket_starts_[(symbol >> BucketShift) + 1];
+    }
+    for (size_t i = 1; i < bucket_starts_.size(); ++i) {
+      bucket_starts_[i] += bucket_starts_[i - 1];
+    }
+  }
+
+  /*!
+   * \brief Size of the effective alphabet. If there is a smallest symbol,
+   * this is smallest symbol plus alphabet size (see \ref reduce_alphabet()).
+   */
+  [[nodiscard("alphabet size computed but not used")]] size_t size() const {
+    return smallest_symbol_ + symbols_.size();
+  }
+
+  /*!
+   * \brief Number of levels of a wavelet tree/matrix for the compacted text.
+   */
+  [[nodiscard("levels computed but not used")]] size_t levels() const {
+    return std::bit_width(std::max<size_t>(size(), 1) - 1);
+  }
+
+  //! Sorted distinct symbols of the text, i.e., the reverse mapping.
+  [[nodiscard("symbols accessed but not used")]] std::vector<Symbol> const&
+  symbols() const {
+    return symbols_;
+  }
+
+  /*!
+   * \brief Maps a symbol of the text to the effective alphabet.
+   * \param symbol Symbol that occurs in the text.
+   * \return Symbol in the effective alphabet.
+   */
+  [[nodiscard("symbol mapped but not used")]] size_t
+  compact(Symbol const symbol) const {
+    size_t const bucket = symbol >> BucketShift;
+    auto const it = std::lower_bound(symbols_.begin() + bucket_starts_[bucket],
+                                     symbols_.begin() +
+                                         bucket_starts_[bucket + 1],
+                                     symbol);
+    return smallest_symbol_ + std::distance(symbols_.begin(), it);
+  }
+
+  /*!
+   * \brief Maps a symbol of the effective alphabet back to the text's
+   * alphabet.
+   * \param compact_symbol Symbol in the effective alphabet (at least the
+   * smallest symbol).
+   * \return Symbol of the text.
+   */
+  [[nodiscard("symbol mapped but not used")]] Symbol
+  original(size_t const compact_symbol) const {
+    return symbols_[compact_symbol - smallest_symbol_];
+  }
+
+  /*!
+   * \brief Maps a text to the effective alphabet in parallel.
+   *
+   * \tparam CompactSymbol Type of the symbols of the compacted text, which
+   * can be smaller than \c Symbol, e.g., \c uint16_t or \c uint8_t if there
+   * are at most 2^16 or 2^8 symbols, such that the wavelet tree/matrix can be
+   * constructed directly for the compacted text.
+   * \param text Pointer to the first symbol of the text.
+   * \param size Number of symbols.
+   * \param out Pointer to the compacted text of size \c size (can be \c text
+   * if the types are the same).
+   * \param threads Number of threads.
+   */
+  template <Alphabet CompactSymbol>
+  void compact(Symbol const* const text,
+               size_t const size,
+               CompactSymbol* const out,
+               size_t const threads = 1) const {
+    for_each_chunk(size, threads, [&](size_t, size_t begin, size_t const end) {
+      for (; begin < end; ++begin) {
+        out[begin] = static_cast<CompactSymbol>(compact(text[begin]));
+      }
+    });
+  }
+
+  /*!
+   * \brief Maps a compacted text back to the text's alphabet in parallel.
+   *
+   * \param text Pointer to the first symbol of the compacted text.
+   * \param size Number of symbols.
+   * \param out Pointer to the original text of size \c size (can be \c text
+   * if the types are the same).
+   * \param threads Number of threads.
+   */
+  template <Alphabet CompactSymbol>
+  void restore(CompactSymbol const* const text,
+               size_t const size,
+               Symbol* const out,
+               size_t const threads = 1) const {
+    for_each_chunk(size, threads, [&](size_t, size_t begin, size_t const end) {
+      for (; begin < end; ++begin) {
+        out[begin] = original(text[begin]);
+      }
+    });
+  }
+}; // class CompactAlphabet
+
+/*!
+ * \brief Transform a text over 16 or 32 bit symbols to use its effective
+ * alphabet (preserving lexicographical order) in parallel.
+ *
+ * \param text Text that is compacted in place.
+ * \param threads Number of threads.
+ * \param smallest_symbol The smallest symbol used in the effective alphabet.
+ * \return Mapping that can be used to reverse the compaction (and contains
+ * the alphabet size and number of levels).
+ */
+template <WideAlphabet Symbol>
+[[nodiscard("mapping computed but not used")]] CompactAlphabet<Symbol>
+compact_alphabet(std::vector<Symbol>& text,
+                 size_t const threads = 1,
+                 size_t const smallest_symbol = 0) {
+  CompactAlphabet<Symbol> alphabet(text.data(),
+                                   text.size(),
+                                   threads,
+                                   smallest_symbol);
+  alphabet.compact(text.data(), text.size(), text.data(), threads);
+  return alphabet;
+}
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
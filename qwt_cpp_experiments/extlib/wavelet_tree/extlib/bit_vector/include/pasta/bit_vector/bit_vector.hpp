@@ -32,6 +32,7 @@
 #include <iterator>
 #include <span>
 #include <tlx/container/simple_vector.hpp>
+#include <utility>
 
 namespace pasta {
 
@@ -300,6 +301,33 @@ public:
   //! Deleted copy assignment.
   BitVector& operator=(BitVector const&) = delete;
 
+  /*!
+   * \brief Move constructor. The moved-from bit vector is empty afterwards
+   * (and does not point to the moved data anymore).
+   */
+  BitVector(BitVector&& other) noexcept
+      : bit_size_(std::exchange(other.bit_size_, 0)),
+        size_(std::exchange(other.size_, 0)),
+        data_(std::move(other.data_)),
+        raw_data_(data_.data()) {
+    other.raw_data_ = nullptr;
+  }
+
+  /*!
+   * \brief Move assignment. The moved-from bit vector is empty afterwards
+   * (and does not point to the moved data anymore).
+   */
+  BitVector& operator=(BitVector&& other) noexcept {
+    if (this != &other) {
+      bit_size_ = std::exchange(other.bit_size_, 0);
+      size_ = std::exchange(other.size_, 0);
+      data_ = std::move(other.data_);
+      raw_data_ = data_.data();
+      other.raw_data_ = nullptr;
+    }
+    return *this;
+  }
+
   /*!
    * \brief Constructor. Creates a bit vector that holds a specific, fixed
    * number of bits.
@@ -0,0 +1,718 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+#include "pasta/bit_vector/support/select.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pasta {
+
+/*!
+ * \ingroup pasta_bit_vectors
+ * \brief Dynamic bit vector supporting insertions, deletions, and updates of
+ * bits as well as rank and select queries in O(log n) time.
+ *
+ * The bits are stored in leaves of a B+ tree. Each leaf contains up to
+ * \c LeafWords 64-bit words. Each inner node stores for each child the number
+ * of bits and ones in the child's subtree, which are used to navigate to the
+ * leaf containing a position (or the rank-th one or zero) and to compute the
+ * rank up to the leaf. Within the leaf, the result is computed using
+ * popcount. Full leaves (nodes) are split in half. Leaves (nodes) that are
+ * filled less than a quarter are merged with a neighbor if the result fits.
+ *
+ * Leaves and nodes are stored in vectors and referenced by their index,
+ * i.e., there is no allocation per leaf.
+ *
+ * \tparam LeafWords Number of 64-bit words in a leaf. Must be even.
+ * \tparam Fanout Maximum number of children of an inner node.
+ */
+template <size_t LeafWords = 8, size_t Fanout = 16>
+class DynamicBitVector {
+  static_assert(LeafWords >= 2 && LeafWords % 2 == 0,
+                "The number of words in a leaf must be even.");
+  static_assert(Fanout >= 4, "The fanout must be at least four.");
+
+  //! Maximum number of bits in a leaf.
+  static constexpr size_t LeafBits = LeafWords * 64;
+  //! Maximum height of the tree. With at least two children per node, this
+  //! suffices for any number of bits that can be addressed.
+  static constexpr size_t MaxHeight = 64;
+
+  //! Leaf of the B+ tree containing the bits.
+  struct Leaf {
+    //! Bits of the leaf. Bits after the last bit are always zero.
+    std::array<uint64_t, LeafWords> words;
+    //! Number of bits in the leaf.
+    size_t size;
+    //! Number of ones in the leaf.
+    size_t ones;
+  }; // struct Leaf
+
+  //! Inner node of the B+ tree.
+  struct Node {
+    //! Number of children.
+    size_t children_count;
+    //! Number of bits in each child's subtree.
+    std::array<size_t, Fanout> sizes;
+    //! Number of ones in each child's subtree.
+    std::array<size_t, Fanout> ones;
+    //! Index of each child (either in \c nodes_ or \c leaves_).
+    std::array<size_t, Fanout> children;
+  }; // struct Node
+
+  //! Node and index of the child that is visited on a root-to-leaf path.
+  struct PathEntry {
+    //! Index of the node.
+    size_t node;
+    //! Index of the visited child in the node.
+    size_t child;
+  }; // struct PathEntry
+
+  //! All leaves (including unused ones).
+  std::vector<Leaf> leaves_;
+  //! Indices of unused leaves.
+  std::vector<size_t> free_leaves_;
+  //! All inner nodes (including unused ones).
+  std::vector<Node> nodes_;
+  //! Indices of unused inner nodes.
+  std::vector<size_t> free_nodes_;
+  //! Index of the root, which is always an inner node.
+  size_t root_;
+  //! Number of inner levels, i.e., nodes on level \c height_ - 1 have leaves
+  //! as children.
+  size_t height_;
+  //! Number of bits.
+  size_t size_ = 0;
+  //! Number of ones.
+  size_t ones_ = 0;
+
+public:
+  //! Constructor. Creates an empty dynamic bit vector.
+  DynamicBitVector() : root_(new_node()), height_(1) {
+    Node& root = nodes_[root_];
+    root.children_count = 1;
+    root.sizes[0] = 0;
+    root.ones[0] = 0;
+    root.children[0] = new_leaf();
+  }
+
+  /*!
+   * \brief Constructor. Creates a dynamic bit vector containing the bits of
+   * a static bit vector. All leaves (and nodes) are filled completely.
+   *
+   * \param bv Bit vector whose bits are copied.
+   */
+  DynamicBitVector(BitVector const& bv) : height_(1), size_(bv.size()) {
+    auto const data = bv.data();
+    size_t const number_leaves = std::max(size_t{1}, leaves_needed(size_));
+    std::vector<size_t> level(number_leaves);
+    std::vector<size_t> level_sizes(number_leaves);
+    std::vector<size_t> level_ones(number_leaves);
+    leaves_.reserve(number_leaves);
+    for (size_t i = 0; i < number_leaves; ++i) {
+      size_t const leaf = new_leaf();
+      Leaf& l = leaves_[leaf];
+      l.size = std::min(LeafBits, size_ - std::min(size_, i * LeafBits));
+      size_t const words = (l.size + 63) / 64;
+      for (size_t w = 0; w < words; ++w) {
+        l.words[w] = data[(i * LeafWords) + w];
+      }
+      if (l.size % 64 != 0) {
+        l.words[words - 1] &= (1ULL << (l.size % 64)) - 1;
+      }
+      l.ones = 0;
+      for (size_t w = 0; w < words; ++w) {
+        l.ones += std::popcount(l.words[w]);
+      }
+      ones_ += l.ones;
+      level[i] = leaf;
+      level_sizes[i] = l.size;
+      level_ones[i] = l.ones;
+    }
+    // Build the inner levels bottom-up until there is only one node left.
+    while (true) {
+      size_t const number_nodes = (level.size() + Fanout - 1) / Fanout;
+      std::vector<size_t> next_level(number_nodes);
+      std::vector<size_t> next_sizes(number_nodes, 0);
+      std::vector<size_t> next_ones(number_nodes, 0);
+      for (size_t i = 0; i < number_nodes; ++i) {
+        size_t const node = new_node();
+        Node& n = nodes_[node];
+        n.children_count = 0;
+        for (size_t j = i * Fanout; j < std::min(level.size(), (i + 1) * Fanout);
+             ++j) {
+          n.sizes[n.children_count] = level_sizes[j];
+          n.ones[n.children_count] = level_ones[j];
+          n.children[n.children_count++] = level[j];
+          next_sizes[i] += level_sizes[j];
+          next_ones[i] += level_ones[j];
+        }
+        next_level[i] = node;
+      }
+      if (number_nodes == 1) {
+        root_ = next_level[0];
+        break;
+      }
+      level = std::move(next_level);
+      level_sizes = std::move(next_sizes);
+      level_ones = std::move(next_ones);
+      ++height_;
+    }
+  }
+
+  /*!
+   * \brief Access the bit at a position.
+   *
+   * \param position Position of the bit.
+   * \return The bit at position \c position.
+   */
+  [[nodiscard("Dynamic bit vector accessed but result not used")]] bool
+  operator[](size_t position) const noexcept {
+    size_t node = root_;
+    for (size_t h = 0; h < height_; ++h) {
+      Node const& n = nodes_[node];
+      size_t i = 0;
+      while (i + 1 < n.children_count && position >= n.sizes[i]) {
+        position -= n.sizes[i++];
+      }
+      node = n.children[i];
+    }
+    return (leaves_[node].words[position / 64] >> (position % 64)) & 1ULL;
+  }
+
+  /*!
+   * \brief Computes the number of ones before a position.
+   *
+   * \param position Position up to which (excluding) ones are counted.
+   * \return Number of ones in [0, \c position).
+   */
+  [[nodiscard("Dynamic bit vector rank computed but not used")]] size_t
+  rank1(size_t position) const noexcept {
+    size_t result = 0;
+    size_t node = root_;
+    for (size_t h = 0; h < height_; ++h) {
+      Node const& n = nodes_[node];
+      size_t i = 0;
+      while (i + 1 < n.children_count && position >= n.sizes[i]) {
+        position -= n.sizes[i];
+        result += n.ones[i++];
+      }
+      node = n.children[i];
+    }
+    Leaf const& leaf = leaves_[node];
+    size_t const words = position / 64;
+    for (size_t w = 0; w < words; ++w) {
+      result += std::popcount(leaf.words[w]);
+    }
+    if (position % 64 != 0) {
+      result += std::popcount(leaf.words[words] << (64 - (position % 64)));
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Computes the number of zeros before a position.
+   *
+   * \param position Position up to which (excluding) zeros are counted.
+   * \return Number of zeros in [0, \c position).
+   */
+  [[nodiscard("Dynamic bit vector rank computed but not used")]] size_t
+  rank0(size_t const position) const noexcept {
+    return position - rank1(position);
+  }
+
+  /*!
+   * \brief Computes the position of the rank-th one.
+   *
+   * \param rank Rank of the one (starting at 1).
+   * \return Position of the \c rank-th one or the size of the bit vector, if
+   * there is no such one.
+   */
+  [[nodiscard("Dynamic bit vector select computed but not used")]] size_t
+  select1(size_t const rank) const noexcept {
+    return select<true>(rank);
+  }
+
+  /*!
+   * \brief Computes the position of the rank-th zero.
+   *
+   * \param rank Rank of the zero (starting at 1).
+   * \return Position of the \c rank-th zero or the size of the bit vector, if
+   * there is no such zero.
+   */
+  [[nodiscard("Dynamic bit vector select computed but not used")]] size_t
+  select0(size_t const rank) const noexcept {
+    return select<false>(rank);
+  }
+
+  /*!
+   * \brief Sets the bit at a position.
+   *
+   * \param position Position of the bit.
+   * \param bit New value of the bit.
+   */
+  void set(size_t position, bool const bit) noexcept {
+    std::array<PathEntry, MaxHeight> path;
+    size_t const leaf_index = find_leaf(position, path);
+    Leaf& leaf = leaves_[leaf_index];
+    uint64_t const mask = 1ULL << (position % 64);
+    bool const old_bit = leaf.words[position / 64] & mask;
+    if (old_bit == bit) {
+      return;
+    }
+    leaf.words[position / 64] ^= mask;
+    if (bit) {
+      ++leaf.ones;
+      ++ones_;
+      for (size_t h = 0; h < height_; ++h) {
+        ++nodes_[path[h].node].ones[path[h].child];
+      }
+    } else {
+      --leaf.ones;
+      --ones_;
+      for (size_t h = 0; h < height_; ++h) {
+        --nodes_[path[h].node].ones[path[h].child];
+      }
+    }
+  }
+
+  /*!
+   * \brief Inserts a bit at a position. All bits at and after the position
+   * are moved one position to the right.
+   *
+   * \param position Position the bit is inserted at (at most the size of the
+   * bit vector).
+   * \param bit Bit that is inserted.
+   */
+  void insert(size_t position, bool const bit) {
+    std::array<PathEntry, MaxHeight> path;
+    size_t node = root_;
+    for (size_t h = 0; h < height_; ++h) {
+      Node& n = nodes_[node];
+      size_t i = 0;
+      // Positions at the border of two children are inserted at the end of
+      // the left child.
+      while (i + 1 < n.children_count && position > n.sizes[i]) {
+        position -= n.sizes[i++];
+      }
+      ++n.sizes[i];
+      n.ones[i] += bit;
+      path[h] = PathEntry{node, i};
+      node = n.children[i];
+    }
+    ++size_;
+    ones_ += bit;
+
+    if (leaves_[node].size < LeafBits) {
+      leaf_insert(leaves_[node], position, bit);
+      return;
+    }
+
+    // Split the full leaf in half and insert the bit in one of the halves.
+    size_t const right = new_leaf();
+    Leaf& left_leaf = leaves_[node];
+    Leaf& right_leaf = leaves_[right];
+    constexpr size_t HalfWords = LeafWords / 2;
+    for (size_t w = 0; w < HalfWords; ++w) {
+      right_leaf.words[w] = left_leaf.words[HalfWords + w];
+      left_leaf.words[HalfWords + w] = 0ULL;
+    }
+    left_leaf.size = right_leaf.size = LeafBits / 2;
+    right_leaf.ones = 0;
+    for (size_t w = 0; w < HalfWords; ++w) {
+      right_leaf.ones += std::popcount(right_leaf.words[w]);
+    }
+    left_leaf.ones -= right_leaf.ones;
+    if (position <= LeafBits / 2) {
+      leaf_insert(left_leaf, position, bit);
+    } else {
+      leaf_insert(right_leaf, position - (LeafBits / 2), bit);
+    }
+    insert_child(path, height_ - 1, left_leaf.size, left_leaf.ones, right,
+                 right_leaf.size, right_leaf.ones);
+  }
+
+  /*!
+   * \brief Appends a bit at the end of the bit vector.
+   *
+   * \param bit Bit that is appended.
+   */
+  void push_back(bool const bit) {
+    insert(size_, bit);
+  }
+
+  /*!
+   * \brief Removes the bit at a position. All bits after the position are
+   * moved one position to the left.
+   *
+   * \param position Position of the bit that is removed.
+   */
+  void erase(size_t position) {
+    std::array<PathEntry, MaxHeight> path;
+    size_t const leaf_index = find_leaf(position, path);
+    Leaf& leaf = leaves_[leaf_index];
+    bool const bit = (leaf.words[position / 64] >> (position % 64)) & 1ULL;
+    leaf_erase(leaf, position);
+    for (size_t h = 0; h < height_; ++h) {
+      Node& n = nodes_[path[h].node];
+      --n.sizes[path[h].child];
+      n.ones[path[h].child] -= bit;
+    }
+    --size_;
+    ones_ -= bit;
+    rebalance(path);
+  }
+
+  /*!
+   * \brief Get the size of the bit vector in bits.
+   * \return Size of the bit vector in bits.
+   */
+  [[nodiscard]] size_t size() const noexcept {
+    return size_;
+  }
+
+  /*!
+   * \brief Get the number of ones in the bit vector.
+   * \return Number of ones in the bit vector.
+   */
+  [[nodiscard]] size_t ones() const noexcept {
+    return ones_;
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    return (leaves_.capacity() * sizeof(Leaf)) +
+           (nodes_.capacity() * sizeof(Node)) +
+           ((free_leaves_.capacity() + free_nodes_.capacity()) *
+            sizeof(size_t)) +
+           sizeof(*this);
+  }
+
+private:
+  //! Number of (full) leaves required for \c bits bits.
+  [[nodiscard]] static size_t leaves_needed(size_t const bits) noexcept {
+    return (bits + LeafBits - 1) / LeafBits;
+  }
+
+  //! Returns the index of an empty leaf.
+  [[nodiscard]] size_t new_leaf() {
+    size_t index;
+    if (free_leaves_.empty()) {
+      index = leaves_.size();
+      leaves_.emplace_back();
+    } else {
+      index = free_leaves_.back();
+      free_leaves_.pop_back();
+    }
+    leaves_[index].words.fill(0ULL);
+    leaves_[index].size = 0;
+    leaves_[index].ones = 0;
+    return index;
+  }
+
+  //! Returns the index of an empty inner node.
+  [[nodiscard]] size_t new_node() {
+    size_t index;
+    if (free_nodes_.empty()) {
+      index = nodes_.size();
+      nodes_.emplace_back();
+    } else {
+      index = free_nodes_.back();
+      free_nodes_.pop_back();
+    }
+    nodes_[index].children_count = 0;
+    return index;
+  }
+
+  /*!
+   * \brief Finds the leaf containing a position and records the path to it.
+   *
+   * \param position Position that is looked for. Afterwards, it is the
+   * position within the leaf.
+   * \param path Visited nodes and children.
+   * \return Index of the leaf.
+   */
+  [[nodiscard]] size_t
+  find_leaf(size_t& position,
+            std::array<PathEntry, MaxHeight>& path) const noexcept {
+    size_t node = root_;
+    for (size_t h = 0; h < height_; ++h) {
+      Node const& n = nodes_[node];
+      size_t i = 0;
+      while (i + 1 < n.children_count && position >= n.sizes[i]) {
+        position -= n.sizes[i++];
+      }
+      path[h] = PathEntry{node, i};
+      node = n.children[i];
+    }
+    return node;
+  }
+
+  //! Position of the rank-th one or zero (depending on \c Bit).
+  template <bool Bit>
+  [[nodiscard]] size_t select(size_t rank) const noexcept {
+    if (rank == 0 || rank > (Bit ? ones_ : size_ - ones_)) {
+      return size_;
+    }
+    size_t result = 0;
+    size_t node = root_;
+    for (size_t h = 0; h < height_; ++h) {
+      Node const& n = nodes_[node];
+      size_t i = 0;
+      while (true) {
+        size_t const count = Bit ? n.ones[i] : n.sizes[i] - n.ones[i];
+        if (rank <= count) {
+          break;
+        }
+        rank -= count;
+        result += n.sizes[i++];
+      }
+      node = n.children[i];
+    }
+    Leaf const& leaf = leaves_[node];
+    size_t w = 0;
+    uint64_t word = Bit ? leaf.words[0] : ~leaf.words[0];
+    for (size_t count; (count = std::popcount(word)) < rank;) {
+      rank -= count;
+      ++w;
+      word = Bit ? leaf.words[w] : ~leaf.words[w];
+    }
+    return result + (w * 64) + pasta::select(word, rank - 1);
+  }
+
+  //! Inserts a bit into a leaf that is not full.
+  static void
+  leaf_insert(Leaf& leaf, size_t const position, bool const bit) noexcept {
+    size_t const word = position / 64;
+    size_t const offset = position % 64;
+    for (size_t w = leaf.size / 64; w > word; --w) {
+      leaf.words[w] = (leaf.words[w] << 1) | (leaf.words[w - 1] >> 63);
+    }
+    uint64_t const low_mask = (1ULL << offset) - 1;
+    uint64_t const value = leaf.words[word];
+    leaf.words[word] = (value & low_mask) | ((value & ~low_mask) << 1) |
+                       (static_cast<uint64_t>(bit) << offset);
+    ++leaf.size;
+    leaf.ones += bit;
+  }
+
+  //! Removes a bit from a leaf.
+  static void leaf_erase(Leaf& leaf, size_t const position) noexcept {
+    size_t const word = position / 64;
+    size_t const offset = position % 64;
+    uint64_t const low_mask = (1ULL << offset) - 1;
+    uint64_t const value = leaf.words[word];
+    leaf.ones -= (value >> offset) & 1ULL;
+    leaf.words[word] = (value & low_mask) | ((value >> 1) & ~low_mask);
+    size_t const last_word = (leaf.size - 1) / 64;
+    for (size_t w = word; w < last_word; ++w) {
+      leaf.words[w] |= leaf.words[w + 1] << 63;
+      leaf.words[w + 1] >>= 1;
+    }
+    --leaf.size;
+  }
+
+  /*!
+   * \brief Inserts a new child after the child on the path at a level, whose
+   * sizes are updated. Full nodes are split, which may propagate up to the
+   * root.
+   */
+  void insert_child(std::array<PathEntry, MaxHeight> const& path,
+                    size_t level, size_t left_size, size_t left_ones,
+                    size_t child, size_t child_size, size_t child_ones) {
+    while (true) {
+      size_t const node = path[level].node;
+      size_t const position = path[level].child;
+      {
+        Node& n = nodes_[node];
+        n.sizes[position] = left_size;
+        n.ones[position] = left_ones;
+        if (n.children_count < Fanout) {
+          for (size_t i = n.children_count; i > position + 1; --i) {
+            n.sizes[i] = n.sizes[i - 1];
+            n.ones[i] = n.ones[i - 1];
+            n.children[i] = n.children[i - 1];
+          }
+          n.sizes[position + 1] = child_size;
+          n.ones[position + 1] = child_ones;
+          n.children[position + 1] = child;
+          ++n.children_count;
+          return;
+        }
+      }
+
+      // Split the full node: collect all children (including the new one)
+      // and distribute them evenly.
+      std::array<size_t, Fanout + 1> sizes;
+      std::array<size_t, Fanout + 1> ones;
+      std::array<size_t, Fanout + 1> children;
+      {
+        Node const& n = nodes_[node];
+        for (size_t i = 0, j = 0; i < Fanout; ++i, ++j) {
+          sizes[j] = n.sizes[i];
+          ones[j] = n.ones[i];
+          children[j] = n.children[i];
+          if (i == position) {
+            ++j;
+            sizes[j] = child_size;
+            ones[j] = child_ones;
+            children[j] = child;
+          }
+        }
+      }
+      size_t const right = new_node();
+      Node& left_node = nodes_[node];
+      Node& right_node = nodes_[right];
+      size_t const left_count = (Fanout + 1) / 2;
+      left_node.children_count = left_count;
+      right_node.children_count = Fanout + 1 - left_count;
+      left_size = left_ones = child_size = child_ones = 0;
+      for (size_t i = 0; i < Fanout + 1; ++i) {
+        Node& target = (i < left_count) ? left_node : right_node;
+        size_t const index = (i < left_count) ? i : i - left_count;
+        target.sizes[index] = sizes[i];
+        target.ones[index] = ones[i];
+        target.children[index] = children[i];
+        if (i < left_count) {
+          left_size += sizes[i];
+          left_ones += ones[i];
+        } else {
+          child_size += sizes[i];
+          child_ones += ones[i];
+        }
+      }
+      child = right;
+
+      if (level == 0) {
+        // The root has been split: add a new root.
+        size_t const new_root = new_node();
+        Node& root = nodes_[new_root];
+        root.children_count = 2;
+        root.sizes[0] = left_size;
+        root.ones[0] = left_ones;
+        root.children[0] = node;
+        root.sizes[1] = child_size;
+        root.ones[1] = child_ones;
+        root.children[1] = child;
+        root_ = new_root;
+        ++height_;
+        return;
+      }
+      --level;
+    }
+  }
+
+  /*!
+   * \brief Merges underfull leaves and nodes on the path with a neighbor,
+   * if the result fits into one leaf (node), and shrinks the tree, if the root
+   * has only one child.
+   */
+  void rebalance(std::array<PathEntry, MaxHeight> const& path) {
+    for (size_t level = height_; level-- > 0;) {
+      Node& parent = nodes_[path[level].node];
+      size_t const position = path[level].child;
+      bool const leaves = (level + 1 == height_);
+      size_t const child = parent.children[position];
+      size_t const child_fill =
+          leaves ? leaves_[child].size : nodes_[child].children_count;
+      size_t const capacity = leaves ? LeafBits : Fanout;
+      if (parent.children_count < 2 || child_fill >= capacity / 4) {
+        break;
+      }
+      // Merge with the right neighbor (or the left one, if there is none).
+      size_t const left_position =
+          (position + 1 < parent.children_count) ? position : position - 1;
+      size_t const left = parent.children[left_position];
+      size_t const right = parent.children[left_position + 1];
+      if (leaves) {
+        Leaf& left_leaf = leaves_[left];
+        Leaf const& right_leaf = leaves_[right];
+        if (left_leaf.size + right_leaf.size > LeafBits) {
+          break;
+        }
+        append_leaf(left_leaf, right_leaf);
+        free_leaves_.push_back(right);
+      } else {
+        Node& left_node = nodes_[left];
+        Node const& right_node = nodes_[right];
+        if (left_node.children_count + right_node.children_count > Fanout) {
+          break;
+        }
+        for (size_t i = 0; i < right_node.children_count; ++i) {
+          left_node.sizes[left_node.children_count] = right_node.sizes[i];
+          left_node.ones[left_node.children_count] = right_node.ones[i];
+          left_node.children[left_node.children_count++] =
+              right_node.children[i];
+        }
+        free_nodes_.push_back(right);
+      }
+      parent.sizes[left_position] += parent.sizes[left_position + 1];
+      parent.ones[left_position] += parent.ones[left_position + 1];
+      for (size_t i = left_position + 1; i + 1 < parent.children_count; ++i) {
+        parent.sizes[i] = parent.sizes[i + 1];
+        parent.ones[i] = parent.ones[i + 1];
+        parent.children[i] = parent.children[i + 1];
+      }
+      --parent.children_count;
+    }
+    while (height_ > 1 && nodes_[root_].children_count == 1) {
+      free_nodes_.push_back(root_);
+      root_ = nodes_[root_].children[0];
+      --height_;
+    }
+  }
+
+  //! Appends all bits of \c source to \c target (which must have room).
+  static void append_leaf(Leaf& target, Leaf const& source) noexcept {
+    size_t const offset = target.size % 64;
+    size_t const word = target.size / 64;
+    size_t const source_words = (source.size + 63) / 64;
+    if (offset == 0) {
+      for (size_t w = 0; w < source_words; ++w) {
+        target.words[word + w] = source.words[w];
+      }
+    } else {
+      for (size_t w = 0; w < source_words; ++w) {
+        target.words[word + w] |= source.words[w] << offset;
+        if (word + w + 1 < LeafWords) {
+          target.words[word + w + 1] = source.words[w] >> (64 - offset);
+        }
+      }
+    }
+    target.size += source.size;
+    target.ones += source.ones;
+  }
+}; // class DynamicBitVector
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -70,19 +70,19 @@ namespace pasta {
 template <OptimizedFor optimized_for = OptimizedFor::DONT_CARE,
           FindL2FlatWith find_with = FindL2FlatWith::LINEAR_SEARCH,
           typename VectorType = BitVector>
-class FlatRankSelect final : public FlatRank<optimized_for> {
+class FlatRankSelect final : public FlatRank<optimized_for, VectorType> {
   //! Get access to protected members of base class, as dependent
   //! names are not considered.
-  using FlatRank<optimized_for>::data_size_;
+  using FlatRank<optimized_for, VectorType>::data_size_;
   //! Get access to protected members of base class, as dependent
   //! names are not considered.
-  using FlatRank<optimized_for>::data_;
+  using FlatRank<optimized_for, VectorType>::data_;
   //! Get access to protected members of base class, as dependent
   //! names are not considered.
-  using FlatRank<optimized_for>::l12_;
+  using FlatRank<optimized_for, VectorType>::l12_;
   //! Get access to protected members of base class, as dependent
   //! names are not considered.
-  using FlatRank<optimized_for>::l12_end_;
+  using FlatRank<optimized_for, VectorType>::l12_end_;
 
   template <typename T>
   using Array = tlx::SimpleVector<T, tlx::SimpleVectorMode::NoInitNoDestroy>;
@@ -59,19 +59,19 @@ namespace pasta {
 template <OptimizedFor optimized_for = OptimizedFor::DONT_CARE,
           FindL2WideWith find_with = FindL2WideWith::LINEAR_SEARCH,
           typename VectorType = BitVector>
-class WideRankSelect : public WideRank<optimized_for> {
+class WideRankSelect : public WideRank<optimized_for, VectorType> {
   //! Get access to protected members of base class, as dependent
   //! names are not considered.
-  using WideRank<optimized_for>::data_size_;
+  using WideRank<optimized_for, VectorType>::data_size_;
   //! Get access to protected members of base class, as dependent
   //! names are not considered.
-  using WideRank<optimized_for>::data_;
+  using WideRank<optimized_for, VectorType>::data_;
   //! Get access to protected members of base class, as dependent
   //! names are not considered.
-  using WideRank<optimized_for>::l1_;
+  using WideRank<optimized_for, VectorType>::l1_;
   //! Get access to protected members of base class, as dependent
   //! names are not considered.
-  using WideRank<optimized_for>::l2_;
+  using WideRank<optimized_for, VectorType>::l2_;
 
   template <typename T>
   using Array = tlx::SimpleVector<T, tlx::SimpleVectorMode::NoInitNoDestroy>;
@@ -136,9 +136,13 @@ public:
     l2_pos = std::max(l1_pos * 128, l2_pos);
 
     if constexpr (use_linear_search(find_with)) {
+      // The L2-blocks are relative to their L1-block, i.e., the search must
+      // not continue in the next L1-block.
+      size_t const l2_block_end = std::min((l1_pos + 1) * 128, l2_end);
       if constexpr (optimize_one_or_dont_care(optimized_for)) {
-        size_t added = 0;
-        while (l2_pos + 1 < l2_end &&
+        // The search may start after the first L2-block of the L1-block.
+        size_t added = l2_pos - (l1_pos * 128);
+        while (l2_pos + 1 < l2_block_end &&
                ((added + 1) * WideRankSelectConfig::L2_BIT_SIZE) -
                        l2_[l2_pos + 1] <
                    rank) {
@@ -147,7 +151,7 @@ public:
         }
         rank -= (added * WideRankSelectConfig::L2_BIT_SIZE) - l2_[l2_pos];
       } else {
-        while (l2_pos + 1 < l2_end && l2_[l2_pos + 1] < rank) {
+        while (l2_pos + 1 < l2_block_end && l2_[l2_pos + 1] < rank) {
           ++l2_pos;
         }
         rank -= l2_[l2_pos];
@@ -255,14 +259,18 @@ public:
     l2_pos = std::max(l1_pos * 128, l2_pos);
 
     if constexpr (use_linear_search(find_with)) {
+      // The L2-blocks are relative to their L1-block, i.e., the search must
+      // not continue in the next L1-block.
+      size_t const l2_block_end = std::min((l1_pos + 1) * 128, l2_end);
       if constexpr (optimize_one_or_dont_care(optimized_for)) {
-        while (l2_pos + 1 < l2_end && l2_[l2_pos + 1] < rank) {
+        while (l2_pos + 1 < l2_block_end && l2_[l2_pos + 1] < rank) {
           ++l2_pos;
         }
         rank -= l2_[l2_pos];
       } else {
-        size_t added = 0;
-        while (l2_pos + 1 < l2_end &&
+        // The search may start after the first L2-block of the L1-block.
+        size_t added = l2_pos - (l1_pos * 128);
+        while (l2_pos + 1 < l2_block_end &&
                ((added + 1) * WideRankSelectConfig::L2_BIT_SIZE) -
                        l2_[l2_pos + 1] <
                    rank) {
@@ -344,10 +344,46 @@ void resize_test() {
   }
 }
 
+void move_test() {
+  size_t const N = 1'000;
+
+  // The moved-to bit vector owns the data, the moved-from one is empty
+  {
+    pasta::BitVector bv(N, 1);
+    pasta::BitVector moved(std::move(bv));
+    die_unequal(moved.size(), N);
+    for (size_t i = 0; i < N; ++i) {
+      die_unequal(bool{moved[i]}, bool{1});
+    }
+    die_unequal(bv.size(), size_t{0});
+    die_unless(bv.data().empty());
+    die_unless(bv.begin() == bv.end());
+  }
+  {
+    pasta::BitVector bv(N, 1);
+    pasta::BitVector moved(2 * N, 0);
+    moved = std::move(bv);
+    die_unequal(moved.size(), N);
+    for (size_t i = 0; i < N; ++i) {
+      die_unequal(bool{moved[i]}, bool{1});
+    }
+    die_unequal(bv.size(), size_t{0});
+    die_unless(bv.data().empty());
+
+    // The moved-from bit vector can be reused
+    bv.resize(N, 0);
+    for (size_t i = 0; i < N; ++i) {
+      die_unequal(bool{bv[i]}, bool{0});
+      die_unequal(bool{moved[i]}, bool{1});
+    }
+  }
+}
+
 int32_t main() {
   direct_access_test();
   iterator_test();
   resize_test();
+  move_test();
 
   return 0;
 }
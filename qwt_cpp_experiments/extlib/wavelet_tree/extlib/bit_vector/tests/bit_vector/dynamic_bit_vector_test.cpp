@@ -0,0 +1,108 @@
+/*******************************************************************************
+ * dynamic_bit_vector_test.cpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * PaStA is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PaStA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PaStA.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <pasta/bit_vector/bit_vector.hpp>
+#include <pasta/bit_vector/dynamic_bit_vector.hpp>
+#include <random>
+#include <tlx/die.hpp>
+#include <vector>
+
+template <typename DynamicBitVector>
+void compare(DynamicBitVector const& dbv, std::vector<bool> const& content) {
+  die_unequal(dbv.size(), content.size());
+  size_t ones = 0;
+  for (size_t i = 0; i < content.size(); ++i) {
+    die_unequal(dbv[i], content[i]);
+    die_unequal(dbv.rank1(i), ones);
+    die_unequal(dbv.rank0(i), i - ones);
+    if (content[i]) {
+      ++ones;
+      die_unequal(dbv.select1(ones), i);
+    } else {
+      die_unequal(dbv.select0(i + 1 - ones), i);
+    }
+  }
+  die_unequal(dbv.rank1(content.size()), ones);
+  die_unequal(dbv.ones(), ones);
+  die_unequal(dbv.select1(ones + 1), content.size());
+  die_unequal(dbv.select0(content.size() - ones + 1), content.size());
+}
+
+template <typename DynamicBitVector>
+void random_updates_test(size_t const initial_size) {
+  std::mt19937 gen(initial_size);
+  std::uniform_int_distribution<size_t> bit_dist(0, 1);
+
+  pasta::BitVector bv(initial_size);
+  std::vector<bool> content(initial_size);
+  for (size_t i = 0; i < initial_size; ++i) {
+    bv[i] = content[i] = bit_dist(gen);
+  }
+  DynamicBitVector dbv(bv);
+  compare(dbv, content);
+
+  // Grow the bit vector, then shrink it (to trigger merges), and grow it
+  // again, while setting random bits.
+  for (size_t const target : {initial_size + 4'000, size_t{100},
+                              initial_size + 1'000}) {
+    while (content.size() != target) {
+      std::uniform_int_distribution<size_t> pos_dist(0, content.size());
+      size_t const position = pos_dist(gen);
+      if (content.size() < target) {
+        bool const bit = bit_dist(gen);
+        dbv.insert(position, bit);
+        content.insert(content.begin() + position, bit);
+      } else if (position < content.size()) {
+        dbv.erase(position);
+        content.erase(content.begin() + position);
+      }
+      if (!content.empty() && content.size() % 7 == 0) {
+        std::uniform_int_distribution<size_t> set_dist(0, content.size() - 1);
+        size_t const set_position = set_dist(gen);
+        bool const bit = bit_dist(gen);
+        dbv.set(set_position, bit);
+        content[set_position] = bit;
+      }
+    }
+    compare(dbv, content);
+  }
+}
+
+int32_t main() {
+  // Small leaves and nodes result in a high tree with many splits and merges.
+  random_updates_test<pasta::DynamicBitVector<2, 4>>(0);
+  random_updates_test<pasta::DynamicBitVector<2, 4>>(10'000);
+  random_updates_test<pasta::DynamicBitVector<>>(0);
+  random_updates_test<pasta::DynamicBitVector<>>(23'457);
+
+  {
+    pasta::DynamicBitVector<> dbv;
+    std::vector<bool> content;
+    for (size_t i = 0; i < 100'000; ++i) {
+      dbv.push_back(i % 3 == 0);
+      content.push_back(i % 3 == 0);
+    }
+    compare(dbv, content);
+  }
+
+  return 0;
+}
+
+/******************************************************************************/
@@ -19,6 +19,7 @@
  ******************************************************************************/
 
 #include <cstdint>
+#include <random>
 #include <pasta/bit_vector/bit_vector.hpp>
 #include <pasta/bit_vector/support/find_l2_wide_with.hpp>
 #include <pasta/bit_vector/support/wide_rank_select.hpp>
@@ -143,6 +144,33 @@ int32_t main() {
       }
     }
   });
+
+  // Random bits, such that the searched L2-block is the last one of its
+  // L1-block or the search starts after the first L2-block of the L1-block.
+  {
+    std::mt19937 mersenne_engine(42);
+    std::uniform_int_distribution<uint64_t> dist(0, 1);
+    size_t const N = (1ULL << 18) + 723;
+    pasta::BitVector bv(N, 0);
+    size_t ones = 0;
+    for (size_t i = 0; i < N; ++i) {
+      bv[i] = dist(mersenne_engine);
+      ones += bv[i];
+    }
+    pasta::WideRankSelect<pasta::OptimizedFor::DONT_CARE,
+                          pasta::FindL2WideWith::LINEAR_SEARCH>
+        bvrs(bv);
+    for (size_t i = 1; i <= ones; ++i) {
+      size_t const pos = bvrs.select1(i);
+      die_unless(bv[pos]);
+      die_unequal(i - 1, bvrs.rank1(pos));
+    }
+    for (size_t i = 1; i <= N - ones; ++i) {
+      size_t const pos = bvrs.select0(i);
+      die_unless(!bv[pos]);
+      die_unequal(i - 1, bvrs.rank0(pos));
+    }
+  }
   return 0;
 }
 
@@ -0,0 +1,277 @@
+/*******************************************************************************
+ * This file is part of pasta::utils.
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::utils.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__)
+#  include <immintrin.h>
+#endif
+
+#include <tlx/math/div_ceil.hpp>
+#include <tlx/thread_pool.hpp>
+
+namespace pasta {
+
+//! \addtogroup pasta_utils
+//! \{
+
+//! Histogram of a byte text.
+using ByteHistogram = std::array<size_t, 256>;
+
+//! Mapping of bytes to bytes, e.g., to the effective alphabet.
+using ByteMapping = std::array<uint8_t, 256>;
+
+/*!
+ * \brief Runs a function on (at most) \c threads consecutive chunks of
+ * [0, \c size) in parallel.
+ *
+ * \param size Number of elements that are split into chunks.
+ * \param threads Number of threads. If at most one, the function is called
+ * once for the whole interval in the calling thread.
+ * \param function Function called with the thread number and the interval
+ * [begin, end) of the chunk.
+ */
+template <typename Function>
+void for_each_chunk(size_t const size,
+                    size_t const threads,
+                    Function&& function) {
+  // Chunks should not be tiny, as starting the threads is more expensive
+  // than processing a few kilobytes.
+  size_t const chunks = std::max<size_t>(
+      1, std::min<size_t>(threads, tlx::div_ceil(size, size_t{1} << 16)));
+  if (chunks == 1) {
+    function(size_t{0}, size_t{0}, size);
+    return;
+  }
+  size_t const chunk_size = tlx::div_ceil(size, chunks);
+  tlx::ThreadPool pool(chunks);
+  for (size_t i = 0; i < chunks; ++i) {
+    pool.enqueue([&, i]() {
+      function(i, std::min(size, i * chunk_size),
+               std::min(size, (i + 1) * chunk_size));
+    });
+  }
+  pool.loop_until_empty();
+}
+
+/*!
+ * \brief Computes the histogram of a byte text.
+ *
+ * Each thread counts the symbols of one chunk of the text. Within a chunk,
+ * consecutive symbols are counted in four different tables, such that runs
+ * of equal symbols do not result in a chain of dependent increments of the
+ * same counter (which cannot be forwarded from the store buffer fast
+ * enough). The tables are summed up in the end.
+ *
+ * \param text Pointer to the first symbol of the text.
+ * \param size Number of symbols.
+ * \param threads Number of threads used to compute the histogram.
+ * \return Histogram of the text.
+ */
+[[nodiscard("Histogram computed but not used")]] inline ByteHistogram
+byte_histogram(uint8_t const* const text,
+               size_t const size,
+               size_t const threads = 1) {
+  std::vector<ByteHistogram> hists(std::max<size_t>(1, threads));
+  for_each_chunk(
+      size, threads, [&](size_t const thread, size_t begin, size_t const end) {
+        std::array<ByteHistogram, 4> tables = {};
+        for (; begin + 4 <= end; begin += 4) {
+          ++tables[0][text[begin]];
+          ++tables[1][text[begin + 1]];
+          ++tables[2][text[begin + 2]];
+          ++tables[3][text[begin + 3]];
+        }
+        for (; begin < end; ++begin) {
+          ++tables[0][text[begin]];
+        }
+        for (size_t symbol = 0; symbol < 256; ++symbol) {
+          hists[thread][symbol] = tables[0][symbol] + tables[1][symbol] +
+                                  tables[2][symbol] + tables[3][symbol];
+        }
+      });
+  ByteHistogram hist = {0};
+  for (auto const& thread_hist : hists) {
+    for (size_t symbol = 0; symbol < 256; ++symbol) {
+      hist[symbol] += thread_hist[symbol];
+    }
+  }
+  return hist;
+}
+
+/*!
+ * \brief Checks (once) whether the CPU supports the AVX2 remap kernel.
+ *
+ * The kernel is compiled for AVX2 independent of the compiler flags, thus,
+ * it can only be used if this returns true.
+ */
+[[nodiscard]] inline bool remap_bytes_simd_supported() noexcept {
+#if defined(__x86_64__) && defined(__GNUC__)
+  static bool const supported = __builtin_cpu_supports("avx2");
+  return supported;
+#else
+  return false;
+#endif
+}
+
+/*!
+ * \brief Replaces each symbol of a byte text by its mapping (one table
+ * lookup per symbol).
+ *
+ * \param text Pointer to the first symbol of the text.
+ * \param size Number of symbols.
+ * \param mapping Mapping of the symbols.
+ */
+inline void remap_bytes_scalar(uint8_t* const text,
+                               size_t const size,
+                               ByteMapping const& mapping) noexcept {
+  for (size_t i = 0; i < size; ++i) {
+    text[i] = mapping[text[i]];
+  }
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+/*!
+ * \brief Replaces each symbol of a byte text by its mapping (see
+ * \ref remap_bytes_scalar()) 32 symbols at a time.
+ *
+ * The mapping is split into 16 tables of 16 entries, one for each value of
+ * the high nibble of the symbols. The low nibbles are looked up in a table
+ * using \c pshufb and the result is blended into the mapped symbols where the
+ * high nibble matches the table. Only tables of high nibbles that occur in
+ * the text are used, e.g., two for DNA and about eight for ASCII texts.
+ *
+ * \param text Pointer to the first symbol of the text.
+ * \param size Number of symbols.
+ * \param mapping Mapping of the symbols.
+ * \param hist Histogram of the text, used to skip unused tables.
+ */
+__attribute__((target("avx2"))) inline void
+remap_bytes_avx2(uint8_t* const text,
+                 size_t const size,
+                 ByteMapping const& mapping,
+                 ByteHistogram const& hist) noexcept {
+  __m256i tables[16];
+  __m256i high_nibbles[16];
+  size_t used_tables = 0;
+  for (size_t high = 0; high < 16; ++high) {
+    if (std::any_of(hist.begin() + (high * 16), hist.begin() + (high + 1) * 16,
+                    [](size_t const occ) { return occ > 0; })) {
+      tables[used_tables] = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+          reinterpret_cast<__m128i const*>(mapping.data() + (high * 16))));
+      high_nibbles[used_tables++] =
+          _mm256_set1_epi8(static_cast<char>(high));
+    }
+  }
+
+  __m256i const low_nibble_mask = _mm256_set1_epi8(0x0F);
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i const symbols =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(text + i));
+    __m256i const low = _mm256_and_si256(symbols, low_nibble_mask);
+    __m256i const high =
+        _mm256_and_si256(_mm256_srli_epi16(symbols, 4), low_nibble_mask);
+    __m256i mapped = _mm256_setzero_si256();
+    for (size_t j = 0; j < used_tables; ++j) {
+      mapped = _mm256_blendv_epi8(mapped,
+                                  _mm256_shuffle_epi8(tables[j], low),
+                                  _mm256_cmpeq_epi8(high, high_nibbles[j]));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(text + i), mapped);
+  }
+  remap_bytes_scalar(text + i, size - i, mapping);
+}
+#endif
+
+/*!
+ * \brief Replaces each symbol of a byte text by its mapping in parallel,
+ * using the AVX2 kernel if supported by the CPU.
+ *
+ * \param text Pointer to the first symbol of the text.
+ * \param size Number of symbols.
+ * \param mapping Mapping of the symbols.
+ * \param hist Histogram of the text (only symbols that occur are mapped).
+ * \param threads Number of threads.
+ */
+inline void remap_bytes(uint8_t* const text,
+                        size_t const size,
+                        ByteMapping const& mapping,
+                        ByteHistogram const& hist,
+                        size_t const threads = 1) {
+  for_each_chunk(
+      size, threads, [&](size_t, size_t const begin, size_t const end) {
+#if defined(__x86_64__) && defined(__GNUC__)
+        if (remap_bytes_simd_supported()) {
+          remap_bytes_avx2(text + begin, end - begin, mapping, hist);
+          return;
+        }
+#endif
+        remap_bytes_scalar(text + begin, end - begin, mapping);
+      });
+}
+
+/*!
+ * \brief Reduces the alphabet of a byte text to its effective alphabet (see
+ * \ref reduce_alphabet()) using \ref byte_histogram() and
+ * \ref remap_bytes().
+ *
+ * \param begin Pointer to the first symbol of the text.
+ * \param end Pointer after the last symbol of the text.
+ * \param alphabet_mapping_out Optional pointer to an array which is filled
+ * with the mapping to (potentially) reverse the alphabet reduction.
+ * \param threads Number of threads.
+ * \param smallest_symbol The smallest symbol used in the effective alphabet.
+ * \return Size of the alphabet. If there is a smallest symbol, this is
+ * smallest symbol plus alphabet size.
+ */
+inline size_t
+reduce_byte_alphabet(uint8_t* const begin,
+                     uint8_t* const end,
+                     ByteHistogram* const alphabet_mapping_out = nullptr,
+                     size_t const threads = 1,
+                     size_t smallest_symbol = 0) {
+  size_t const size = end - begin;
+  ByteHistogram const hist = byte_histogram(begin, size, threads);
+  ByteMapping mapping = {0};
+  ByteHistogram alphabet_mapping = {0};
+  for (size_t symbol = 0; symbol < 256; ++symbol) {
+    if (hist[symbol] > 0) {
+      alphabet_mapping[symbol] = smallest_symbol;
+      mapping[symbol] = static_cast<uint8_t>(smallest_symbol++);
+    }
+  }
+  remap_bytes(begin, size, mapping, hist, threads);
+  if (alphabet_mapping_out != nullptr) {
+    *alphabet_mapping_out = alphabet_mapping;
+  }
+  return smallest_symbol;
+}
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -0,0 +1,428 @@
+/*******************************************************************************
+ * pasta/wavelet_tree/appendable_wavelet_matrix.hpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::wavelet_tree is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::wavelet_tree is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::wavelet_tree.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "pasta/wavelet_tree/wavelet_tree.hpp"
+
+namespace pasta {
+
+//! \addtogroup pasta_wavelet_trees
+//! \{
+
+/*!
+ * \brief Statistics about the merges of an \ref AppendableWaveletMatrix.
+ */
+struct MergeStatistics {
+  //! Number of merges that have been completed.
+  size_t merges = 0;
+  //! Total number of symbols in all merged segments.
+  size_t merged_symbols = 0;
+  //! Total time (in nanoseconds) spent merging, including decoding the
+  //! merged segments and building the new segment.
+  size_t merge_time_ns = 0;
+}; // struct MergeStatistics
+
+/*!
+ * \brief Wavelet matrix supporting appending symbols at the end of the text.
+ *
+ * New symbols are appended to a small write buffer. When the buffer is full,
+ * it is frozen into a static wavelet matrix (a segment). Segments are merged
+ * log-structured: whenever a segment is not larger than all newer segments
+ * combined, these segments are merged into one. Thus, segment sizes grow
+ * geometrically and there are O(log n) segments. Merges decode the merged
+ * segments (using \c extract()) and build a new wavelet matrix, which can be
+ * done in the background while further symbols are appended. A finished
+ * merge is installed during the next append (or \ref wait_for_merge()). If
+ * there are too many segments, appending waits for the running merge.
+ *
+ * Queries are answered by all segments and the buffer. For each segment, the
+ * histogram of its symbols is stored, such that only one segment has to be
+ * queried for rank and select queries.
+ *
+ * Appends and queries must not be called concurrently.
+ *
+ * \tparam BitVectorType Type of bit vector used to represent the levels.
+ * \tparam Symbol Type of characters in the text.
+ */
+template <typename BitVectorType, typename Symbol>
+class AppendableWaveletMatrix {
+  //! Type of the static wavelet matrices of the segments.
+  using WaveletMatrix =
+      WaveletBase<BitVectorType, Symbol, WaveletTypes::MATRIX>;
+
+  /*!
+   * \brief Static part of the text.
+   */
+  struct Segment {
+    //! Wavelet matrix of the segment's symbols.
+    WaveletMatrix wm;
+    //! First position of the segment in the text.
+    size_t offset;
+    //! Number of symbols in the segment.
+    size_t size;
+    //! Number of occurrences of each symbol in the segment.
+    std::vector<size_t> histogram;
+  }; // struct Segment
+
+  //! Result of a merge, which is computed asynchronously.
+  struct MergeResult {
+    //! The new segment replacing the merged segments.
+    std::unique_ptr<Segment> segment;
+    //! Time spent for the merge.
+    size_t time_ns;
+  }; // struct MergeResult
+
+  //! Number of segments at which appending waits for the running merge, so
+  //! that queries do not have to visit too many segments if merges cannot
+  //! keep up with appends.
+  static constexpr size_t MaxSegments = 64;
+
+  //! Size of the alphabet of the text.
+  size_t alphabet_size_;
+  //! Maximum number of symbols in the write buffer.
+  size_t buffer_size_;
+  //! Whether merges are computed in the background.
+  bool background_merge_;
+
+  //! Segments ordered by their position in the text. The segments are
+  //! stored as pointers, so that running merges can access them, while new
+  //! segments are added.
+  std::vector<std::unique_ptr<Segment>> segments_;
+  //! Write buffer containing the last symbols of the text.
+  std::vector<Symbol> buffer_;
+  //! Number of symbols in all segments, i.e., first position of the buffer.
+  size_t buffer_offset_ = 0;
+
+  //! Currently running merge (if valid).
+  std::future<MergeResult> merge_;
+  //! First segment of the running merge.
+  size_t merge_first_ = 0;
+  //! Number of segments of the running merge.
+  size_t merge_count_ = 0;
+  //! Statistics about all finished merges.
+  MergeStatistics merge_statistics_;
+
+public:
+  /*!
+   * \brief Constructor. Creates an empty appendable wavelet matrix.
+   *
+   * \param alphabet_size Size of the alphabet, i.e., all appended symbols
+   * must be smaller than \c alphabet_size.
+   * \param buffer_size Number of symbols in the write buffer before it is
+   * frozen into a segment.
+   * \param background_merge Whether merges are computed in the background
+   * (\c true) or immediately when they are required (\c false).
+   */
+  AppendableWaveletMatrix(size_t const alphabet_size,
+                          size_t const buffer_size = 4096,
+                          bool const background_merge = true)
+      : alphabet_size_(alphabet_size),
+        buffer_size_(std::max(size_t{1}, buffer_size)),
+        background_merge_(background_merge) {
+    buffer_.reserve(buffer_size_);
+  }
+
+  //! Waits for the running merge (if any) before destroying the segments.
+  ~AppendableWaveletMatrix() {
+    if (merge_.valid()) {
+      merge_.wait();
+    }
+  }
+
+  /*!
+   * \brief Appends a symbol at the end of the text.
+   *
+   * \param symbol Symbol that is appended.
+   */
+  void append(Symbol const symbol) {
+    buffer_.push_back(symbol);
+    if (buffer_.size() >= buffer_size_) {
+      freeze();
+    }
+  }
+
+  /*!
+   * \brief Appends symbols at the end of the text.
+   *
+   * \tparam InputIterator Iterator type of the appended symbols.
+   * \param begin Iterator to the first appended symbol.
+   * \param end Iterator marking the end of the appended symbols.
+   */
+  template <std::input_iterator InputIterator>
+  void append(InputIterator begin, InputIterator const end) {
+    for (; begin != end; ++begin) {
+      append(*begin);
+    }
+  }
+
+  /*!
+   * \brief Freezes the write buffer into a new segment (if it is not empty)
+   * and starts merges, if required.
+   */
+  void freeze() {
+    install_merge(segments_.size() >= MaxSegments);
+    if (!buffer_.empty()) {
+      segments_.push_back(make_segment(buffer_, buffer_offset_));
+      buffer_offset_ += buffer_.size();
+      buffer_.clear();
+    }
+    schedule_merge();
+  }
+
+  //! Waits for all running and required merges and installs them.
+  void wait_for_merge() {
+    while (merge_.valid()) {
+      install_merge(true);
+      schedule_merge();
+    }
+  }
+
+  /*!
+   * \brief Access operator to access characters of the text.
+   *
+   * \param position Position of the character that should be retrieved.
+   * \return Character at position \c position.
+   */
+  [[nodiscard("Wavelet matrix accessed but result not used")]] Symbol
+  operator[](size_t const position) const noexcept {
+    if (position >= buffer_offset_) {
+      return buffer_[position - buffer_offset_];
+    }
+    auto const it = std::upper_bound(
+        segments_.begin(), segments_.end(), position,
+        [](size_t const pos, std::unique_ptr<Segment> const& segment) {
+          return pos < segment->offset;
+        });
+    Segment const& segment = **(it - 1);
+    return segment.wm[position - segment.offset];
+  }
+
+  /*!
+   * \brief Computes rank-queries, i.e., the number of occurrences of a symbol
+   * before a position.
+   *
+   * \param position Position up to which the occurrences are counted.
+   * \param symbol Symbol whose occurrences are counted.
+   * \return Number of occurrences of \c symbol before \c position.
+   */
+  [[nodiscard("Wavelet matrix rank computed but result not used")]] size_t
+  rank(size_t const position, Symbol const symbol) const noexcept {
+    size_t result = 0;
+    for (auto const& segment : segments_) {
+      if (position >= segment->offset + segment->size) {
+        result += segment->histogram[symbol];
+      } else {
+        return result + segment->wm.rank(position - segment->offset, symbol);
+      }
+    }
+    return result + std::count(buffer_.begin(),
+                               buffer_.begin() + (position - buffer_offset_),
+                               symbol);
+  }
+
+  /*!
+   * \brief Computes the position a symbol with a specific rank, i.e., the
+   * rank-th occurrence of a symbol.
+   *
+   * \param rank The rank of the symbol that is looked for.
+   * \param symbol The symbol the position of the rank-th occurrence is looked
+   * for.
+   * \return Position of the \c rank-th occurrence of \c symbol or the size
+   * of the text, if there is no such occurrence.
+   */
+  [[nodiscard("Wavelet matrix select computed but result not used")]] size_t
+  select(size_t rank, Symbol const symbol) const noexcept {
+    if (rank == 0) {
+      return size();
+    }
+    for (auto const& segment : segments_) {
+      if (rank <= segment->histogram[symbol]) {
+        return segment->offset + segment->wm.select(rank, symbol);
+      }
+      rank -= segment->histogram[symbol];
+    }
+    for (size_t i = 0; i < buffer_.size(); ++i) {
+      if (buffer_[i] == symbol && --rank == 0) {
+        return buffer_offset_ + i;
+      }
+    }
+    return size();
+  }
+
+  /*!
+   * \brief Size of the text.
+   *
+   * \return Number of symbols appended so far.
+   */
+  [[nodiscard]] size_t size() const noexcept {
+    return buffer_offset_ + buffer_.size();
+  }
+
+  /*!
+   * \brief Number of segments.
+   *
+   * \return Number of static segments (not including the write buffer).
+   */
+  [[nodiscard]] size_t segments() const noexcept {
+    return segments_.size();
+  }
+
+  /*!
+   * \brief Statistics about the merges finished so far.
+   *
+   * \return Number of merges, merged symbols, and time spent merging.
+   */
+  [[nodiscard]] MergeStatistics const& merge_statistics() const noexcept {
+    return merge_statistics_;
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    size_t space = buffer_.capacity() * sizeof(Symbol);
+    for (auto const& segment : segments_) {
+      space += segment->wm.space_usage() +
+               (segment->histogram.size() * sizeof(size_t));
+    }
+    return space;
+  }
+
+private:
+  /*!
+   * \brief Builds a segment containing the given symbols.
+   *
+   * \param symbols Symbols of the segment.
+   * \param offset First position of the segment in the text.
+   * \return The new segment.
+   */
+  [[nodiscard]] std::unique_ptr<Segment>
+  make_segment(std::vector<Symbol> const& symbols, size_t const offset) const {
+    auto segment = std::make_unique<Segment>();
+    segment->wm = WaveletMatrix(symbols.begin(), symbols.end(), alphabet_size_);
+    segment->offset = offset;
+    segment->size = symbols.size();
+    segment->histogram.resize(alphabet_size_, 0);
+    for (Symbol const symbol : symbols) {
+      ++segment->histogram[symbol];
+    }
+    return segment;
+  }
+
+  /*!
+   * \brief Starts a merge of the newest segments, if no merge is running and
+   * there is a segment that is not larger than all newer segments combined.
+   */
+  void schedule_merge() {
+    if (merge_.valid() || segments_.size() < 2) {
+      return;
+    }
+    size_t first = segments_.size() - 1;
+    size_t newer_size = segments_[first]->size;
+    while (first > 0 && segments_[first - 1]->size <= newer_size) {
+      --first;
+      newer_size += segments_[first]->size;
+    }
+    if (first + 1 == segments_.size()) {
+      return;
+    }
+
+    std::vector<Segment const*> merged;
+    for (size_t i = first; i < segments_.size(); ++i) {
+      merged.push_back(segments_[i].get());
+    }
+    merge_first_ = first;
+    merge_count_ = merged.size();
+    merge_ = std::async(background_merge_ ? std::launch::async
+                                          : std::launch::deferred,
+                        [this, merged = std::move(merged)]() {
+                          return merge_segments(merged);
+                        });
+    if (!background_merge_) {
+      install_merge(true);
+      schedule_merge();
+    }
+  }
+
+  /*!
+   * \brief Decodes the given (consecutive) segments and builds one segment
+   * containing all their symbols.
+   *
+   * \param merged The segments that are merged.
+   * \return The merged segment and the time required to compute it.
+   */
+  [[nodiscard]] MergeResult
+  merge_segments(std::vector<Segment const*> const& merged) const {
+    auto const start = std::chrono::steady_clock::now();
+    size_t merged_size = 0;
+    for (auto const* segment : merged) {
+      merged_size += segment->size;
+    }
+    std::vector<Symbol> symbols(merged_size);
+    auto out = symbols.begin();
+    for (auto const* segment : merged) {
+      segment->wm.extract(0, segment->size, out);
+      out += segment->size;
+    }
+    auto segment = make_segment(symbols, merged.front()->offset);
+    size_t const time_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count();
+    return MergeResult{std::move(segment), time_ns};
+  }
+
+  /*!
+   * \brief Replaces the merged segments by the result of the running merge,
+   * if it is finished.
+   *
+   * \param wait Whether to wait for the running merge to finish.
+   */
+  void install_merge(bool const wait) {
+    if (!merge_.valid() ||
+        (!wait && merge_.wait_for(std::chrono::seconds(0)) !=
+                      std::future_status::ready)) {
+      return;
+    }
+    MergeResult result = merge_.get();
+    ++merge_statistics_.merges;
+    merge_statistics_.merged_symbols += result.segment->size;
+    merge_statistics_.merge_time_ns += result.time_ns;
+    auto const first = segments_.begin() + merge_first_;
+    *first = std::move(result.segment);
+    segments_.erase(first + 1, first + merge_count_);
+  }
+}; // class AppendableWaveletMatrix
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
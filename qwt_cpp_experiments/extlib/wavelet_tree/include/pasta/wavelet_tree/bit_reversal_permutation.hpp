@@ -21,6 +21,7 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 
 namespace pasta {
 
@@ -101,6 +102,27 @@ static constexpr std::array<size_t const *, 9> BitReversalPermutation = {
     &BitReversalPermutationData[63], &BitReversalPermutationData[127],
     &BitReversalPermutationData[255]};
 
+/*!
+ * \brief Computes the i-th entry of the bit-reversal permutation of length
+ * 2^\c bits, e.g., for permutations longer than the ones in
+ * \ref BitReversalPermutation.
+ *
+ * \param value Entry of the permutation (less than 2^\c bits).
+ * \param bits Logarithm of the length of the permutation (at least one).
+ * \return The \c bits lowest bits of \c value in reversed order.
+ */
+[[nodiscard("bit-reversal computed but not used")]] constexpr size_t
+bit_reverse(size_t value, size_t const bits) noexcept {
+  value = ((value >> 1) & 0x5555555555555555ULL) |
+          ((value & 0x5555555555555555ULL) << 1);
+  value = ((value >> 2) & 0x3333333333333333ULL) |
+          ((value & 0x3333333333333333ULL) << 2);
+  value = ((value >> 4) & 0x0F0F0F0F0F0F0F0FULL) |
+          ((value & 0x0F0F0F0F0F0F0F0FULL) << 4);
+  value = __builtin_bswap64(value);
+  return value >> (64 - bits);
+}
+
 } // namespace pasta
 
 /******************************************************************************/
@@ -0,0 +1,296 @@
+/*******************************************************************************
+ * pasta/wavelet_tree/dynamic_wavelet_matrix.hpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::wavelet_tree is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::wavelet_tree is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::wavelet_tree.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <vector>
+
+#include <pasta/bit_vector/bit_vector.hpp>
+#include <pasta/bit_vector/dynamic_bit_vector.hpp>
+
+namespace pasta {
+
+//! \addtogroup pasta_wavelet_trees
+//! \{
+
+/*!
+ * \brief Wavelet matrix that supports insertions and deletions of symbols.
+ *
+ * Each level is stored in its own dynamic bit vector. Together with the
+ * number of zeros on each level, this suffices to navigate the levels the
+ * same way as in the static wavelet matrix. All operations require
+ * O(log n) time per level. Inserted symbols must be smaller than
+ * 2^#levels, where the number of levels is determined by the alphabet size
+ * given during construction.
+ *
+ * \tparam Symbol Type of characters in the text.
+ * \tparam DynamicBitVectorType Type of dynamic bit vector used to represent
+ * the levels. Must be constructible from a \c BitVector.
+ */
+template <typename Symbol, typename DynamicBitVectorType = DynamicBitVector<>>
+class DynamicWaveletMatrix {
+  //! Number of levels of the wavelet matrix.
+  size_t levels_;
+  //! Number of symbols in the text.
+  size_t text_size_;
+
+  //! Bit vector of each level.
+  std::vector<DynamicBitVectorType> bv_;
+  //! Number of zeros in each level.
+  std::vector<size_t> zeros_on_level_;
+
+public:
+  /*!
+   * \brief Constructor. Builds the wavelet matrix of a text, which can be
+   * empty.
+   *
+   * \tparam InputIterator Iterator type of the text container.
+   * \param begin Iterator to the beginning of the text.
+   * \param end Iterator marking the end of the text.
+   * \param alphabet_size Size of the alphabet of all symbols that are
+   * contained in the text or inserted later.
+   */
+  template <std::forward_iterator InputIterator>
+  DynamicWaveletMatrix(InputIterator begin,
+                       InputIterator end,
+                       size_t const alphabet_size)
+      : levels_(std::max<size_t>(1, std::bit_width(alphabet_size - 1))),
+        text_size_(std::distance(begin, end)),
+        zeros_on_level_(levels_, 0) {
+    bv_.reserve(levels_);
+    // Stable partitioning of the symbols by the bit of the current level
+    // results in the order of the symbols on the next level.
+    std::vector<Symbol> symbols(begin, end);
+    std::vector<Symbol> next_symbols(text_size_);
+    for (size_t level = 0; level < levels_; ++level) {
+      size_t const shift = levels_ - level - 1;
+      BitVector level_bv(text_size_, 0);
+      size_t zeros = 0;
+      for (size_t i = 0; i < text_size_; ++i) {
+        bool const bit = (symbols[i] >> shift) & 1ULL;
+        level_bv[i] = bit;
+        zeros += !bit;
+      }
+      zeros_on_level_[level] = zeros;
+      bv_.emplace_back(level_bv);
+      size_t zero_pos = 0;
+      size_t one_pos = zeros;
+      for (size_t i = 0; i < text_size_; ++i) {
+        if ((symbols[i] >> shift) & 1ULL) {
+          next_symbols[one_pos++] = symbols[i];
+        } else {
+          next_symbols[zero_pos++] = symbols[i];
+        }
+      }
+      std::swap(symbols, next_symbols);
+    }
+  }
+
+  /*!
+   * \brief Constructor. Creates an empty wavelet matrix.
+   *
+   * \param alphabet_size Size of the alphabet of all symbols that are
+   * inserted.
+   */
+  DynamicWaveletMatrix(size_t const alphabet_size)
+      : DynamicWaveletMatrix(static_cast<Symbol const*>(nullptr),
+                             static_cast<Symbol const*>(nullptr),
+                             alphabet_size) {}
+
+  /*!
+   * \brief Access operator to access characters of the text using the
+   * wavelet matrix.
+   *
+   * \param position Position of the character that should be retrieved.
+   * \return Character at position \c position.
+   */
+  [[nodiscard("Wavelet matrix accessed but result not used")]] Symbol
+  operator[](size_t position) const noexcept {
+    Symbol result = 0;
+    for (size_t level = 0; level < levels_; ++level) {
+      result <<= 1;
+      if (bv_[level][position]) {
+        result |= 1;
+        position = zeros_on_level_[level] + bv_[level].rank1(position);
+      } else {
+        position = bv_[level].rank0(position);
+      }
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Computes the number of occurrences of a symbol before the given
+   * position \c p, i.e., in the interval [0..p).
+   *
+   * \param position The position up to (not included) the occurrences are
+   * counted.
+   * \param symbol The symbol the occurrences are counted of.
+   * \return The number of occurrences of \c symbol in the interval
+   * [0..\c position).
+   */
+  [[nodiscard("Wavelet matrix rank computed but result not used")]] size_t
+  rank(size_t position, Symbol const symbol) const noexcept {
+    size_t interval_start = 0;
+    for (size_t level = 0; level < levels_ && position > interval_start;
+         ++level) {
+      if ((symbol >> (levels_ - level - 1)) & 1ULL) {
+        interval_start =
+            zeros_on_level_[level] + bv_[level].rank1(interval_start);
+        position = zeros_on_level_[level] + bv_[level].rank1(position);
+      } else {
+        interval_start = bv_[level].rank0(interval_start);
+        position = bv_[level].rank0(position);
+      }
+    }
+    return (position > interval_start) ? position - interval_start : 0;
+  }
+
+  /*!
+   * \brief Computes the position a symbol with a specific rank, i.e., the
+   * rank-th occurrence of a symbol.
+   *
+   * \param rank The rank of the symbol that is looked for (starting at 1).
+   * \param symbol The symbol the position of the rank-th occurrence is looked
+   * for.
+   * \return Position of the \c rank-th occurrence of \c symbol or the size
+   * of the text, if there is no such occurrence.
+   */
+  [[nodiscard("Wavelet matrix select computed but result not used")]] size_t
+  select(size_t const rank, Symbol const symbol) const noexcept {
+    // Top-down: interval of the symbol on the last level.
+    size_t interval_start = 0;
+    size_t interval_end = text_size_;
+    for (size_t level = 0; level < levels_; ++level) {
+      if ((symbol >> (levels_ - level - 1)) & 1ULL) {
+        interval_start =
+            zeros_on_level_[level] + bv_[level].rank1(interval_start);
+        interval_end = zeros_on_level_[level] + bv_[level].rank1(interval_end);
+      } else {
+        interval_start = bv_[level].rank0(interval_start);
+        interval_end = bv_[level].rank0(interval_end);
+      }
+    }
+    if (rank == 0 || interval_end - interval_start < rank) {
+      return text_size_;
+    }
+    // Bottom-up: map the position back to the first level.
+    size_t position = interval_start + rank - 1;
+    for (size_t level = levels_; level-- > 0;) {
+      if ((symbol >> (levels_ - level - 1)) & 1ULL) {
+        position = bv_[level].select1(position - zeros_on_level_[level] + 1);
+      } else {
+        position = bv_[level].select0(position + 1);
+      }
+    }
+    return position;
+  }
+
+  /*!
+   * \brief Inserts a symbol at a position. All symbols at and after the
+   * position are moved one position to the right.
+   *
+   * \param position Position the symbol is inserted at (at most the size of
+   * the text).
+   * \param symbol Symbol that is inserted.
+   */
+  void insert(size_t position, Symbol const symbol) {
+    for (size_t level = 0; level < levels_; ++level) {
+      bool const bit = (symbol >> (levels_ - level - 1)) & 1ULL;
+      size_t const next_position =
+          bit ? zeros_on_level_[level] + bv_[level].rank1(position)
+              : bv_[level].rank0(position);
+      bv_[level].insert(position, bit);
+      zeros_on_level_[level] += !bit;
+      position = next_position;
+    }
+    ++text_size_;
+  }
+
+  /*!
+   * \brief Appends a symbol at the end of the text.
+   *
+   * \param symbol Symbol that is appended.
+   */
+  void push_back(Symbol const symbol) {
+    insert(text_size_, symbol);
+  }
+
+  /*!
+   * \brief Removes the symbol at a position. All symbols after the position
+   * are moved one position to the left.
+   *
+   * \param position Position of the symbol that is removed.
+   */
+  void erase(size_t position) {
+    for (size_t level = 0; level < levels_; ++level) {
+      bool const bit = bv_[level][position];
+      // The next position must be computed before the number of zeros on
+      // this level changes.
+      size_t const next_position =
+          bit ? zeros_on_level_[level] + bv_[level].rank1(position)
+              : bv_[level].rank0(position);
+      bv_[level].erase(position);
+      zeros_on_level_[level] -= !bit;
+      position = next_position;
+    }
+    --text_size_;
+  }
+
+  /*!
+   * \brief Number of levels.
+   *
+   * \return Number of levels of the wavelet matrix.
+   */
+  [[nodiscard]] size_t levels() const noexcept {
+    return levels_;
+  }
+
+  /*!
+   * \brief Size of the text.
+   *
+   * \return Number of symbols in the text.
+   */
+  [[nodiscard]] size_t size() const noexcept {
+    return text_size_;
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    size_t space = (zeros_on_level_.size() * sizeof(size_t)) + sizeof(*this);
+    for (auto const& bv : bv_) {
+      space += bv.space_usage();
+    }
+    return space;
+  }
+}; // class DynamicWaveletMatrix
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -0,0 +1,296 @@
+/*******************************************************************************
+ * pasta/wavelet_tree/level_wise_construction.hpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::wavelet_tree is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::wavelet_tree is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::wavelet_tree.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#if defined(__x86_64__)
+#  include <immintrin.h>
+#endif
+
+#include <pasta/bit_vector/bit_vector.hpp>
+
+#include "pasta/wavelet_tree/wavelet_tree.hpp"
+#include "pasta/wavelet_tree/wavelet_types.hpp"
+
+namespace pasta {
+
+//! \addtogroup pasta_wavelet_trees
+//! \{
+
+//! Kernels used by the level-wise wavelet matrix construction.
+enum class LevelWiseKernels {
+  //! Portable kernels processing one symbol at a time.
+  SCALAR,
+  //! AVX2 and BMI2 kernels, if supported by the CPU, scalar otherwise.
+  AUTO
+}; // enum class LevelWiseKernels
+
+/*!
+ * \brief Checks (once) whether the CPU supports the AVX2 and BMI2 kernels.
+ *
+ * The kernels are compiled for AVX2 and BMI2 independent of the compiler
+ * flags, thus, they can only be used if this returns true.
+ */
+[[nodiscard]] inline bool level_wise_simd_supported() noexcept {
+#if defined(__x86_64__) && defined(__GNUC__)
+  static bool const supported =
+      __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2");
+  return supported;
+#else
+  return false;
+#endif
+}
+
+/*!
+ * \brief Extracts one bit of each symbol (a bit plane).
+ *
+ * \param symbols Symbols the bits are extracted from.
+ * \param size Number of symbols.
+ * \param bit Position of the extracted bit in the symbols.
+ * \param out Words the bits are written to (the i-th bit is stored in bit
+ * i % 64 of word i / 64). Must contain ceil(\c size / 64) words.
+ */
+inline void extract_bit_plane_scalar(uint8_t const* symbols,
+                                     size_t const size,
+                                     size_t const bit,
+                                     uint64_t* out) noexcept {
+  for (size_t i = 0; i < size; i += 64) {
+    size_t const block_size = std::min<size_t>(64, size - i);
+    uint64_t word = 0ULL;
+    for (size_t j = 0; j < block_size; ++j) {
+      word |= static_cast<uint64_t>((symbols[i + j] >> bit) & 1U) << j;
+    }
+    out[i / 64] = word;
+  }
+}
+
+/*!
+ * \brief Stable partitioning of symbols by one bit, i.e., all symbols where
+ * the bit is not set followed by all symbols where the bit is set.
+ *
+ * \param symbols Symbols that are partitioned.
+ * \param size Number of symbols.
+ * \param bit_plane Bit plane of the bit the symbols are partitioned by (see
+ * \ref extract_bit_plane_scalar()).
+ * \param zeros Number of symbols where the bit is not set.
+ * \param out Partitioned symbols. Must have room for \c size + 8 symbols.
+ */
+inline void partition_by_bit_scalar(uint8_t const* symbols,
+                                    size_t const size,
+                                    uint64_t const* bit_plane,
+                                    size_t const zeros,
+                                    uint8_t* out) noexcept {
+  size_t zero_pos = 0;
+  size_t one_pos = zeros;
+  for (size_t i = 0; i < size; ++i) {
+    if ((bit_plane[i / 64] >> (i % 64)) & 1ULL) {
+      out[one_pos++] = symbols[i];
+    } else {
+      out[zero_pos++] = symbols[i];
+    }
+  }
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+/*!
+ * \brief Extracts one bit of each symbol (see
+ * \ref extract_bit_plane_scalar()) 32 symbols at a time: The bit is shifted
+ * to the most significant bit of each byte, which are gathered using
+ * \c movemask.
+ */
+__attribute__((target("avx2"))) inline void
+extract_bit_plane_avx2(uint8_t const* symbols,
+                       size_t const size,
+                       size_t const bit,
+                       uint64_t* out) noexcept {
+  __m128i const shift = _mm_cvtsi64_si128(static_cast<int64_t>(7 - bit));
+  size_t i = 0;
+  for (; i + 64 <= size; i += 64) {
+    __m256i const low =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(symbols + i));
+    __m256i const high =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(symbols + i + 32));
+    uint32_t const low_bits =
+        static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_sll_epi64(low, shift)));
+    uint32_t const high_bits = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_sll_epi64(high, shift)));
+    out[i / 64] = (static_cast<uint64_t>(high_bits) << 32) | low_bits;
+  }
+  if (i < size) {
+    extract_bit_plane_scalar(symbols + i, size - i, bit, out + (i / 64));
+  }
+}
+
+/*!
+ * \brief Stable partitioning of symbols by one bit (see
+ * \ref partition_by_bit_scalar()) eight symbols at a time: The bits of the
+ * eight symbols are expanded to a byte mask (\c pdep), which is used to
+ * compress the symbols with and without the bit set (\c pext).
+ */
+__attribute__((target("bmi2,popcnt"))) inline void
+partition_by_bit_bmi2(uint8_t const* symbols,
+                      size_t const size,
+                      uint64_t const* bit_plane,
+                      size_t const zeros,
+                      uint8_t* out) noexcept {
+  constexpr uint64_t LowBitOfBytes = 0x0101010101010101ULL;
+  size_t zero_pos = 0;
+  size_t one_pos = zeros;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, symbols + i, sizeof(word));
+    uint64_t const bits = (bit_plane[i / 64] >> (i % 64)) & 0xFFULL;
+    uint64_t const byte_mask = _pdep_u64(bits, LowBitOfBytes) * 0xFFULL;
+    size_t const ones = _mm_popcnt_u64(bits);
+    // The eight bytes written for the symbols without the bit must not
+    // overwrite the symbols with the bit set, which follow them.
+    if (zero_pos + 8 <= zeros) [[likely]] {
+      uint64_t const zero_symbols = _pext_u64(word, ~byte_mask);
+      std::memcpy(out + zero_pos, &zero_symbols, sizeof(zero_symbols));
+      zero_pos += 8 - ones;
+    } else {
+      for (size_t j = 0; j < 8; ++j) {
+        if (!((bits >> j) & 1ULL)) {
+          out[zero_pos++] = symbols[i + j];
+        }
+      }
+    }
+    // The ones are followed by at most eight bytes of padding.
+    uint64_t const one_symbols = _pext_u64(word, byte_mask);
+    std::memcpy(out + one_pos, &one_symbols, sizeof(one_symbols));
+    one_pos += ones;
+  }
+  for (; i < size; ++i) {
+    if ((bit_plane[i / 64] >> (i % 64)) & 1ULL) {
+      out[one_pos++] = symbols[i];
+    } else {
+      out[zero_pos++] = symbols[i];
+    }
+  }
+}
+#endif
+
+/*!
+ * \brief Level-wise construction of a wavelet matrix.
+ *
+ * In contrast to \ref prefix_counting(), each level is computed from the
+ * symbols in the order of the level: The bits of the level are extracted
+ * (a bit plane) and the symbols are stably partitioned by the bit, which
+ * results in the order of the next level. Both steps work on many symbols at
+ * once. The bit plane is extracted using AVX2 (\c movemask over shifted
+ * bytes) and the partitioning uses BMI2 (\c pext). The kernels are chosen at
+ * run time, i.e., the construction also works on CPUs without AVX2 and
+ * BMI2. The first level is read directly from the text, the other levels
+ * from the partitioned symbols. Requires n/8 bytes for the bit plane and
+ * n + 8 bytes for the partitioned symbols if there are two levels. With
+ * more levels, the symbols are partitioned alternating between two buffers,
+ * i.e., the construction requires 2n + n/8 + 16 additional bytes.
+ *
+ * \tparam BitVectorType Type of bit vector used in the wavelet matrix.
+ * \param text Text over the alphabet [0, \c alphabet_size).
+ * \param alphabet_size Size of the alphabet of the text.
+ * \param kernels Use the portable kernels or (if supported) AVX2 and BMI2.
+ * \return Wavelet matrix of the text.
+ */
+template <typename BitVectorType>
+[[nodiscard("Wavelet matrix created and not used")]] WaveletBase<
+    BitVectorType, uint8_t, WaveletTypes::MATRIX>
+make_wm_level_wise(std::span<uint8_t const> const text,
+                   size_t const alphabet_size,
+                   LevelWiseKernels const kernels = LevelWiseKernels::AUTO) {
+  size_t const text_size = text.size();
+  size_t const levels = std::bit_width(alphabet_size - 1);
+  bool const use_simd =
+      (kernels == LevelWiseKernels::AUTO) && level_wise_simd_supported();
+
+  BitVector bv(text_size * levels, 0);
+  auto raw_bv = bv.data();
+  std::vector<uint64_t> bit_plane((text_size + 63) / 64);
+  // The second buffer is only allocated once there are two partitions.
+  std::vector<uint8_t> symbols;
+  std::vector<uint8_t> next_symbols(levels > 1 ? text_size + 8 : 0);
+  uint8_t const* current_symbols = text.data();
+
+  for (size_t level = 0; level < levels; ++level) {
+    size_t const bit = levels - level - 1;
+#if defined(__x86_64__) && defined(__GNUC__)
+    if (use_simd) {
+      extract_bit_plane_avx2(current_symbols, text_size, bit,
+                             bit_plane.data());
+    } else {
+      extract_bit_plane_scalar(current_symbols, text_size, bit,
+                               bit_plane.data());
+    }
+#else
+    extract_bit_plane_scalar(current_symbols, text_size, bit,
+                             bit_plane.data());
+#endif
+
+    // The level starts at bit text_size * level, which is not necessarily
+    // the beginning of a word.
+    size_t const offset = text_size * level;
+    size_t const word_offset = offset / 64;
+    size_t const shift = offset % 64;
+    size_t ones = 0;
+    for (size_t i = 0; i < bit_plane.size(); ++i) {
+      ones += std::popcount(bit_plane[i]);
+      raw_bv[word_offset + i] |= bit_plane[i] << shift;
+      if (shift > 0 && word_offset + i + 1 < raw_bv.size()) {
+        raw_bv[word_offset + i + 1] |= bit_plane[i] >> (64 - shift);
+      }
+    }
+
+    if (level + 1 < levels) {
+#if defined(__x86_64__) && defined(__GNUC__)
+      if (use_simd) {
+        partition_by_bit_bmi2(current_symbols, text_size, bit_plane.data(),
+                              text_size - ones, next_symbols.data());
+      } else {
+        partition_by_bit_scalar(current_symbols, text_size, bit_plane.data(),
+                                text_size - ones, next_symbols.data());
+      }
+#else
+      partition_by_bit_scalar(current_symbols, text_size, bit_plane.data(),
+                              text_size - ones, next_symbols.data());
+#endif
+      std::swap(symbols, next_symbols);
+      current_symbols = symbols.data();
+      if (next_symbols.empty() && level + 2 < levels) {
+        next_symbols.resize(text_size + 8);
+      }
+    }
+  }
+  return WaveletBase<BitVectorType, uint8_t, WaveletTypes::MATRIX>(
+      std::move(bv), text_size, levels);
+}
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -0,0 +1,232 @@
+/*******************************************************************************
+ * pasta/wavelet_tree/mapped_text.hpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::wavelet_tree is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::wavelet_tree is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::wavelet_tree.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <pasta/utils/byte_alphabet.hpp>
+
+#include "pasta/wavelet_tree/wavelet_tree.hpp"
+#include "pasta/wavelet_tree/wavelet_types.hpp"
+
+namespace pasta {
+
+//! \addtogroup pasta_wavelet_trees
+//! \{
+
+/*!
+ * \brief Read-only memory mapping of a text stored in a file (one byte per
+ * symbol).
+ *
+ * The text is not copied. Instead, the pages are read by the operating
+ * system when they are accessed. Since the construction of wavelet
+ * trees/matrices scans the text, the mapping is advised to be accessed
+ * sequentially (\c MADV_SEQUENTIAL), which results in aggressive read-ahead.
+ */
+class MappedText {
+  //! Mapped text (\c nullptr if the text is empty).
+  uint8_t* data_ = nullptr;
+  //! Number of symbols (mapped bytes).
+  size_t size_ = 0;
+
+public:
+  /*!
+   * \brief Constructor. Maps a file (or a prefix of it) into memory.
+   *
+   * \param path Path to the file containing the text.
+   * \param max_size Number of symbols of the text (prefix of the file) that
+   * are mapped. If zero, the whole file is mapped.
+   * \throws std::runtime_error If the file cannot be mapped.
+   */
+  MappedText(std::string const& path, size_t const max_size = 0) {
+    int const fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Cannot open file " + path);
+    }
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) != 0) {
+      ::close(fd);
+      throw std::runtime_error("Cannot stat file " + path);
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    if (max_size > 0) {
+      size_ = std::min(size_, max_size);
+    }
+    if (size_ > 0) {
+      void* const mapping =
+          ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapping == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("Cannot map file " + path);
+      }
+      ::madvise(mapping, size_, MADV_SEQUENTIAL);
+      data_ = static_cast<uint8_t*>(mapping);
+    }
+    // The mapping remains valid after the file descriptor is closed.
+    ::close(fd);
+  }
+
+  MappedText(MappedText const&) = delete;
+  MappedText& operator=(MappedText const&) = delete;
+
+  //! Move constructor.
+  MappedText(MappedText&& other) noexcept
+      : data_(std::exchange(other.data_, nullptr)),
+        size_(std::exchange(other.size_, 0)) {}
+
+  //! Move assignment.
+  MappedText& operator=(MappedText&& other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    return *this;
+  }
+
+  //! Destructor. Unmaps the file.
+  ~MappedText() {
+    if (data_ != nullptr) {
+      ::munmap(data_, size_);
+    }
+  }
+
+  //! Pointer to the first symbol.
+  [[nodiscard]] uint8_t const* begin() const noexcept {
+    return data_;
+  }
+
+  //! Pointer marking the end of the text.
+  [[nodiscard]] uint8_t const* end() const noexcept {
+    return data_ + size_;
+  }
+
+  //! Returns the symbol at a position.
+  [[nodiscard]] uint8_t operator[](size_t const position) const noexcept {
+    return data_[position];
+  }
+
+  //! Number of symbols.
+  [[nodiscard]] size_t size() const noexcept {
+    return size_;
+  }
+
+  //! View of the mapped text.
+  [[nodiscard]] std::span<uint8_t const> span() const noexcept {
+    return {data_, size_};
+  }
+}; // class MappedText
+
+/*!
+ * \brief Constructs a wavelet tree/matrix of a text over its effective
+ * alphabet without materializing the reduced text.
+ *
+ * After one pass computing the histogram (\ref byte_histogram()) and thus
+ * the effective alphabet (as computed by \ref reduce_alphabet()), each
+ * symbol is mapped to the effective alphabet on the fly whenever
+ * \ref prefix_counting() reads it.
+ * Thus, the text is only read and never written, which allows to construct
+ * the wavelet tree/matrix directly on a read-only \ref MappedText.
+ *
+ * \tparam BitVectorType Type of bit vector used in the wavelet tree/matrix.
+ * \tparam WaveletType \c WaveletTypes::Tree or \c WaveletTypes::Matrix.
+ * \param text Text over an arbitrary byte alphabet.
+ * \param alphabet_mapping_out Optional pointer to an array which is filled
+ * with the mapping of the symbols to the effective alphabet.
+ * \return Wavelet tree/matrix of the text over its effective alphabet.
+ */
+template <typename BitVectorType, WaveletTypes WaveletType>
+[[nodiscard("Wavelet tree/matrix created and not used")]] WaveletBase<
+    BitVectorType, uint8_t, WaveletType>
+fused_reduce_construction(
+    std::span<uint8_t const> const text,
+    std::array<size_t, 256>* alphabet_mapping_out = nullptr) {
+  ByteHistogram alphabet_mapping = byte_histogram(text.data(), text.size());
+  size_t alphabet_size = 0;
+  for (auto& occ : alphabet_mapping) {
+    if (occ > 0) {
+      occ = alphabet_size++;
+    }
+  }
+  if (alphabet_mapping_out != nullptr) {
+    *alphabet_mapping_out = alphabet_mapping;
+  }
+
+  auto const reduced_text =
+      text | std::views::transform([&](uint8_t const symbol) {
+        return static_cast<uint8_t>(alphabet_mapping[symbol]);
+      });
+  return WaveletBase<BitVectorType, uint8_t, WaveletType>(
+      reduced_text.begin(), reduced_text.end(), alphabet_size);
+}
+
+/*!
+ * \brief Factory function to construct a wavelet tree of a memory mapped
+ * text over its effective alphabet (see \ref fused_reduce_construction()).
+ *
+ * \tparam BitVectorType Type of bit vector used in the wavelet tree.
+ * \param text Memory mapped text.
+ * \param alphabet_mapping_out Optional pointer to an array which is filled
+ * with the mapping of the symbols to the effective alphabet.
+ * \return Wavelet tree for the text over its effective alphabet.
+ */
+template <typename BitVectorType>
+[[nodiscard("Wavelet tree created and not used")]] WaveletBase<
+    BitVectorType, uint8_t, WaveletTypes::TREE>
+make_wt(MappedText const& text,
+        std::array<size_t, 256>* alphabet_mapping_out = nullptr) {
+  return fused_reduce_construction<BitVectorType, WaveletTypes::TREE>(
+      text.span(), alphabet_mapping_out);
+}
+
+/*!
+ * \brief Factory function to construct a wavelet matrix of a memory mapped
+ * text over its effective alphabet (see \ref fused_reduce_construction()).
+ *
+ * \tparam BitVectorType Type of bit vector used in the wavelet matrix.
+ * \param text Memory mapped text.
+ * \param alphabet_mapping_out Optional pointer to an array which is filled
+ * with the mapping of the symbols to the effective alphabet.
+ * \return Wavelet matrix for the text over its effective alphabet.
+ */
+template <typename BitVectorType>
+[[nodiscard("Wavelet matrix created and not used")]] WaveletBase<
+    BitVectorType, uint8_t, WaveletTypes::MATRIX>
+make_wm(MappedText const& text,
+        std::array<size_t, 256>* alphabet_mapping_out = nullptr) {
+  return fused_reduce_construction<BitVectorType, WaveletTypes::MATRIX>(
+      text.span(), alphabet_mapping_out);
+}
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -0,0 +1,307 @@
+/*******************************************************************************
+ * pasta/wavelet_tree/occurrence_table.hpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::wavelet_tree is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::wavelet_tree is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::wavelet_tree.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include <pasta/bit_vector/support/select.hpp>
+
+namespace pasta {
+
+//! \addtogroup pasta_wavelet_trees
+//! \{
+
+/*!
+ * \brief Sequence for small alphabets (at most 16 symbols) supporting
+ * access, rank, and select queries without a wavelet tree/matrix.
+ *
+ * The symbols are packed using \c BitsPerSymbol bits each and stored in
+ * blocks of one cache line. Each block starts with one 16-bit counter per
+ * symbol, containing the number of occurrences of the symbol before the
+ * block in the block's superblock. The absolute number of occurrences
+ * before each superblock is stored separately (this array is small). Thus,
+ * a rank query requires one cache miss for the block, where all occurrences
+ * of the symbol are counted word-parallel (by comparing all packed symbols
+ * of a word at once and counting the matches using popcount).
+ *
+ * For 2-bit symbols, a block contains 224 symbols, for 4-bit symbols a
+ * block contains 64 symbols.
+ *
+ * For select queries, the block containing every 256-th occurrence of each
+ * symbol is sampled. The block containing the occurrence is then found using
+ * binary search on the blocks between two samples.
+ *
+ * \tparam BitsPerSymbol Number of bits per symbol (either 2 or 4).
+ * \tparam Symbol Type of characters in the text.
+ */
+template <size_t BitsPerSymbol, typename Symbol = uint8_t>
+class OccurrenceTable {
+  static_assert(BitsPerSymbol == 2 || BitsPerSymbol == 4,
+                "Only 2-bit and 4-bit symbols are supported.");
+
+  //! Maximum number of different symbols.
+  static constexpr size_t Sigma = 1ULL << BitsPerSymbol;
+  //! Mask to extract one packed symbol.
+  static constexpr uint64_t SymbolMask = Sigma - 1;
+  //! Number of symbols packed in a 64-bit word.
+  static constexpr size_t SymbolsPerWord = 64 / BitsPerSymbol;
+  //! Number of words in a block (the remainder of the cache line after the
+  //! counters).
+  static constexpr size_t DataWords = (64 - (Sigma * sizeof(uint16_t))) / 8;
+  //! Number of symbols in a block.
+  static constexpr size_t SymbolsPerBlock = DataWords * SymbolsPerWord;
+  //! Number of blocks in a superblock, such that the counters relative to the
+  //! superblock fit into 16 bits.
+  static constexpr size_t BlocksPerSuperblock =
+      std::bit_floor((size_t{1} << 16) / SymbolsPerBlock);
+  //! Mask with the lowest bit of each packed symbol set.
+  static constexpr uint64_t LowBits = ~0ULL / SymbolMask;
+  //! Number of occurrences of a symbol between two select samples.
+  static constexpr size_t SelectSampleRate = 256;
+
+  //! Block of symbols with the counters of all symbols in one cache line.
+  struct alignas(64) Block {
+    //! Number of occurrences of each symbol before the block (relative to
+    //! the superblock).
+    std::array<uint16_t, Sigma> counts;
+    //! Packed symbols.
+    std::array<uint64_t, DataWords> words;
+  }; // struct Block
+  static_assert(sizeof(Block) == 64, "A block must fit into a cache line.");
+
+  //! Number of symbols in the text.
+  size_t text_size_;
+  //! Blocks containing the symbols (the last block is never full).
+  std::vector<Block> blocks_;
+  //! Number of occurrences of each symbol before each superblock. The counts
+  //! of a superblock are stored consecutively.
+  std::vector<uint64_t> superblock_counts_;
+  //! Number of occurrences of each symbol in the text.
+  std::array<size_t, Sigma> total_counts_;
+  //! For each symbol, the blocks containing the (i * SelectSampleRate + 1)-th
+  //! occurrences.
+  std::array<std::vector<size_t>, Sigma> select_samples_;
+
+public:
+  //! Default constructor. Creates an empty occurrence table.
+  OccurrenceTable() noexcept : text_size_(0), total_counts_{} {}
+
+  /*!
+   * \brief Constructor. Packs the text and computes the counters.
+   *
+   * \tparam InputIterator Iterator type of the text container.
+   * \param begin Iterator to the beginning of the text.
+   * \param end Iterator marking the end of the text.
+   * \param alphabet_size Size of the alphabet of the input text. All symbols
+   * must be smaller than 2^BitsPerSymbol.
+   */
+  template <std::forward_iterator InputIterator>
+  OccurrenceTable(InputIterator begin,
+                  InputIterator end,
+                  [[maybe_unused]] size_t const alphabet_size)
+      : text_size_(std::distance(begin, end)),
+        blocks_((text_size_ / SymbolsPerBlock) + 1),
+        superblock_counts_(
+            ((blocks_.size() + BlocksPerSuperblock - 1) /
+             BlocksPerSuperblock) *
+                Sigma,
+            0),
+        total_counts_{} {
+    for (size_t block = 0; block < blocks_.size(); ++block) {
+      Block& b = blocks_[block];
+      if (block % BlocksPerSuperblock == 0) {
+        std::copy_n(total_counts_.begin(), Sigma,
+                    superblock_counts_.begin() +
+                        ((block / BlocksPerSuperblock) * Sigma));
+      }
+      uint64_t const* const superblock =
+          superblock_counts_.data() + ((block / BlocksPerSuperblock) * Sigma);
+      for (size_t symbol = 0; symbol < Sigma; ++symbol) {
+        b.counts[symbol] =
+            static_cast<uint16_t>(total_counts_[symbol] - superblock[symbol]);
+      }
+      b.words.fill(0ULL);
+      for (size_t i = 0; i < SymbolsPerBlock && begin != end; ++i, ++begin) {
+        uint64_t const symbol = static_cast<uint64_t>(*begin) & SymbolMask;
+        b.words[i / SymbolsPerWord] |=
+            symbol << ((i % SymbolsPerWord) * BitsPerSymbol);
+        if (total_counts_[symbol]++ % SelectSampleRate == 0) {
+          select_samples_[symbol].push_back(block);
+        }
+      }
+    }
+  }
+
+  /*!
+   * \brief Access operator to access characters of the text.
+   *
+   * \param position Position of the character that should be retrieved.
+   * \return Character at position \c position.
+   */
+  [[nodiscard("Occurrence table accessed but result not used")]] Symbol
+  operator[](size_t const position) const noexcept {
+    Block const& b = blocks_[position / SymbolsPerBlock];
+    size_t const offset = position % SymbolsPerBlock;
+    return static_cast<Symbol>(
+        (b.words[offset / SymbolsPerWord] >>
+         ((offset % SymbolsPerWord) * BitsPerSymbol)) &
+        SymbolMask);
+  }
+
+  /*!
+   * \brief Computes the number of occurrences of a symbol before the given
+   * position \c p, i.e., in the interval [0..p).
+   *
+   * \param position The position up to (not included) the occurrences are
+   * counted.
+   * \param symbol The symbol the occurrences are counted of.
+   * \return The number of occurrences of \c symbol in the interval
+   * [0..\c position).
+   */
+  [[nodiscard("Occurrence table rank computed but result not used")]] size_t
+  rank(size_t const position, Symbol const symbol) const noexcept {
+    size_t const block = position / SymbolsPerBlock;
+    Block const& b = blocks_[block];
+    size_t const offset = position % SymbolsPerBlock;
+    size_t result = superblock_counts_[((block / BlocksPerSuperblock) * Sigma) +
+                                       symbol] +
+                    b.counts[symbol];
+    uint64_t const pattern = LowBits * static_cast<uint64_t>(symbol);
+    size_t const full_words = offset / SymbolsPerWord;
+    for (size_t w = 0; w < full_words; ++w) {
+      result += std::popcount(matches(b.words[w], pattern));
+    }
+    if (size_t const rest = offset % SymbolsPerWord; rest > 0) {
+      uint64_t const rest_mask = (1ULL << (rest * BitsPerSymbol)) - 1;
+      result +=
+          std::popcount(matches(b.words[full_words], pattern) & rest_mask);
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Computes the position a symbol with a specific rank, i.e., the
+   * rank-th occurrence of a symbol.
+   *
+   * \param rank The rank of the symbol that is looked for (starting at 1).
+   * \param symbol The symbol the position of the rank-th occurrence is looked
+   * for.
+   * \return Position of the \c rank-th occurrence of \c symbol or the size
+   * of the text, if there is no such occurrence.
+   */
+  [[nodiscard("Occurrence table select computed but result not used")]] size_t
+  select(size_t rank, Symbol const symbol) const noexcept {
+    if (rank == 0 || rank > total_counts_[symbol]) {
+      return text_size_;
+    }
+    // Last block with less than rank occurrences before it. The blocks
+    // containing the samples before and after the occurrence bound the search.
+    std::vector<size_t> const& samples = select_samples_[symbol];
+    size_t const sample = (rank - 1) / SelectSampleRate;
+    size_t low = samples[sample];
+    size_t high =
+        (sample + 1 < samples.size()) ? samples[sample + 1] + 1 : blocks_.size();
+    while (high - low > 1) {
+      size_t const mid = (low + high) / 2;
+      if (occurrences_before(mid, symbol) < rank) {
+        low = mid;
+      } else {
+        high = mid;
+      }
+    }
+    rank -= occurrences_before(low, symbol);
+    Block const& b = blocks_[low];
+    uint64_t const pattern = LowBits * static_cast<uint64_t>(symbol);
+    for (size_t w = 0; w < DataWords; ++w) {
+      uint64_t const word_matches = matches(b.words[w], pattern);
+      size_t const count = std::popcount(word_matches);
+      if (rank <= count) {
+        return (low * SymbolsPerBlock) + (w * SymbolsPerWord) +
+               (pasta::select(word_matches, rank - 1) / BitsPerSymbol);
+      }
+      rank -= count;
+    }
+    return text_size_;
+  }
+
+  /*!
+   * \brief Size of the text.
+   *
+   * \return Number of symbols in the text.
+   */
+  [[nodiscard]] size_t size() const noexcept {
+    return text_size_;
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    size_t space = (blocks_.size() * sizeof(Block)) +
+                   (superblock_counts_.size() * sizeof(uint64_t)) +
+                   sizeof(*this);
+    for (auto const& samples : select_samples_) {
+      space += samples.size() * sizeof(size_t);
+    }
+    return space;
+  }
+
+private:
+  //! Number of occurrences of a symbol before a block.
+  [[nodiscard]] size_t occurrences_before(size_t const block,
+                                          Symbol const symbol) const noexcept {
+    return superblock_counts_[((block / BlocksPerSuperblock) * Sigma) +
+                              symbol] +
+           blocks_[block].counts[symbol];
+  }
+
+  /*!
+   * \brief Compares all packed symbols of a word with a symbol.
+   *
+   * \param word Word containing packed symbols.
+   * \param pattern The symbol repeated for each packed symbol.
+   * \return Word where the lowest bit of each packed symbol is set, iff the
+   * symbol is equal to the symbol in \c pattern.
+   */
+  [[nodiscard]] static uint64_t matches(uint64_t const word,
+                                        uint64_t const pattern) noexcept {
+    // Packed symbols that are equal become zero. Afterwards, all bits of a
+    // packed symbol are or-ed into its lowest bit.
+    uint64_t difference = word ^ pattern;
+    for (size_t shift = 1; shift < BitsPerSymbol; shift <<= 1) {
+      difference |= difference >> shift;
+    }
+    return ~difference & LowBits;
+  }
+}; // class OccurrenceTable
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
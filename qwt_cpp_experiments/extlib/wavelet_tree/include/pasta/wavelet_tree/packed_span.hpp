@@ -0,0 +1,302 @@
+/*******************************************************************************
+ * pasta/wavelet_tree/packed_span.hpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::wavelet_tree is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::wavelet_tree is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::wavelet_tree.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace pasta {
+
+//! \addtogroup pasta_wavelet_trees
+//! \{
+
+/*!
+ * \brief Random access iterator over symbols that are packed into 64-bit
+ * words using \c BitsPerSymbol bits each.
+ *
+ * The i-th symbol is stored in word i / (64 / \c BitsPerSymbol) starting at
+ * bit (i % (64 / \c BitsPerSymbol)) * \c BitsPerSymbol, i.e., the first
+ * symbol is stored in the least significant bits.
+ *
+ * \tparam BitsPerSymbol Number of bits per symbol (either 2 or 4).
+ */
+template <size_t BitsPerSymbol>
+class PackedIterator {
+  static_assert(BitsPerSymbol == 2 || BitsPerSymbol == 4,
+                "Only 2-bit and 4-bit symbols are supported.");
+
+public:
+  //! Number of symbols packed in a 64-bit word.
+  static constexpr size_t SymbolsPerWord = 64 / BitsPerSymbol;
+  //! Mask to extract one packed symbol.
+  static constexpr uint64_t SymbolMask = (1ULL << BitsPerSymbol) - 1;
+
+  using iterator_concept = std::random_access_iterator_tag;
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = uint8_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = uint8_t;
+
+private:
+  //! Packed symbols.
+  uint64_t const* data_ = nullptr;
+  //! Position of the symbol the iterator points to.
+  size_t position_ = 0;
+
+public:
+  //! Default constructor.
+  PackedIterator() = default;
+
+  /*!
+   * \brief Constructor. Creates an iterator pointing to a packed symbol.
+   *
+   * \param data Pointer to the packed symbols.
+   * \param position Position of the symbol the iterator points to.
+   */
+  PackedIterator(uint64_t const* data, size_t const position) noexcept
+      : data_(data), position_(position) {}
+
+  //! Returns the symbol the iterator points to.
+  [[nodiscard]] reference operator*() const noexcept {
+    return (data_[position_ / SymbolsPerWord] >>
+            ((position_ % SymbolsPerWord) * BitsPerSymbol)) &
+           SymbolMask;
+  }
+
+  //! Returns the symbol \c n positions after the iterator.
+  [[nodiscard]] reference operator[](difference_type const n) const noexcept {
+    return *(*this + n);
+  }
+
+  /*!
+   * \brief Returns the packed symbols starting at the iterator, i.e., the
+   * next symbols in one word (the first symbol in the least significant
+   * bits). Symbols at or after \c end are undefined.
+   *
+   * \param end Iterator marking the end of the packed symbols, which must not
+   * be accessed.
+   * \return Word containing the packed symbols starting at the iterator.
+   */
+  [[nodiscard]] uint64_t word(PackedIterator const& end) const noexcept {
+    size_t const word = position_ / SymbolsPerWord;
+    size_t const shift = (position_ % SymbolsPerWord) * BitsPerSymbol;
+    if (shift == 0) {
+      return data_[word];
+    }
+    uint64_t result = data_[word] >> shift;
+    if ((word + 1) * SymbolsPerWord < end.position_) {
+      result |= data_[word + 1] << (64 - shift);
+    }
+    return result;
+  }
+
+  //! Position of the symbol the iterator points to.
+  [[nodiscard]] size_t position() const noexcept {
+    return position_;
+  }
+
+  PackedIterator& operator++() noexcept {
+    ++position_;
+    return *this;
+  }
+
+  PackedIterator operator++(int) noexcept {
+    PackedIterator result = *this;
+    ++position_;
+    return result;
+  }
+
+  PackedIterator& operator--() noexcept {
+    --position_;
+    return *this;
+  }
+
+  PackedIterator operator--(int) noexcept {
+    PackedIterator result = *this;
+    --position_;
+    return result;
+  }
+
+  PackedIterator& operator+=(difference_type const n) noexcept {
+    position_ += n;
+    return *this;
+  }
+
+  PackedIterator& operator-=(difference_type const n) noexcept {
+    position_ -= n;
+    return *this;
+  }
+
+  [[nodiscard]] friend PackedIterator
+  operator+(PackedIterator it, difference_type const n) noexcept {
+    return it += n;
+  }
+
+  [[nodiscard]] friend PackedIterator
+  operator+(difference_type const n, PackedIterator it) noexcept {
+    return it += n;
+  }
+
+  [[nodiscard]] friend PackedIterator
+  operator-(PackedIterator it, difference_type const n) noexcept {
+    return it -= n;
+  }
+
+  [[nodiscard]] friend difference_type
+  operator-(PackedIterator const& lhs, PackedIterator const& rhs) noexcept {
+    return static_cast<difference_type>(lhs.position_) -
+           static_cast<difference_type>(rhs.position_);
+  }
+
+  [[nodiscard]] friend bool operator==(PackedIterator const& lhs,
+                                       PackedIterator const& rhs) noexcept {
+    return lhs.position_ == rhs.position_;
+  }
+
+  [[nodiscard]] friend std::strong_ordering
+  operator<=>(PackedIterator const& lhs, PackedIterator const& rhs) noexcept {
+    return lhs.position_ <=> rhs.position_;
+  }
+}; // class PackedIterator
+
+//! Is the iterator a \c PackedIterator.
+template <typename Iterator>
+struct IsPackedIterator : std::false_type {};
+
+template <size_t BitsPerSymbol>
+struct IsPackedIterator<PackedIterator<BitsPerSymbol>> : std::true_type {};
+
+/*!
+ * \brief Calls a function for each symbol in [begin, end). The symbols are
+ * decoded word by word instead of symbol by symbol.
+ *
+ * \param begin Iterator to the first symbol.
+ * \param end Iterator marking the end of the symbols.
+ * \param function Function that is called with each symbol (in order).
+ */
+template <size_t BitsPerSymbol, typename Function>
+void for_each_packed_symbol(PackedIterator<BitsPerSymbol> begin,
+                            PackedIterator<BitsPerSymbol> const end,
+                            Function&& function) {
+  constexpr size_t SymbolsPerWord =
+      PackedIterator<BitsPerSymbol>::SymbolsPerWord;
+  constexpr uint64_t SymbolMask = PackedIterator<BitsPerSymbol>::SymbolMask;
+  for (; end - begin >= static_cast<std::ptrdiff_t>(SymbolsPerWord);
+       begin += SymbolsPerWord) {
+    uint64_t word = begin.word(end);
+    for (size_t i = 0; i < SymbolsPerWord; ++i, word >>= BitsPerSymbol) {
+      function(static_cast<uint8_t>(word & SymbolMask));
+    }
+  }
+  for (; begin != end; ++begin) {
+    function(*begin);
+  }
+}
+
+/*!
+ * \brief Non-owning view of a text whose symbols are packed into 64-bit words
+ * using \c BitsPerSymbol bits each (see \ref PackedIterator for the layout).
+ *
+ * \tparam BitsPerSymbol Number of bits per symbol (either 2 or 4).
+ */
+template <size_t BitsPerSymbol>
+class PackedSpan {
+  //! Packed symbols.
+  std::span<uint64_t const> data_;
+  //! Number of symbols.
+  size_t size_;
+
+public:
+  //! Number of symbols packed in a 64-bit word.
+  static constexpr size_t SymbolsPerWord =
+      PackedIterator<BitsPerSymbol>::SymbolsPerWord;
+
+  /*!
+   * \brief Constructor. Creates a view of packed symbols.
+   *
+   * \param data Words containing the packed symbols.
+   * \param size Number of symbols (at most the number of symbols fitting in
+   * \c data).
+   */
+  PackedSpan(std::span<uint64_t const> const data, size_t const size) noexcept
+      : data_(data), size_(size) {}
+
+  //! Iterator to the first symbol.
+  [[nodiscard]] PackedIterator<BitsPerSymbol> begin() const noexcept {
+    return PackedIterator<BitsPerSymbol>(data_.data(), 0);
+  }
+
+  //! Iterator marking the end of the symbols.
+  [[nodiscard]] PackedIterator<BitsPerSymbol> end() const noexcept {
+    return PackedIterator<BitsPerSymbol>(data_.data(), size_);
+  }
+
+  //! Returns the symbol at a position.
+  [[nodiscard]] uint8_t operator[](size_t const position) const noexcept {
+    return begin()[position];
+  }
+
+  //! Number of symbols.
+  [[nodiscard]] size_t size() const noexcept {
+    return size_;
+  }
+
+  //! Words containing the packed symbols.
+  [[nodiscard]] std::span<uint64_t const> data() const noexcept {
+    return data_;
+  }
+}; // class PackedSpan
+
+/*!
+ * \brief Packs a text using \c BitsPerSymbol bits per symbol.
+ *
+ * \tparam BitsPerSymbol Number of bits per symbol (either 2 or 4).
+ * \param begin Iterator to the beginning of the text.
+ * \param end Iterator marking the end of the text.
+ * \return Words containing the packed symbols (unused bits are zero).
+ */
+template <size_t BitsPerSymbol, std::forward_iterator InputIterator>
+[[nodiscard("Packed text computed but not used")]] std::vector<uint64_t>
+pack_symbols(InputIterator begin, InputIterator const end) {
+  constexpr size_t SymbolsPerWord =
+      PackedIterator<BitsPerSymbol>::SymbolsPerWord;
+  size_t const size = std::distance(begin, end);
+  std::vector<uint64_t> packed((size + SymbolsPerWord - 1) / SymbolsPerWord,
+                               0ULL);
+  for (size_t i = 0; begin != end; ++begin, ++i) {
+    packed[i / SymbolsPerWord] |=
+        (static_cast<uint64_t>(*begin) &
+         PackedIterator<BitsPerSymbol>::SymbolMask)
+        << ((i % SymbolsPerWord) * BitsPerSymbol);
+  }
+  return packed;
+}
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -24,8 +24,10 @@
 #include <bit>
 #include <iterator>
 #include <numeric>
+#include <span>
 
 #include "pasta/wavelet_tree/bit_reversal_permutation.hpp"
+#include "pasta/wavelet_tree/packed_span.hpp"
 #include "pasta/wavelet_tree/wavelet_types.hpp"
 
 namespace pasta {
@@ -33,6 +35,128 @@ namespace pasta {
 //! \addtogroup pasta_wavelet_trees
 //! \{
 
+/*!
+ * \brief Gathers the lowest bit of each packed symbol of a word into the
+ * lowest 64 / \c BitsPerSymbol bits of the result (word-parallel).
+ *
+ * \tparam BitsPerSymbol Number of bits per packed symbol (either 2 or 4).
+ * \param word Word containing packed symbols.
+ * \return Lowest bit of each packed symbol (the first symbol's bit is the
+ * least significant bit).
+ */
+template <size_t BitsPerSymbol>
+[[nodiscard]] uint64_t gather_symbol_bits(uint64_t word) noexcept {
+  if constexpr (BitsPerSymbol == 2) {
+    word &= 0x5555555555555555ULL;
+    word = (word | (word >> 1)) & 0x3333333333333333ULL;
+    word = (word | (word >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+    word = (word | (word >> 4)) & 0x00FF00FF00FF00FFULL;
+    word = (word | (word >> 8)) & 0x0000FFFF0000FFFFULL;
+    word = (word | (word >> 16)) & 0x00000000FFFFFFFFULL;
+  } else {
+    word &= 0x1111111111111111ULL;
+    word = (word | (word >> 3)) & 0x0303030303030303ULL;
+    word = (word | (word >> 6)) & 0x000F000F000F000FULL;
+    word = (word | (word >> 12)) & 0x000000FF000000FFULL;
+    word = (word | (word >> 24)) & 0x000000000000FFFFULL;
+  }
+  return word;
+}
+
+/*!
+ * \brief Computes the first level of the wavelet tree/matrix and the
+ * histogram for a text of packed symbols. The bits of a whole word of
+ * packed symbols are extracted at once and the occurrences of each symbol
+ * in the word are counted word-parallel.
+ *
+ * \param begin Iterator to the beginning of the packed text.
+ * \param end Iterator marking the end of the packed text.
+ * \param levels Number of levels of the wavelet tree/matrix.
+ * \param raw_bv Words of the bit vector the first level is written to.
+ * \param hist Histogram of the symbols (output parameter).
+ */
+template <size_t BitsPerSymbol, typename Histogram>
+void packed_first_level(PackedIterator<BitsPerSymbol> begin,
+                        PackedIterator<BitsPerSymbol> const end,
+                        size_t const levels,
+                        std::span<uint64_t> const raw_bv,
+                        Histogram& hist) {
+  constexpr size_t SymbolsPerWord =
+      PackedIterator<BitsPerSymbol>::SymbolsPerWord;
+  constexpr uint64_t LowBits =
+      ~0ULL / PackedIterator<BitsPerSymbol>::SymbolMask;
+  size_t const text_size = end - begin;
+  size_t const full_words = text_size / SymbolsPerWord;
+  size_t const alphabet_size = 1ULL << levels;
+  for (size_t w = 0; w < full_words; ++w, begin += SymbolsPerWord) {
+    uint64_t const word = begin.word(end);
+    // Since BitsPerSymbol input words are required for one output word, the
+    // bits are written to the corresponding part of the output word.
+    raw_bv[w / BitsPerSymbol] |=
+        gather_symbol_bits<BitsPerSymbol>(word >> (levels - 1))
+        << ((w % BitsPerSymbol) * SymbolsPerWord);
+    for (size_t symbol = 0; symbol < alphabet_size; ++symbol) {
+      // Packed symbols equal to the symbol become zero.
+      uint64_t difference = word ^ (LowBits * symbol);
+      for (size_t shift = 1; shift < BitsPerSymbol; shift <<= 1) {
+        difference |= difference >> shift;
+      }
+      hist[symbol] += std::popcount(~difference & LowBits);
+    }
+  }
+  for (size_t i = full_words * SymbolsPerWord; i < text_size; ++i, ++begin) {
+    auto const symbol = *begin;
+    ++hist[symbol];
+    raw_bv[i / 64] |= static_cast<uint64_t>((symbol >> (levels - 1)) & 1ULL)
+                      << (i % 64);
+  }
+}
+
+/*!
+ * \brief Computes the borders of all bit prefixes on a level, i.e., the
+ * position of the first bit of each bit prefix (of length \c level) in the
+ * bit vector containing all levels.
+ *
+ * \tparam WaveletType \c WaveletTypes::Tree or \c WaveletTypes::Matrix.
+ * \param hist Histogram of all bit prefixes of length \c level + 1. It is
+ * replaced by the histogram of all bit prefixes of length \c level.
+ * \param borders Borders of all bit prefixes of length \c level (output
+ * parameter).
+ * \param level The level the borders are computed for (at least one).
+ * \param text_size Number of symbols in the text.
+ */
+template <WaveletTypes WaveletType, typename HistType>
+void compute_level_borders(HistType& hist,
+                           HistType& borders,
+                           size_t const level,
+                           size_t const text_size) {
+  size_t const cur_alphabet_size = 1ULL << level;
+  for (size_t i = 0; i < cur_alphabet_size; ++i) {
+    borders[i] = hist[i << 1] + hist[(i << 1) + 1];
+  }
+  std::copy_n(borders.begin(), cur_alphabet_size, hist.begin());
+
+  if constexpr (WaveletType == WaveletTypes::TREE) {
+    std::exclusive_scan(borders.begin(), borders.begin() + cur_alphabet_size,
+                        borders.begin(), text_size * level);
+  } else if (level < BitReversalPermutation.size()) {
+    auto const brv = BitReversalPermutation[level];
+    borders[0] = text_size * level; // brv[0] = 0
+    for (size_t i = 1; i < cur_alphabet_size; ++i) {
+      borders[brv[i]] = hist[brv[i - 1]] + borders[brv[i - 1]];
+    }
+  } else {
+    // Alphabets with more than 2^9 symbols (only for 16 bit symbols).
+    borders[0] = text_size * level;
+    size_t prev_brv = 0;
+    for (size_t i = 1; i < cur_alphabet_size; ++i) {
+      size_t const cur_brv = bit_reverse(i, level);
+      borders[cur_brv] = hist[prev_brv] + borders[prev_brv];
+      prev_brv = cur_brv;
+    }
+  }
+}
+
 /*!
  * \brief Sequential prefix counting algorithm described in
  * \cite FischerKL2018PWX, based on bottom-up construction.
@@ -42,14 +166,28 @@ namespace pasta {
  * all bit prefixes of all characters on all levels, i.e., the positions of
  * all bits in the wavelet tree/matrix.
  *
+ * If the text consists of packed symbols (see \ref PackedIterator), the
+ * symbols are decoded word by word instead of symbol by symbol and the
+ * first level is computed word-parallel.
+ *
+ * On all other levels, the bits are scattered to the current positions of
+ * all bit prefixes. If \c BufferedScatter is set, the bits of each bit
+ * prefix are first collected in a 64-bit buffer, which is written to the
+ * bit vector once it is full. Thus, there is only one read-modify-write of
+ * the bit vector per 64 bits instead of per bit. For 8-bit symbols, the
+ * buffers of all bit prefixes (2 KiB) fit into L1 cache, for 16-bit symbols
+ * they require 512 KiB.
+ *
  * \tparam WaveletType \c WaveletTypes::Tree or \c WaveletTypes::Matrix.
+ * \tparam BufferedScatter Collect the bits of each bit prefix in a word
+ * before they are written to the bit vector.
  * \param begin Iterator to the beginning of the text.
  * \param end Iterator marking the end of the text.
  * \param levels Number of levels of the wavelet tree/matrix.
  * \param bit_vector_out \c BitVector the wavelet tree/matrix is stored in
  * (output parameter).
  */
-template <WaveletTypes WaveletType>
+template <WaveletTypes WaveletType, bool BufferedScatter = false>
 void prefix_counting(std::forward_iterator auto begin,
                      std::forward_iterator auto const end, size_t const levels,
                      BitVector &bit_vector_out) {
@@ -64,59 +202,77 @@ void prefix_counting(std::forward_iterator auto begin,
 
   HistType hist = {0};
   HistType borders = {0};
+  // The buffers are only used (and allocated) for the buffered scatter.
+  std::array<uint64_t, BufferedScatter ? std::tuple_size_v<HistType> : 0>
+      buffers = {};
+
+  if constexpr (IsPackedIterator<decltype(begin)>::value) {
+    packed_first_level(begin, end, levels, raw_bv, hist);
+  } else {
+    uint64_t const mask = 1ULL << (levels - 1);
+    size_t const shift_first_right = 64 - levels;
+    auto text_it = begin;
+    size_t raw_bv_pos = 0;
+    while (text_it + 64 < end) {
+      uint64_t bit_block = 0ULL;
+      for (size_t i = 0; i < 64; ++i, ++text_it) {
+        bit_block >>= 1;
+        auto const symbol = *text_it;
+        ++hist[symbol];
+        bit_block |= (symbol & mask) << shift_first_right;
+      }
+      raw_bv[raw_bv_pos++] = bit_block;
+    }
 
-  uint64_t const mask = 1ULL << (levels - 1);
-  size_t const shift_first_right = 64 - levels;
-  auto text_it = begin;
-  size_t raw_bv_pos = 0;
-  while (text_it + 64 < end) {
     uint64_t bit_block = 0ULL;
-    for (size_t i = 0; i < 64; ++i, ++text_it) {
-      bit_block >>= 1;
-      auto const symbol = *text_it;
+    size_t const remainder = end - text_it;
+    for (size_t i = 0; i < remainder; ++i) {
+      auto const symbol = *(text_it + i);
       ++hist[symbol];
+      bit_block >>= 1;
       bit_block |= (symbol & mask) << shift_first_right;
     }
-    raw_bv[raw_bv_pos++] = bit_block;
-  }
-
-  uint64_t bit_block = 0ULL;
-  size_t const remainder = end - text_it;
-  for (size_t i = 0; i < remainder; ++i) {
-    auto const symbol = *(text_it + i);
-    ++hist[symbol];
-    bit_block >>= 1;
-    bit_block |= (symbol & mask) << shift_first_right;
-  }
-  if (remainder > 0) [[likely]] {
-    bit_block >>= (64 - remainder);
-    raw_bv[raw_bv_pos] = bit_block;
+    if (remainder > 0) [[likely]] {
+      bit_block >>= (64 - remainder);
+      raw_bv[raw_bv_pos] = bit_block;
+    }
   }
 
-  size_t cur_alphabet_size = (1ULL << levels);
   for (size_t level = levels - 1; level > 0; --level) {
-    cur_alphabet_size >>= 1;
-    for (size_t i = 0; i < cur_alphabet_size; ++i) {
-      borders[i] = hist[i << 1] + hist[(i << 1) + 1];
-    }
-    std::copy_n(borders.begin(), cur_alphabet_size, hist.begin());
+    compute_level_borders<WaveletType>(hist, borders, level, text_size);
 
-    if constexpr (WaveletType == WaveletTypes::TREE) {
-      std::exclusive_scan(borders.begin(), borders.begin() + cur_alphabet_size,
-                          borders.begin(), text_size * level);
+    size_t const shift_word_for_bit = levels - level - 1;
+    auto const scatter = [&](auto const symbol) {
+      auto const symbol_prefix = (symbol >> shift_word_for_bit);
+      size_t const position = borders[symbol_prefix >> 1]++;
+      if constexpr (BufferedScatter) {
+        uint64_t& buffer = buffers[symbol_prefix >> 1];
+        buffer |= (symbol_prefix & 1ULL) << (position % 64);
+        if (position % 64 == 63) [[unlikely]] {
+          raw_bv[position / 64] |= buffer;
+          buffer = 0ULL;
+        }
+      } else {
+        raw_bv[position / 64] |= (symbol_prefix & 1ULL) << (position % 64);
+      }
+    };
+    if constexpr (IsPackedIterator<decltype(begin)>::value) {
+      for_each_packed_symbol(begin, end, scatter);
     } else {
-      auto const brv = BitReversalPermutation[level];
-      borders[0] = text_size * level; // brv[0] = 0
-      for (size_t i = 1; i < cur_alphabet_size; ++i) {
-        borders[brv[i]] = hist[brv[i - 1]] + borders[brv[i - 1]];
+      for (auto it = begin; it < end; ++it) {
+        scatter(*it);
       }
     }
-
-    size_t const shift_word_for_bit = levels - level - 1;
-    for (auto it = begin; it < end; ++it) {
-      auto const symbol_prefix = (*it >> shift_word_for_bit);
-      size_t const position = borders[symbol_prefix >> 1]++;
-      raw_bv[position / 64] |= (symbol_prefix & 1ULL) << (position % 64);
+    if constexpr (BufferedScatter) {
+      // Write the remaining bits. A bit prefix's buffer only contains set
+      // bits if it has been written to since the last full word, i.e., the
+      // bits belong to the word containing the last written position.
+      for (size_t i = 0; i < (1ULL << level); ++i) {
+        if (buffers[i] != 0ULL) {
+          raw_bv[(borders[i] - 1) / 64] |= buffers[i];
+          buffers[i] = 0ULL;
+        }
+      }
     }
   }
 }
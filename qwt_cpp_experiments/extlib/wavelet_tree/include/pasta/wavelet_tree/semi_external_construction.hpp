@@ -0,0 +1,206 @@
+/*******************************************************************************
+ * pasta/wavelet_tree/semi_external_construction.hpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::wavelet_tree is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::wavelet_tree is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::wavelet_tree.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pasta/bit_vector/bit_vector.hpp>
+
+#include "pasta/wavelet_tree/prefix_counting.hpp"
+#include "pasta/wavelet_tree/wavelet_tree.hpp"
+#include "pasta/wavelet_tree/wavelet_types.hpp"
+
+namespace pasta {
+
+//! \addtogroup pasta_wavelet_trees
+//! \{
+
+/*!
+ * \brief Semi-external construction of a wavelet tree/matrix of a text
+ * stored in a file, which is never loaded into memory as a whole.
+ *
+ * The text is read in chunks of at most \c memory_budget bytes. The first
+ * pass over the file computes the histogram, which determines the effective
+ * alphabet (as computed by \ref reduce_alphabet()) and the borders of all bit
+ * prefixes on all levels (as in \ref prefix_counting()). The second pass maps
+ * each symbol to the effective alphabet and writes its bits directly to their
+ * final positions on all levels. Only the text is kept external, i.e., the
+ * bit vector containing all levels must fit in memory.
+ *
+ * \tparam BitVectorType Type of bit vector used in the wavelet tree/matrix.
+ * \tparam WaveletType \c WaveletTypes::Tree or \c WaveletTypes::Matrix.
+ * \param path Path to the file containing the text (one byte per symbol).
+ * \param memory_budget Number of bytes used to buffer the text.
+ * \param max_size Number of symbols of the text (prefix of the file) that are
+ * indexed. If zero, the whole file is indexed.
+ * \param alphabet_mapping_out Optional pointer to an array which is filled
+ * with the mapping of the symbols to the effective alphabet.
+ * \return Wavelet tree/matrix of the text over its effective alphabet.
+ * \throws std::runtime_error If the file cannot be read.
+ */
+template <typename BitVectorType, WaveletTypes WaveletType>
+[[nodiscard("Wavelet tree/matrix created and not used")]] WaveletBase<
+    BitVectorType, uint8_t, WaveletType>
+semi_external_construction(
+    std::string const& path,
+    size_t const memory_budget,
+    size_t const max_size = 0,
+    std::array<size_t, 256>* alphabet_mapping_out = nullptr) {
+  using HistType = std::array<size_t, 256>;
+
+  std::ifstream stream(path, std::ios::in | std::ios::binary);
+  if (!stream) {
+    throw std::runtime_error("Cannot open file " + path);
+  }
+  stream.seekg(0, std::ios::end);
+  size_t text_size = stream.tellg();
+  if (max_size > 0) {
+    text_size = std::min(text_size, max_size);
+  }
+
+  std::vector<uint8_t> buffer(
+      std::max<size_t>(1, std::min(memory_budget, text_size)));
+  auto const for_each_chunk = [&](auto&& function) {
+    stream.clear();
+    stream.seekg(0);
+    for (size_t read = 0; read < text_size;) {
+      size_t const chunk_size = std::min(buffer.size(), text_size - read);
+      if (!stream.read(reinterpret_cast<char*>(buffer.data()), chunk_size)) {
+        throw std::runtime_error("Cannot read file " + path);
+      }
+      function(std::span<uint8_t const>(buffer.data(), chunk_size));
+      read += chunk_size;
+    }
+  };
+
+  HistType hist = {0};
+  for_each_chunk([&](std::span<uint8_t const> const chunk) {
+    for (uint8_t const symbol : chunk) {
+      ++hist[symbol];
+    }
+  });
+
+  HistType alphabet_mapping = {0};
+  HistType reduced_hist = {0};
+  size_t alphabet_size = 0;
+  for (size_t symbol = 0; symbol < hist.size(); ++symbol) {
+    if (hist[symbol] > 0) {
+      reduced_hist[alphabet_size] = hist[symbol];
+      alphabet_mapping[symbol] = alphabet_size++;
+    }
+  }
+  if (alphabet_mapping_out != nullptr) {
+    *alphabet_mapping_out = alphabet_mapping;
+  }
+  size_t const levels =
+      (alphabet_size > 1) ? std::bit_width(alphabet_size - 1) : 0;
+
+  // Borders of the bit prefixes on all levels (except the first, where the
+  // bits are stored in text order).
+  std::vector<HistType> borders(levels);
+  for (size_t level = levels; level-- > 1;) {
+    compute_level_borders<WaveletType>(reduced_hist, borders[level], level,
+                                       text_size);
+  }
+
+  BitVector bv(text_size * levels, 0);
+  if (levels > 0) {
+    auto raw_bv = bv.data();
+    size_t position = 0;
+    for_each_chunk([&](std::span<uint8_t const> const chunk) {
+      for (uint8_t const raw_symbol : chunk) {
+        size_t const symbol = alphabet_mapping[raw_symbol];
+        raw_bv[position / 64] |= ((symbol >> (levels - 1)) & 1ULL)
+                                 << (position % 64);
+        ++position;
+        for (size_t level = 1; level < levels; ++level) {
+          size_t const symbol_prefix = symbol >> (levels - level - 1);
+          size_t const pos = borders[level][symbol_prefix >> 1]++;
+          raw_bv[pos / 64] |= (symbol_prefix & 1ULL) << (pos % 64);
+        }
+      }
+    });
+  }
+  return WaveletBase<BitVectorType, uint8_t, WaveletType>(std::move(bv),
+                                                          text_size, levels);
+}
+
+/*!
+ * \brief Factory function to construct a wavelet tree of a text stored in a
+ * file using \ref semi_external_construction().
+ *
+ * \tparam BitVectorType Type of bit vector used in the wavelet tree.
+ * \param path Path to the file containing the text (one byte per symbol).
+ * \param memory_budget Number of bytes used to buffer the text.
+ * \param max_size Number of symbols of the text (prefix of the file) that are
+ * indexed. If zero, the whole file is indexed.
+ * \param alphabet_mapping_out Optional pointer to an array which is filled
+ * with the mapping of the symbols to the effective alphabet.
+ * \return Wavelet tree for the text over its effective alphabet.
+ */
+template <typename BitVectorType>
+[[nodiscard("Wavelet tree created and not used")]] WaveletBase<
+    BitVectorType, uint8_t, WaveletTypes::TREE>
+make_wt_semi_external(std::string const& path,
+                      size_t const memory_budget,
+                      size_t const max_size = 0,
+                      std::array<size_t, 256>* alphabet_mapping_out = nullptr) {
+  return semi_external_construction<BitVectorType, WaveletTypes::TREE>(
+      path, memory_budget, max_size, alphabet_mapping_out);
+}
+
+/*!
+ * \brief Factory function to construct a wavelet matrix of a text stored in
+ * a file using \ref semi_external_construction().
+ *
+ * \tparam BitVectorType Type of bit vector used in the wavelet matrix.
+ * \param path Path to the file containing the text (one byte per symbol).
+ * \param memory_budget Number of bytes used to buffer the text.
+ * \param max_size Number of symbols of the text (prefix of the file) that are
+ * indexed. If zero, the whole file is indexed.
+ * \param alphabet_mapping_out Optional pointer to an array which is filled
+ * with the mapping of the symbols to the effective alphabet.
+ * \return Wavelet matrix for the text over its effective alphabet.
+ */
+template <typename BitVectorType>
+[[nodiscard("Wavelet matrix created and not used")]] WaveletBase<
+    BitVectorType, uint8_t, WaveletTypes::MATRIX>
+make_wm_semi_external(std::string const& path,
+                      size_t const memory_budget,
+                      size_t const max_size = 0,
+                      std::array<size_t, 256>* alphabet_mapping_out = nullptr) {
+  return semi_external_construction<BitVectorType, WaveletTypes::MATRIX>(
+      path, memory_budget, max_size, alphabet_mapping_out);
+}
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
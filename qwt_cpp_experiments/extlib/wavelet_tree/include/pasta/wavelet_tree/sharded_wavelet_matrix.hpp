@@ -0,0 +1,245 @@
+/*******************************************************************************
+ * pasta/wavelet_tree/sharded_wavelet_matrix.hpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::wavelet_tree is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::wavelet_tree is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::wavelet_tree.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include <pasta/utils/concepts/alphabet.hpp>
+#include <pasta/utils/histogram.hpp>
+#include <tlx/math/div_ceil.hpp>
+#include <tlx/thread_pool.hpp>
+
+#include "pasta/wavelet_tree/wavelet_tree.hpp"
+
+namespace pasta {
+
+//! \addtogroup pasta_wavelet_trees
+//! \{
+
+/*!
+ * \brief Wavelet matrix that is split into independent shards, which are
+ * built in parallel.
+ *
+ * The text is split into blocks of \c shard_size symbols (the last block may
+ * be smaller). For each block, an independent wavelet matrix is built. In
+ * addition, for each symbol, the number of its occurrences in all blocks
+ * before a block is stored. Access and rank queries require one shard lookup
+ * and one query on the shard. Select queries additionally require a binary
+ * search over the shards' symbol counts.
+ *
+ * \tparam BitVectorType Type of bit vector used to represent the levels.
+ * \tparam Symbol Type of characters in the text.
+ */
+template <typename BitVectorType, typename Symbol>
+class ShardedWaveletMatrix {
+  //! Type of the wavelet matrix of a single shard.
+  using Shard = WaveletBase<BitVectorType, Symbol, WaveletTypes::MATRIX>;
+
+  //! Number of symbols in the text.
+  size_t text_size_;
+  //! Number of symbols in each shard (except for the last one).
+  size_t shard_size_;
+  //! Size of the alphabet of the text.
+  size_t alphabet_size_;
+
+  //! Wavelet matrices of the shards.
+  std::vector<Shard> shards_;
+  //! Number of occurrences of each symbol before each shard. The counts of a
+  //! symbol are stored consecutively, i.e., the count of symbol \c s before
+  //! shard \c i is at position s * (#shards + 1) + i.
+  std::vector<size_t> symbol_counts_;
+
+public:
+  /*!
+   * \brief Constructor. Builds the shards' wavelet matrices in parallel.
+   *
+   * \tparam InputIterator Iterator type of the text container.
+   * \param begin Iterator to the beginning of the text.
+   * \param end Iterator marking the end of the text.
+   * \param alphabet_size Size of the alphabet of the input text.
+   * \param shard_size Number of symbols in each shard.
+   * \param threads Number of threads used to build the shards.
+   */
+  template <std::random_access_iterator InputIterator>
+  requires SmallAlphabet<std::iter_value_t<InputIterator>>
+  ShardedWaveletMatrix(InputIterator begin,
+                       InputIterator end,
+                       size_t const alphabet_size,
+                       size_t const shard_size,
+                       size_t const threads =
+                           std::thread::hardware_concurrency())
+      : text_size_(std::distance(begin, end)),
+        shard_size_(std::max(size_t{1}, shard_size)),
+        alphabet_size_(alphabet_size),
+        shards_(tlx::div_ceil(text_size_, shard_size_)),
+        symbol_counts_(alphabet_size_ * (shards_.size() + 1), 0) {
+    size_t const shards = shards_.size();
+    {
+      tlx::ThreadPool pool(std::max(size_t{1}, std::min(threads, shards)));
+      for (size_t i = 0; i < shards; ++i) {
+        pool.enqueue([&, i]() {
+          InputIterator const shard_begin = begin + (i * shard_size_);
+          InputIterator const shard_end =
+              begin + std::min(text_size_, (i + 1) * shard_size_);
+          shards_[i] = Shard(shard_begin, shard_end, alphabet_size_);
+          // Counts of the shard are stored at the position of the next shard
+          // and are turned into prefix sums afterwards.
+          Histogram<InputIterator> const hist(shard_begin, shard_end);
+          for (size_t symbol = 0; symbol < alphabet_size_; ++symbol) {
+            symbol_counts_[(symbol * (shards + 1)) + i + 1] =
+                hist[static_cast<Symbol>(symbol)];
+          }
+        });
+      }
+      pool.loop_until_empty();
+    }
+    for (size_t symbol = 0; symbol < alphabet_size_; ++symbol) {
+      size_t* const counts = symbol_counts_.data() + (symbol * (shards + 1));
+      for (size_t i = 1; i <= shards; ++i) {
+        counts[i] += counts[i - 1];
+      }
+    }
+  }
+
+  /*!
+   * \brief Access operator to access characters of the text using the
+   * sharded wavelet matrix.
+   *
+   * \param position Position of the character that should be retrieved.
+   * \return Character at position \c position.
+   */
+  [[nodiscard("Wavelet matrix accessed but result not used")]] Symbol
+  operator[](size_t const position) const noexcept {
+    return shards_[position / shard_size_][position % shard_size_];
+  }
+
+  /*!
+   * \brief Computes rank-queries, i.e., the number of occurrences of a symbol
+   * before a position.
+   *
+   * \param position Position up to which the occurrences are counted.
+   * \param symbol Symbol whose occurrences are counted.
+   * \return Number of occurrences of \c symbol before \c position.
+   */
+  [[nodiscard("Wavelet matrix rank computed but result not used")]] size_t
+  rank(size_t const position, Symbol const symbol) const noexcept {
+    size_t const shard = position / shard_size_;
+    size_t const before =
+        symbol_counts_[(symbol * (shards_.size() + 1)) + shard];
+    if (shard == shards_.size()) {
+      return before;
+    }
+    return before + shards_[shard].rank(position % shard_size_, symbol);
+  }
+
+  /*!
+   * \brief Computes the position a symbol with a specific rank, i.e., the
+   * rank-th occurrence of a symbol.
+   *
+   * \param rank The rank of the symbol that is looked for.
+   * \param symbol The symbol the position of the rank-th occurrence is looked
+   * for.
+   * \return Position of the \c rank-th occurrence of \c symbol or the size
+   * of the text, if there is no such occurrence.
+   */
+  [[nodiscard("Wavelet matrix select computed but result not used")]] size_t
+  select(size_t const rank, Symbol const symbol) const noexcept {
+    auto const counts_begin =
+        symbol_counts_.begin() + (symbol * (shards_.size() + 1));
+    auto const counts_end = counts_begin + shards_.size() + 1;
+    if (rank == 0 || *(counts_end - 1) < rank) {
+      return text_size_;
+    }
+    // First shard boundary with at least rank occurrences before it; the
+    // occurrence is in the shard before that boundary.
+    size_t const shard =
+        std::distance(counts_begin,
+                      std::lower_bound(counts_begin + 1, counts_end, rank)) -
+        1;
+    return (shard * shard_size_) +
+           shards_[shard].select(rank - counts_begin[shard], symbol);
+  }
+
+  /*!
+   * \brief Number of shards.
+   *
+   * \return Number of shards the text is split into.
+   */
+  [[nodiscard]] size_t shards() const noexcept {
+    return shards_.size();
+  }
+
+  /*!
+   * \brief Size of the text.
+   *
+   * \return Number of symbols in the text.
+   */
+  [[nodiscard]] size_t size() const noexcept {
+    return text_size_;
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    size_t space = symbol_counts_.size() * sizeof(size_t);
+    for (auto const& shard : shards_) {
+      space += shard.space_usage();
+    }
+    return space;
+  }
+}; // class ShardedWaveletMatrix
+
+/*!
+ * \brief Factory function to construct a sharded wavelet matrix (for better
+ * template deduction).
+ *
+ * \tparam BitVectorType Type of bit vector used in the wavelet matrices.
+ * \tparam InputIterator Iterator type of the iterator used for text access.
+ * \param begin Iterator to the beginning of the text.
+ * \param end Iterator marking the end of the text.
+ * \param alphabet_size Size of the alphabet of the input text.
+ * \param shard_size Number of symbols in each shard.
+ * \param threads Number of threads used to build the shards.
+ * \return Sharded wavelet matrix for the given input text.
+ */
+template <typename BitVectorType, std::random_access_iterator InputIterator>
+[[nodiscard("Sharded wavelet matrix created and not used")]]
+ShardedWaveletMatrix<BitVectorType, std::iter_value_t<InputIterator>>
+make_sharded_wm(InputIterator begin,
+                InputIterator end,
+                size_t const alphabet_size,
+                size_t const shard_size,
+                size_t const threads = std::thread::hardware_concurrency()) {
+  return ShardedWaveletMatrix<BitVectorType, std::iter_value_t<InputIterator>>(
+      begin, end, alphabet_size, shard_size, threads);
+}
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -20,15 +20,24 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <concepts>
 #include <iterator>
+#include <optional>
+#include <span>
+#include <utility>
 #include <vector>
 
 #include <pasta/bit_vector/bit_vector.hpp>
 #include <pasta/bit_vector/support/flat_rank_select.hpp>
 #include <pasta/utils/concepts/alphabet.hpp>
 #include <pasta/utils/histogram.hpp>
+#include <tlx/container/d_ary_heap.hpp>
+#include <tlx/container/loser_tree.hpp>
 
+#include "pasta/wavelet_tree/packed_span.hpp"
 #include "pasta/wavelet_tree/prefix_counting.hpp"
 #include "pasta/wavelet_tree/wavelet_types.hpp"
 
@@ -80,12 +89,89 @@ class WaveletBase {
   //! Not used when this is a wavelet tree.
   std::array<size_t, IsMatrix ? MaxLevels : 0> ones_before_;
 
-  ///! Memory needed for backtracking in select queries
-  mutable std::vector<size_t> backtrack_interval_starts_;
-  ///! Memory needed for backtracking in select queries.
-  mutable std::vector<size_t> backtrack_interval_ranks_;
+  /*!
+   * \brief Interval of positions on a single level of the wavelet
+   * tree/matrix.
+   *
+   * All positions are relative to the beginning of the level. For the wavelet
+   * tree, we also need the node containing the interval to navigate. The node
+   * is not required (and not maintained) for the wavelet matrix.
+   */
+  struct LevelInterval {
+    //! First position of the node containing the interval. For the wavelet
+    //! matrix, this is the first position of the zeros' or ones' block.
+    size_t node_start;
+    //! Position after the last position of the node (tree only).
+    size_t node_end;
+    //! First position of the interval.
+    size_t start;
+    //! Position after the last position of the interval.
+    size_t end;
+
+    //! Number of positions in the interval.
+    [[nodiscard]] size_t size() const noexcept {
+      return end - start;
+    }
+  }; // struct LevelInterval
+
+  /*!
+   * \brief Node of the wavelet tree/matrix (restricted to an interval) that
+   * is visited during a traversal.
+   */
+  struct TraversalFrame {
+    //! Interval on the level of the node.
+    LevelInterval interval;
+    //! Level of the node.
+    size_t level;
+    //! Bits of the symbols in the node's subtree seen so far.
+    uint64_t prefix;
+  }; // struct TraversalFrame
+
+  /*!
+   * \brief Information about one level on the path from the root to a leaf,
+   * which is needed to map positions of the leaf back to the text.
+   */
+  struct PathLevel {
+    //! First position (in the whole bit vector) of the bits that are mapped
+    //! to the child, i.e., the beginning of the node or the level.
+    size_t region_start;
+    //! Number of ones before \c region_start.
+    size_t ones_before_region;
+    //! First position of the child on the next level.
+    size_t child_start;
+  }; // struct PathLevel
+
+  /*!
+   * \brief Cursor over the positions of a leaf interval, i.e., over
+   * occurrences of the same symbol in increasing text order.
+   *
+   * The cursor stores the position of the current occurrence on each level.
+   * The next occurrence is found by scanning for the next bits on each
+   * level, which is cheaper than a select query, if the occurrences are close.
+   */
+  struct LeafCursor {
+    //! Symbol of the leaf.
+    Symbol symbol;
+    //! Current position in the leaf.
+    size_t position;
+    //! Position after the last position of the leaf interval.
+    size_t end;
+    //! Path from the root to the leaf.
+    std::array<PathLevel, MaxLevels> path;
+    //! Position (in the whole bit vector) of the current occurrence on each
+    //! level.
+    std::array<size_t, MaxLevels> positions;
+  }; // struct LeafCursor
+
+  //! Number of 64-bit words scanned for the next occurrence on a level
+  //! before falling back to a select query.
+  static constexpr size_t ScanWords = 8;
 
 public:
+  //! Default constructor. Creates an empty wavelet tree/matrix, which can be
+  //! used as placeholder that is move-assigned later.
+  WaveletBase() noexcept : levels_(0), text_size_(0) {}
+
   /*!
    * \brief Constructor. Constructs the wavelet base if a compressed bit
    * vector is used.
@@ -101,9 +187,7 @@ public:
               size_t const alphabet_size)
   noexcept
       : levels_(std::bit_width(alphabet_size - 1)),
-        text_size_(std::distance(begin, end)),
-        backtrack_interval_starts_(levels_ + 1, 0),
-        backtrack_interval_ranks_(levels_ + 1, 0) {
+        text_size_(std::distance(begin, end)) {
 
     BitVector tmp_bv(text_size_ * levels_, 0);
     prefix_counting<WaveletType>(begin, end, levels_, tmp_bv);
@@ -127,14 +211,49 @@ public:
                   size_t const alphabet_size)
   noexcept
       : levels_(std::bit_width(alphabet_size - 1)),
-        text_size_(std::distance(begin, end)), bv_(text_size_ * levels_, 0),
-        backtrack_interval_starts_(levels_ + 1, 0),
-        backtrack_interval_ranks_(levels_ + 1, 0) {
+        text_size_(std::distance(begin, end)), bv_(text_size_ * levels_, 0) {
 
     prefix_counting<WaveletType>(begin, end, levels_, bv_);
     init_rank_select();
   }
 
+  /*!
+   * \brief Constructor. Constructs the wavelet base consuming the text,
+   * i.e., the text is freed as soon as all levels are computed. Thus, the
+   * text is never kept in memory together with the rank and select support
+   * (or the compressed bit vector), which reduces the peak memory usage to
+   * the text and the uncompressed bit vector.
+   *
+   * \param text Text, which is empty afterwards.
+   * \param alphabet_size size of the alphabet of the input text.
+   */
+  WaveletBase(std::vector<Symbol>&& text, size_t const alphabet_size)
+  requires SmallAlphabet<Symbol>
+      : levels_(std::bit_width(alphabet_size - 1)), text_size_(text.size()) {
+    BitVector tmp_bv(text_size_ * levels_, 0);
+    prefix_counting<WaveletType>(text.begin(), text.end(), levels_, tmp_bv);
+    std::vector<Symbol>().swap(text);
+    bv_ = BitVectorType(std::move(tmp_bv));
+    init_rank_select();
+  }
+
+  /*!
+   * \brief Constructor. Constructs the wavelet base from a bit vector that
+   * already contains all levels of the wavelet tree/matrix (in the layout
+   * computed by \ref prefix_counting()), e.g., when the levels have been
+   * computed without keeping the whole text in memory.
+   *
+   * \param bv Bit vector containing all levels (of size \c text_size *
+   * \c levels).
+   * \param text_size Number of symbols in the text.
+   * \param levels Number of levels of the wavelet tree/matrix.
+   */
+  WaveletBase(BitVector&& bv, size_t const text_size, size_t const levels)
+      : levels_(levels), text_size_(text_size),
+        bv_(BitVectorType(std::move(bv))) {
+    init_rank_select();
+  }
+
   /*!
    * \brief Access operator to access characters of the text using the wavelet
    * tree/matrix.
@@ -184,7 +303,10 @@ public:
               (position - (level * text_size_)) - ones_before;
           position = (level + 1) * text_size_ + zeros_before;
         }
-        bit = bv_[position];
+        // There is no bit to read after the last level.
+        if (level + 1 < levels_) {
+          bit = bv_[position];
+        }
       }
     }
     return result;
@@ -261,6 +383,11 @@ public:
    */
   [[nodiscard("Wavelet tree select computed but result not used")]] size_t
   select(size_t rank, Symbol const symbol) const noexcept {
+    // The intervals are stored on the stack (and not in members), such that
+    // queries can be answered concurrently.
+    std::array<size_t, MaxLevels + 1> backtrack_interval_starts;
+    std::array<size_t, MaxLevels + 1> backtrack_interval_ranks;
+    backtrack_interval_starts[0] = 0;
     uint64_t bit_mask = 1ULL << (levels_ - 1);
     size_t interval_start = 0;
     if constexpr (IsTree) {
@@ -273,7 +400,7 @@ public:
         size_t const ones_before_interval = rss_.rank1(interval_start);
         size_t const ones_before_position =
             rss_.rank1(interval_start + interval_size) - ones_before_interval;
-        backtrack_interval_ranks_[level] = ones_before_interval;
+        backtrack_interval_ranks[level] = ones_before_interval;
         if (symbol & bit_mask) {
           interval_start += (interval_size - ones_before_position);
           interval_size = ones_before_position;
@@ -281,7 +408,7 @@ public:
           interval_size -= ones_before_position;
         }
         interval_start += text_size_;
-        backtrack_interval_starts_[level + 1] = interval_start;
+        backtrack_interval_starts[level + 1] = interval_start;
         bit_mask >>= 1;
       }
       if (interval_size == 0 || interval_size < rank) {
@@ -293,7 +420,7 @@ public:
         size_t const ones_before_interval = rss_.rank1(interval_start);
         size_t const ones_before_position =
             rss_.rank1(interval_start + rank) - ones_before_interval;
-        backtrack_interval_ranks_[level] = ones_before_interval;
+        backtrack_interval_ranks[level] = ones_before_interval;
         size_t const ones_in_interval =
             ones_before_interval - ones_before_[level];
         if (symbol & bit_mask) {
@@ -306,15 +433,15 @@ public:
               ((level + 1) * text_size_) +
               (interval_start - (level * text_size_) - ones_in_interval);
         }
-        backtrack_interval_starts_[level + 1] = interval_start;
+        backtrack_interval_starts[level + 1] = interval_start;
         bit_mask >>= 1;
       }
       rank = init_rank;
     }
     bit_mask = 1ULL;
     for (size_t level = levels_; level > 0; --level) {
-      interval_start = backtrack_interval_starts_[level - 1];
-      size_t const ones_before_interval = backtrack_interval_ranks_[level - 1];
+      interval_start = backtrack_interval_starts[level - 1];
+      size_t const ones_before_interval = backtrack_interval_ranks[level - 1];
       if (symbol & bit_mask) {
         rank = rss_.select1(ones_before_interval + rank) - interval_start + 1;
       } else {
@@ -326,15 +453,790 @@ public:
     return rank - 1;
   }
 
+  /*!
+   * \brief Decodes all symbols in the interval [start, end).
+   *
+   * Instead of traversing the levels once per position (as the access
+   * operator does), the symbols are decoded level by level. On each level,
+   * the positions sharing the same prefix form an interval, whose bits are
+   * read sequentially using a cursor per prefix. Only the borders of these
+   * intervals require rank queries, i.e., the number of rank queries does not
+   * depend on the length of the interval. For intervals that are short
+   * compared to the alphabet, the access operator is used instead.
+   *
+   * \tparam OutputIterator Random access iterator the symbols are written to.
+   * \param start First position of the interval.
+   * \param end Position after the last position of the interval.
+   * \param out Iterator to the beginning of the output, which must have room
+   * for \c end - \c start symbols.
+   */
+  template <std::random_access_iterator OutputIterator>
+  void extract(size_t const start, size_t const end, OutputIterator out) const {
+    if (start >= end) {
+      return;
+    }
+    size_t const length = end - start;
+    size_t const max_prefixes = size_t{1} << levels_;
+    if (length * 4 < max_prefixes) {
+      for (size_t i = 0; i < length; ++i) {
+        out[i] = operator[](start + i);
+      }
+      return;
+    }
+
+    // The intervals of all prefixes on the current and the next level.
+    std::vector<LevelInterval> intervals(max_prefixes);
+    std::vector<LevelInterval> next_intervals(max_prefixes);
+    intervals[0] = {0, text_size_, start, end};
+    std::fill_n(out, length, Symbol{0});
+    for (size_t level = 0; level < levels_; ++level) {
+      size_t const prefixes = size_t{1} << level;
+      // The intervals on the next level are computed before the cursors
+      // (the intervals' starts) are moved.
+      for (size_t prefix = 0; prefix < prefixes; ++prefix) {
+        if (intervals[prefix].size() == 0) {
+          next_intervals[2 * prefix] = next_intervals[(2 * prefix) + 1] =
+              LevelInterval{0, 0, 0, 0};
+          continue;
+        }
+        auto const [zeros, ones] = split(intervals[prefix], level);
+        next_intervals[2 * prefix] = zeros;
+        next_intervals[(2 * prefix) + 1] = ones;
+      }
+      size_t const level_start = level * text_size_;
+      for (size_t i = 0; i < length; ++i) {
+        Symbol const prefix = out[i];
+        out[i] = static_cast<Symbol>(
+            (prefix << 1) |
+            (bv_[level_start + intervals[prefix].start++] ? 1 : 0));
+      }
+      std::swap(intervals, next_intervals);
+    }
+  }
+
+  /*!
+   * \brief Decodes all symbols in the interval [start, end).
+   *
+   * \param start First position of the interval.
+   * \param end Position after the last position of the interval.
+   * \return The symbols in the interval [\c start, \c end).
+   */
+  [[nodiscard("Wavelet tree extract computed but result not used")]] std::
+      vector<Symbol>
+      extract(size_t const start, size_t const end) const {
+    std::vector<Symbol> result(start < end ? end - start : 0);
+    extract(start, end, result.begin());
+    return result;
+  }
+
+  /*!
+   * \brief Computes the k-th smallest symbol in the interval [start, end),
+   * i.e., the symbol that would be at position k if the interval was
+   * sorted.
+   *
+   * \param start First position of the interval.
+   * \param end Position after the last position of the interval.
+   * \param k Rank (starting at 0) of the symbol in the sorted interval. Must
+   * be smaller than end - start.
+   * \return The k-th smallest symbol in the interval [\c start, \c end).
+   */
+  [[nodiscard("Wavelet tree quantile computed but result not used")]] Symbol
+  quantile(size_t const start, size_t const end, size_t k) const noexcept {
+    Symbol result = 0ULL;
+    LevelInterval interval = {0, text_size_, start, end};
+    for (size_t level = 0; level < levels_; ++level) {
+      auto const [zeros, ones] = split(interval, level);
+      result <<= 1;
+      if (k < zeros.size()) {
+        interval = zeros;
+      } else {
+        k -= zeros.size();
+        result |= 1ULL;
+        interval = ones;
+      }
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Computes the number of symbols in the interval [start, end) that
+   * are smaller than a given symbol.
+   *
+   * \param start First position of the interval.
+   * \param end Position after the last position of the interval.
+   * \param symbol The symbol the smaller symbols are counted of.
+   * \return Number of positions i in [\c start, \c end) with T[i] <
+   * \c symbol.
+   */
+  [[nodiscard("Wavelet tree count_less computed but result not used")]] size_t
+  count_less(size_t const start,
+             size_t const end,
+             Symbol const symbol) const noexcept {
+    if (static_cast<uint64_t>(symbol) >= (1ULL << levels_)) {
+      return end - start;
+    }
+    size_t result = 0;
+    uint64_t bit_mask = 1ULL << (levels_ - 1);
+    LevelInterval interval = {0, text_size_, start, end};
+    for (size_t level = 0; level < levels_ && interval.size() > 0; ++level) {
+      auto const [zeros, ones] = split(interval, level);
+      if (symbol & bit_mask) {
+        result += zeros.size();
+        interval = ones;
+      } else {
+        interval = zeros;
+      }
+      bit_mask >>= 1;
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Computes the number of symbols in the interval [start, end) that
+   * are in the range of symbols [lower, upper].
+   *
+   * Both bounds are counted in one traversal. As long as the bounds share
+   * the same prefix, the same intervals are used for both of them.
+   *
+   * \param start First position of the interval.
+   * \param end Position after the last position of the interval.
+   * \param lower Smallest symbol that is counted.
+   * \param upper Largest symbol that is counted.
+   * \return Number of positions i in [\c start, \c end) with \c lower <= T[i]
+   * <= \c upper.
+   */
+  [[nodiscard("Wavelet tree count_range computed but result not used")]] size_t
+  count_range(size_t const start,
+              size_t const end,
+              Symbol const lower,
+              Symbol upper) const noexcept {
+    if (!clip_symbol_range(lower, upper)) {
+      return 0;
+    }
+    size_t less_than_lower = 0;
+    size_t less_than_upper = 0;
+    bool shared_prefix = true;
+    uint64_t bit_mask = 1ULL << (levels_ - 1);
+    LevelInterval lower_interval = {0, text_size_, start, end};
+    LevelInterval upper_interval = lower_interval;
+    for (size_t level = 0; level < levels_ && (lower_interval.size() > 0 ||
+                                               upper_interval.size() > 0);
+         ++level) {
+      auto const upper_children = split(upper_interval, level);
+      auto const lower_children =
+          shared_prefix ? upper_children : split(lower_interval, level);
+      bool const lower_bit = lower & bit_mask;
+      bool const upper_bit = upper & bit_mask;
+      if (lower_bit) {
+        less_than_lower += lower_children[0].size();
+      }
+      if (upper_bit) {
+        less_than_upper += upper_children[0].size();
+      }
+      lower_interval = lower_children[lower_bit];
+      upper_interval = upper_children[upper_bit];
+      shared_prefix = shared_prefix && (lower_bit == upper_bit);
+      bit_mask >>= 1;
+    }
+    return (less_than_upper + upper_interval.size()) - less_than_lower;
+  }
+
+  /*!
+   * \brief Computes the smallest symbol in the interval [start, end) that is
+   * greater than or equal to a given symbol.
+   *
+   * We follow the path of \c symbol and remember the deepest level at which
+   * we could have branched to a larger symbol. If \c symbol does not occur,
+   * we continue from there with the smallest symbol in the subtree.
+   *
+   * \param start First position of the interval.
+   * \param end Position after the last position of the interval.
+   * \param symbol The symbol the successor is searched for.
+   * \return The smallest symbol greater than or equal to \c symbol in
+   * [\c start, \c end) or \c std::nullopt if there is no such symbol.
+   */
+  [[nodiscard("Wavelet tree next_value computed but result not used")]] std::
+      optional<Symbol>
+      next_value(size_t const start,
+                 size_t const end,
+                 Symbol const symbol) const noexcept {
+    if (start >= end || static_cast<uint64_t>(symbol) >= (1ULL << levels_)) {
+      return std::nullopt;
+    }
+    LevelInterval interval = {0, text_size_, start, end};
+    size_t branch_level = levels_;
+    LevelInterval branch_interval = interval;
+    uint64_t bit_mask = 1ULL << (levels_ - 1);
+    size_t level = 0;
+    for (; level < levels_; ++level) {
+      auto const [zeros, ones] = split(interval, level);
+      if (symbol & bit_mask) {
+        interval = ones;
+      } else {
+        if (ones.size() > 0) {
+          branch_level = level;
+          branch_interval = ones;
+        }
+        interval = zeros;
+      }
+      if (interval.size() == 0) {
+        break;
+      }
+      bit_mask >>= 1;
+    }
+    if (level == levels_) {
+      return symbol;
+    }
+    if (branch_level == levels_) {
+      return std::nullopt;
+    }
+
+    uint64_t result =
+        ((static_cast<uint64_t>(symbol) >> (levels_ - branch_level)) << 1) |
+        1ULL;
+    interval = branch_interval;
+    for (level = branch_level + 1; level < levels_; ++level) {
+      auto const [zeros, ones] = split(interval, level);
+      result <<= 1;
+      if (zeros.size() > 0) {
+        interval = zeros;
+      } else {
+        result |= 1ULL;
+        interval = ones;
+      }
+    }
+    return static_cast<Symbol>(result);
+  }
+
+  /*!
+   * \brief Computes the k most frequent symbols in the interval [start, end).
+   *
+   * The nodes are visited best-first, i.e., the node with the largest interval
+   * is expanded next. Since the interval of a node is never smaller than the
+   * intervals of its children, leaves are found in decreasing order of
+   * frequency and the traversal stops after k leaves.
+   *
+   * \param start First position of the interval.
+   * \param end Position after the last position of the interval.
+   * \param k Number of symbols that are reported.
+   * \return Up to \c k pairs (symbol, frequency) in decreasing order of
+   * frequency. Symbols with the same frequency are ordered arbitrarily.
+   */
+  [[nodiscard("Wavelet tree top_k computed but result not used")]] std::vector<
+      std::pair<Symbol, size_t>>
+  top_k(size_t const start, size_t const end, size_t const k) const {
+    std::vector<std::pair<Symbol, size_t>> result;
+    if (start >= end || k == 0) {
+      return result;
+    }
+    result.reserve(std::min({k, end - start, size_t{1} << levels_}));
+
+    auto const larger_interval = [](TraversalFrame const& lhs,
+                                    TraversalFrame const& rhs) {
+      return lhs.interval.size() > rhs.interval.size();
+    };
+    tlx::d_ary_heap<TraversalFrame, 4, decltype(larger_interval)> heap(
+        larger_interval);
+    heap.push(TraversalFrame{{0, text_size_, start, end}, 0, 0});
+    while (!heap.empty() && result.size() < k) {
+      TraversalFrame const frame = heap.top();
+      heap.pop();
+      if (frame.level == levels_) {
+        result.emplace_back(static_cast<Symbol>(frame.prefix),
+                            frame.interval.size());
+        continue;
+      }
+      auto const [zeros, ones] = split(frame.interval, frame.level);
+      if (zeros.size() > 0) {
+        heap.push(TraversalFrame{zeros, frame.level + 1, frame.prefix << 1});
+      }
+      if (ones.size() > 0) {
+        heap.push(
+            TraversalFrame{ones, frame.level + 1, (frame.prefix << 1) | 1ULL});
+      }
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Computes the majority symbol in the interval [start, end), i.e.,
+   * the symbol occurring more than (end - start) / 2 times.
+   *
+   * Only the child containing more than half of the interval can contain the
+   * majority, i.e., there is a single path to follow.
+   *
+   * \param start First position of the interval.
+   * \param end Position after the last position of the interval.
+   * \return The majority symbol or \c std::nullopt if there is none.
+   */
+  [[nodiscard("Wavelet tree majority computed but result not used")]] std::
+      optional<Symbol>
+      majority(size_t const start, size_t const end) const noexcept {
+    auto const [symbol, frequency] = majority_path(start, end);
+    if (frequency == 0) {
+      return std::nullopt;
+    }
+    return symbol;
+  }
+
+  /*!
+   * \brief Computes the most frequent symbol in the interval [start, end).
+   *
+   * If there is a majority symbol, it is found following a single path.
+   * Otherwise, we fall back to the best-first traversal of \ref top_k().
+   *
+   * \param start First position of the interval.
+   * \param end Position after the last position of the interval. Must be
+   * greater than \c start.
+   * \return Pair (symbol, frequency) of a most frequent symbol.
+   */
+  [[nodiscard("Wavelet tree mode computed but result not used")]] std::pair<
+      Symbol,
+      size_t>
+  mode(size_t const start, size_t const end) const {
+    auto const majority = majority_path(start, end);
+    if (majority.second > 0) {
+      return majority;
+    }
+    return top_k(start, end, 1).front();
+  }
+
+  /*!
+   * \brief Reports all distinct symbols in the interval [start, end) together
+   * with their frequencies.
+   *
+   * Subtrees that do not contain positions of the interval are skipped, i.e.,
+   * the running time depends on the number of distinct symbols in the
+   * interval (times the number of levels) and not on the alphabet size.
+   *
+   * \tparam ReportFunction Function called as report(symbol, frequency) for
+   * each distinct symbol (in increasing order of symbols).
+   * \param start First position of the interval.
+   * \param end Position after the last position of the interval.
+   * \param report Function called for each distinct symbol.
+   * \return Number of distinct symbols in the interval.
+   */
+  template <typename ReportFunction>
+  size_t distinct(size_t const start,
+                  size_t const end,
+                  ReportFunction report) const noexcept {
+    if (start >= end) {
+      return 0;
+    }
+    size_t count = 0;
+    for_each_leaf_2d<false>(start, end, Symbol{0},
+                            static_cast<Symbol>((1ULL << levels_) - 1),
+                            [&](LevelInterval const& leaf, Symbol const symbol,
+                                auto const&) {
+      report(symbol, leaf.size());
+      ++count;
+    });
+    return count;
+  }
+
+  /*!
+   * \brief Computes all distinct symbols in the interval [start, end) together
+   * with their frequencies.
+   *
+   * \param start First position of the interval.
+   * \param end Position after the last position of the interval.
+   * \return Pairs (symbol, frequency) in increasing order of symbols.
+   */
+  [[nodiscard("Wavelet tree distinct computed but result not used")]] std::
+      vector<std::pair<Symbol, size_t>>
+      distinct(size_t const start, size_t const end) const {
+    std::vector<std::pair<Symbol, size_t>> result;
+    distinct(start, end, [&](Symbol const symbol, size_t const frequency) {
+      result.emplace_back(symbol, frequency);
+    });
+    return result;
+  }
+
+  /*!
+   * \brief Reports all symbols that occur in each of the given intervals
+   * together with their frequencies in the intervals.
+   *
+   * All intervals are traversed simultaneously. A subtree is skipped as soon
+   * as one of the intervals does not contain any positions in it.
+   *
+   * \tparam ReportFunction Function called as report(symbol, frequencies) for
+   * each symbol occurring in all intervals (in increasing order of symbols),
+   * where \c frequencies is a \c std::span<size_t const> containing the
+   * frequency of the symbol in the i-th interval at position i.
+   * \param ranges Intervals given as pairs [first, second).
+   * \param report Function called for each symbol occurring in all
+   * intervals.
+   * \return Number of symbols occurring in all intervals.
+   */
+  template <typename ReportFunction>
+  size_t intersect(std::span<std::pair<size_t, size_t> const> const ranges,
+                   ReportFunction report) const {
+    size_t const number_ranges = ranges.size();
+    if (number_ranges == 0) {
+      return 0;
+    }
+    // The stack contains (level, prefix) pairs and one interval per range for
+    // each entry. An entry on level l is stored at index at most l (each node
+    // pushes at most two children), i.e., there are at most levels + 1
+    // entries.
+    std::array<std::pair<size_t, uint64_t>, MaxLevels + 1> stack;
+    std::vector<LevelInterval> intervals((levels_ + 1) * number_ranges);
+    std::vector<size_t> frequencies(number_ranges);
+    for (size_t i = 0; i < number_ranges; ++i) {
+      if (ranges[i].first >= ranges[i].second) {
+        return 0;
+      }
+      intervals[i] = {0, text_size_, ranges[i].first, ranges[i].second};
+    }
+    size_t stack_size = 0;
+    stack[stack_size++] = {0, 0};
+
+    size_t count = 0;
+    while (stack_size > 0) {
+      auto const [level, prefix] = stack[--stack_size];
+      LevelInterval* const current =
+          intervals.data() + (stack_size * number_ranges);
+      if (level == levels_) {
+        for (size_t i = 0; i < number_ranges; ++i) {
+          frequencies[i] = current[i].size();
+        }
+        report(static_cast<Symbol>(prefix),
+               std::span<size_t const>(frequencies));
+        ++count;
+        continue;
+      }
+      // The one children replace the current intervals and the zero children
+      // are stored in the next entry, so that they are visited first.
+      LevelInterval* const next = current + number_ranges;
+      bool zeros_non_empty = true;
+      bool ones_non_empty = true;
+      for (size_t i = 0; i < number_ranges; ++i) {
+        auto const [zeros, ones] = split(current[i], level);
+        zeros_non_empty &= (zeros.size() > 0);
+        ones_non_empty &= (ones.size() > 0);
+        next[i] = zeros;
+        current[i] = ones;
+      }
+      if (ones_non_empty) {
+        stack[stack_size++] = {level + 1, (prefix << 1) | 1ULL};
+      } else if (zeros_non_empty) {
+        std::copy_n(next, number_ranges, current);
+      }
+      if (zeros_non_empty) {
+        stack[stack_size++] = {level + 1, prefix << 1};
+      }
+    }
+    return count;
+  }
+
+  /*!
+   * \brief Counts the points in the rectangle [start, end) x [lower, upper],
+   * i.e., the positions in the interval [start, end) containing a symbol in
+   * [lower, upper].
+   *
+   * This is the count-only variant of the 2D range search, which does not
+   * have to visit all leaves in the rectangle (see \ref count_range()).
+   *
+   * \param start First position of the interval.
+   * \param end Position after the last position of the interval.
+   * \param lower Smallest symbol in the rectangle.
+   * \param upper Largest symbol in the rectangle.
+   * \return Number of points in the rectangle.
+   */
+  [[nodiscard("Wavelet tree range_search_2d computed but result not used")]]
+  size_t range_search_2d(size_t const start,
+                         size_t const end,
+                         Symbol const lower,
+                         Symbol const upper) const noexcept {
+    return count_range(start, end, lower, upper);
+  }
+
+  /*!
+   * \brief Reports all points in the rectangle [start, end) x [lower, upper].
+   *
+   * The search is iterative and needs no memory besides a stack of
+   * size O(levels). The points are reported ordered by symbol and then
+   * position. Points of the same leaf are mapped back to the text by scanning
+   * for the next bits on each level instead of a full select chain.
+   *
+   * \tparam ReportFunction Function called as report(position, symbol) for
+   * each point in the rectangle.
+   * \param start First position of the interval.
+   * \param end Position after the last position of the interval.
+   * \param lower Smallest symbol in the rectangle.
+   * \param upper Largest symbol in the rectangle.
+   * \param report Function called for each point in the rectangle.
+   * \return Number of points in the rectangle.
+   */
+  template <typename ReportFunction>
+  size_t range_search_2d(size_t const start,
+                         size_t const end,
+                         Symbol const lower,
+                         Symbol upper,
+                         ReportFunction report) const noexcept {
+    if (!clip_symbol_range(lower, upper) || start >= end) {
+      return 0;
+    }
+    size_t count = 0;
+    LeafCursor cursor;
+    for_each_leaf_2d<true>(start, end, lower, upper,
+                           [&](LevelInterval const& leaf, Symbol const symbol,
+                               auto const& path) {
+      cursor.symbol = symbol;
+      cursor.position = leaf.start;
+      cursor.end = leaf.end;
+      cursor.path = path;
+      report(init_cursor(cursor), symbol);
+      while (cursor.position + 1 < cursor.end) {
+        report(advance_cursor(cursor), symbol);
+      }
+      count += leaf.size();
+    });
+    return count;
+  }
+
+  /*!
+   * \brief Reports all points in the rectangle [start, end) x [lower, upper]
+   * ordered by position.
+   *
+   * The occurrences in each leaf of the rectangle are already ordered by
+   * position. Therefore, we merge the leaves using a loser tree. This requires
+   * memory linear in the number of leaves in the rectangle.
+   *
+   * \tparam ReportFunction Function called as report(position, symbol) for
+   * each point in the rectangle.
+   * \param start First position of the interval.
+   * \param end Position after the last position of the interval.
+   * \param lower Smallest symbol in the rectangle.
+   * \param upper Largest symbol in the rectangle.
+   * \param report Function called for each point in the rectangle.
+   * \return Number of points in the rectangle.
+   */
+  template <typename ReportFunction>
+  size_t range_search_2d_sorted(size_t const start,
+                                size_t const end,
+                                Symbol const lower,
+                                Symbol upper,
+                                ReportFunction report) const {
+    if (!clip_symbol_range(lower, upper) || start >= end) {
+      return 0;
+    }
+    size_t count = 0;
+    std::vector<LeafCursor> cursors;
+    for_each_leaf_2d<true>(start, end, lower, upper,
+                           [&](LevelInterval const& leaf, Symbol const symbol,
+                               auto const& path) {
+      LeafCursor& cursor = cursors.emplace_back();
+      cursor.symbol = symbol;
+      cursor.position = leaf.start;
+      cursor.end = leaf.end;
+      cursor.path = path;
+      count += leaf.size();
+    });
+    if (cursors.empty()) {
+      return 0;
+    }
+
+    using LoserTree = tlx::LoserTreeCopy<false, size_t>;
+    LoserTree loser_tree(static_cast<typename LoserTree::Source>(cursors.size()));
+    for (size_t i = 0; i < cursors.size(); ++i) {
+      size_t const position = init_cursor(cursors[i]);
+      loser_tree.insert_start(&position, i, false);
+    }
+    loser_tree.init();
+    for (size_t i = 0; i < count; ++i) {
+      LeafCursor& cursor = cursors[loser_tree.min_source()];
+      report(cursor.positions[0], cursor.symbol);
+      if (cursor.position + 1 < cursor.end) {
+        size_t const position = advance_cursor(cursor);
+        loser_tree.delete_min_insert(&position, false);
+      } else {
+        loser_tree.delete_min_insert(nullptr, true);
+      }
+    }
+    return count;
+  }
+
+  /*!
+   * \brief Forward iterator over the positions of all occurrences of a
+   * symbol in an interval (in increasing order).
+   *
+   * The path to the symbol's leaf is computed once. Each following occurrence
+   * is found by scanning for the next bit on each level, starting at the
+   * previous occurrence, instead of a full select query (see \ref
+   * advance_cursor()). The iterator is exhausted when it compares equal to
+   * \c std::default_sentinel.
+   *
+   * \tparam Prefetch Whether the cache lines following the current occurrence
+   * on each level are prefetched after each step.
+   */
+  template <bool Prefetch>
+  class OccurrenceIterator {
+    //! The wavelet tree/matrix the occurrences are in.
+    WaveletBase const* wavelet_ = nullptr;
+    //! Cursor over the leaf containing the occurrences.
+    LeafCursor cursor_;
+    //! Text position of the current occurrence.
+    size_t position_ = 0;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = size_t const*;
+    using reference = size_t;
+
+    //! Default constructor (exhausted iterator).
+    OccurrenceIterator() noexcept {
+      cursor_.position = cursor_.end = 0;
+    }
+
+    /*!
+     * \brief Constructor. Maps the first position of the cursor to the text.
+     * \param wavelet The wavelet tree/matrix the cursor belongs to.
+     * \param cursor Cursor with initialized path and leaf interval.
+     */
+    OccurrenceIterator(WaveletBase const* wavelet, LeafCursor const& cursor)
+        : wavelet_(wavelet),
+          cursor_(cursor) {
+      if (cursor_.position < cursor_.end) {
+        position_ = wavelet_->init_cursor(cursor_);
+        if constexpr (Prefetch) {
+          wavelet_->prefetch_cursor(cursor_);
+        }
+      }
+    }
+
+    //! Text position of the current occurrence.
+    size_t operator*() const noexcept {
+      return position_;
+    }
+
+    //! Advances to the next occurrence.
+    OccurrenceIterator& operator++() noexcept {
+      if (cursor_.position + 1 < cursor_.end) {
+        position_ = wavelet_->advance_cursor(cursor_);
+        if constexpr (Prefetch) {
+          wavelet_->prefetch_cursor(cursor_);
+        }
+      } else {
+        cursor_.position = cursor_.end;
+      }
+      return *this;
+    }
+
+    //! Advances to the next occurrence.
+    OccurrenceIterator operator++(int) noexcept {
+      OccurrenceIterator result = *this;
+      ++(*this);
+      return result;
+    }
+
+    //! Number of remaining occurrences (including the current one).
+    size_t remaining() const noexcept {
+      return cursor_.end - cursor_.position;
+    }
+
+    //! Two iterators are equal if they point to the same occurrence.
+    bool operator==(OccurrenceIterator const& other) const noexcept {
+      return remaining() == other.remaining() &&
+             (remaining() == 0 || position_ == other.position_);
+    }
+
+    //! Checks whether all occurrences have been visited.
+    bool operator==(std::default_sentinel_t) const noexcept {
+      return cursor_.position >= cursor_.end;
+    }
+  }; // class OccurrenceIterator
+
+  /*!
+   * \brief Range of all occurrences of a symbol in an interval, which can be
+   * used in range-based for loops.
+   *
+   * \tparam Prefetch See \ref OccurrenceIterator.
+   */
+  template <bool Prefetch>
+  class OccurrenceRange {
+    //! Iterator pointing to the first occurrence.
+    OccurrenceIterator<Prefetch> begin_;
+
+  public:
+    //! Constructor.
+    OccurrenceRange(OccurrenceIterator<Prefetch> begin) : begin_(begin) {}
+
+    //! Iterator pointing to the first occurrence.
+    OccurrenceIterator<Prefetch> begin() const noexcept {
+      return begin_;
+    }
+
+    //! Sentinel marking the end of the occurrences.
+    std::default_sentinel_t end() const noexcept {
+      return std::default_sentinel;
+    }
+
+    //! Number of occurrences.
+    size_t size() const noexcept {
+      return begin_.remaining();
+    }
+  }; // class OccurrenceRange
+
+  /*!
+   * \brief Lazily enumerates the positions of all occurrences of a symbol in
+   * the interval [start, end) in increasing order.
+   *
+   * Finding the leaf requires one top-down traversal. Afterwards, the first
+   * occurrence requires a select query on each level and each following
+   * occurrence usually only a short scan on each level.
+   *
+   * \tparam Prefetch Whether the iterator prefetches the following cache lines
+   * on each level.
+   * \param start First position of the interval.
+   * \param end Position after the last position of the interval.
+   * \param symbol The symbol the occurrences are enumerated of.
+   * \return Range of all occurrences of \c symbol in [\c start, \c end).
+   */
+  template <bool Prefetch = false>
+  [[nodiscard("Wavelet tree occurrences computed but result not used")]]
+  OccurrenceRange<Prefetch> occurrences(size_t const start,
+                                        size_t const end,
+                                        Symbol const symbol) const noexcept {
+    if (start >= end || static_cast<uint64_t>(symbol) >= (1ULL << levels_)) {
+      return OccurrenceRange<Prefetch>(OccurrenceIterator<Prefetch>());
+    }
+    LeafCursor cursor;
+    cursor.symbol = symbol;
+    LevelInterval interval = {0, text_size_, start, end};
+    uint64_t bit_mask = 1ULL << (levels_ - 1);
+    for (size_t level = 0; level < levels_ && interval.size() > 0; ++level) {
+      PathLevel& path_level = cursor.path[level];
+      if constexpr (IsTree) {
+        path_level.region_start = (level * text_size_) + interval.node_start;
+        path_level.ones_before_region = rss_.rank1(path_level.region_start);
+      } else {
+        path_level.region_start = level * text_size_;
+        path_level.ones_before_region = ones_before_[level];
+      }
+      auto const children = split(interval, level);
+      interval = children[(symbol & bit_mask) ? 1 : 0];
+      path_level.child_start = interval.node_start;
+      bit_mask >>= 1;
+    }
+    cursor.position = interval.start;
+    cursor.end = interval.end;
+    if (interval.size() == 0) {
+      cursor.position = cursor.end = 0;
+    }
+    return OccurrenceRange<Prefetch>(
+        OccurrenceIterator<Prefetch>(this, cursor));
+  }
+
   /*!
    * \brief Estimate for the space usage.
    * \return Number of bytes used by this data structure.
    */
   [[nodiscard("space usage computed but not used")]] size_t
   space_usage() const {
-    return (backtrack_interval_starts_.size() * sizeof(size_t)) +
-      (backtrack_interval_ranks_.size() * sizeof(size_t)) +
-      rss_.space_usage() + bv_.space_usage();
+    return rss_.space_usage() + bv_.space_usage();
   }
 
 private:
@@ -353,6 +1255,289 @@ private:
     }
   }
 
+  /*!
+   * \brief Maps an interval on a level to the intervals on the next level
+   * that contain the symbols with a zero and a one bit on this level.
+   *
+   * For the wavelet matrix this requires two rank queries, for the wavelet
+   * tree four (as the borders of the node have to be computed, too).
+   *
+   * \param interval The interval on the current level.
+   * \param level The current level.
+   * \return Intervals on the next level containing the symbols with a zero
+   * bit (first) and one bit (second) on this level.
+   */
+  [[nodiscard]] inline std::array<LevelInterval, 2>
+  split(LevelInterval const& interval, size_t const level) const noexcept {
+    size_t const level_start = level * text_size_;
+    if constexpr (IsTree) {
+      size_t const ones_before_node =
+          rss_.rank1(level_start + interval.node_start);
+      size_t const ones_before_start =
+          rss_.rank1(level_start + interval.start) - ones_before_node;
+      size_t const ones_before_end =
+          rss_.rank1(level_start + interval.end) - ones_before_node;
+      size_t const ones_in_node =
+          rss_.rank1(level_start + interval.node_end) - ones_before_node;
+      size_t const ones_node_start = interval.node_end - ones_in_node;
+      return {LevelInterval{interval.node_start,
+                            ones_node_start,
+                            interval.start - ones_before_start,
+                            interval.end - ones_before_end},
+              LevelInterval{ones_node_start,
+                            interval.node_end,
+                            ones_node_start + ones_before_start,
+                            ones_node_start + ones_before_end}};
+    } else {
+      size_t const ones_before_start =
+          rss_.rank1(level_start + interval.start) - ones_before_[level];
+      size_t const ones_before_end =
+          rss_.rank1(level_start + interval.end) - ones_before_[level];
+      return {LevelInterval{0,
+                            zeros_on_level_[level],
+                            interval.start - ones_before_start,
+                            interval.end - ones_before_end},
+              LevelInterval{zeros_on_level_[level],
+                            text_size_,
+                            zeros_on_level_[level] + ones_before_start,
+                            zeros_on_level_[level] + ones_before_end}};
+    }
+  }
+
+  /*!
+   * \brief Follows the path to the majority symbol in [start, end).
+   *
+   * \param start First position of the interval.
+   * \param end Position after the last position of the interval.
+   * \return Pair (symbol, frequency) of the majority symbol or a pair with
+   * frequency 0 if there is no majority.
+   */
+  [[nodiscard]] inline std::pair<Symbol, size_t>
+  majority_path(size_t const start, size_t const end) const noexcept {
+    size_t const threshold = (end - start) / 2;
+    uint64_t prefix = 0;
+    LevelInterval interval = {0, text_size_, start, end};
+    for (size_t level = 0; level < levels_ && interval.size() > threshold;
+         ++level) {
+      auto const [zeros, ones] = split(interval, level);
+      prefix <<= 1;
+      if (zeros.size() > threshold) {
+        interval = zeros;
+      } else {
+        prefix |= 1ULL;
+        interval = ones;
+      }
+    }
+    if (interval.size() <= threshold) {
+      return {Symbol{0}, 0};
+    }
+    return {static_cast<Symbol>(prefix), interval.size()};
+  }
+
+  /*!
+   * \brief Restricts a symbol range to the symbols that can be represented
+   * in the wavelet tree/matrix.
+   *
+   * \param lower Smallest symbol in the range.
+   * \param upper Largest symbol in the range. Is set to the largest
+   * representable symbol if it is larger.
+   * \return \c false if the range does not contain any representable symbol.
+   */
+  [[nodiscard]] inline bool clip_symbol_range(Symbol const lower,
+                                              Symbol& upper) const noexcept {
+    uint64_t const max_symbol = (1ULL << levels_) - 1;
+    if (lower > upper || static_cast<uint64_t>(lower) > max_symbol) {
+      return false;
+    }
+    if (static_cast<uint64_t>(upper) > max_symbol) {
+      upper = static_cast<Symbol>(max_symbol);
+    }
+    return true;
+  }
+
+  /*!
+   * \brief Iterative traversal of all non-empty leaves in the rectangle
+   * [start, end) x [lower, upper].
+   *
+   * Subtrees that do not contain symbols in [lower, upper] or no positions
+   * of [start, end) are skipped. Children are visited zeros first, i.e., the
+   * leaves are visited in increasing symbol order. As each node pushes at most
+   * two children, the stack never contains more than levels + 1 entries.
+   *
+   * \tparam NeedsPath Whether the path to the leaves is required. If not, the
+   * path passed to \c leaf_function is not initialized.
+   * \tparam LeafFunction Function called as leaf_function(leaf, symbol, path)
+   * for each leaf.
+   * \param start First position of the interval.
+   * \param end Position after the last position of the interval.
+   * \param lower Smallest symbol in the rectangle.
+   * \param upper Largest symbol in the rectangle (must be representable).
+   * \param leaf_function Function called for each leaf.
+   */
+  template <bool NeedsPath, typename LeafFunction>
+  inline void for_each_leaf_2d(size_t const start,
+                               size_t const end,
+                               Symbol const lower,
+                               Symbol const upper,
+                               LeafFunction leaf_function) const noexcept {
+    std::array<TraversalFrame, MaxLevels + 1> stack;
+    std::array<PathLevel, MaxLevels> path;
+    size_t stack_size = 0;
+    stack[stack_size++] = TraversalFrame{{0, text_size_, start, end}, 0, 0};
+    uint64_t const lower_bound = static_cast<uint64_t>(lower);
+    uint64_t const upper_bound = static_cast<uint64_t>(upper);
+
+    while (stack_size > 0) {
+      TraversalFrame const frame = stack[--stack_size];
+      if (NeedsPath && frame.level > 0) {
+        path[frame.level - 1].child_start = frame.interval.node_start;
+      }
+      if (frame.level == levels_) {
+        leaf_function(frame.interval, static_cast<Symbol>(frame.prefix), path);
+        continue;
+      }
+      if constexpr (NeedsPath) {
+        PathLevel& path_level = path[frame.level];
+        if constexpr (IsTree) {
+          path_level.region_start =
+              (frame.level * text_size_) + frame.interval.node_start;
+          path_level.ones_before_region = rss_.rank1(path_level.region_start);
+        } else {
+          path_level.region_start = frame.level * text_size_;
+          path_level.ones_before_region = ones_before_[frame.level];
+        }
+      }
+
+      auto const [zeros, ones] = split(frame.interval, frame.level);
+      size_t const shift = levels_ - frame.level - 1;
+      uint64_t const zero_prefix = frame.prefix << 1;
+      uint64_t const one_prefix = zero_prefix | 1ULL;
+      // The one child is pushed first, so that the zero child is visited
+      // first.
+      if (ones.size() > 0 && (one_prefix << shift) <= upper_bound &&
+          ((one_prefix + 1) << shift) - 1 >= lower_bound) {
+        stack[stack_size++] = TraversalFrame{ones, frame.level + 1, one_prefix};
+      }
+      if (zeros.size() > 0 && (zero_prefix << shift) <= upper_bound &&
+          (one_prefix << shift) - 1 >= lower_bound) {
+        stack[stack_size++] =
+            TraversalFrame{zeros, frame.level + 1, zero_prefix};
+      }
+    }
+  }
+
+  /*!
+   * \brief Maps the current position of a leaf cursor to the text using
+   * select queries on each level.
+   *
+   * \param cursor The cursor, whose path has been set.
+   * \return Text position of the cursor's current position.
+   */
+  inline size_t init_cursor(LeafCursor& cursor) const noexcept {
+    size_t position = cursor.position;
+    Symbol symbol = cursor.symbol;
+    for (size_t level = levels_; level > 0; --level) {
+      PathLevel const& path_level = cursor.path[level - 1];
+      size_t const rank = position - path_level.child_start + 1;
+      size_t const level_position =
+          (symbol & 1ULL) ?
+              rss_.select1(path_level.ones_before_region + rank) :
+              rss_.select0(path_level.region_start -
+                           path_level.ones_before_region + rank);
+      cursor.positions[level - 1] = level_position;
+      position = level_position - ((level - 1) * text_size_);
+      symbol >>= 1;
+    }
+    return position;
+  }
+
+  /*!
+   * \brief Moves the cursor to the next position of the leaf and maps it to
+   * the text.
+   *
+   * On each level, the next occurrence is the delta-th bit with the same
+   * value after the previous occurrence, where delta is the distance of the
+   * occurrences on the level below.
+   *
+   * \param cursor The cursor, which must not be at the last position of the
+   * leaf.
+   * \return Text position of the cursor's new position.
+   */
+  inline size_t advance_cursor(LeafCursor& cursor) const noexcept {
+    size_t position = ++cursor.position;
+    size_t delta = 1;
+    Symbol symbol = cursor.symbol;
+    for (size_t level = levels_; level > 0; --level) {
+      PathLevel const& path_level = cursor.path[level - 1];
+      size_t const rank = position - path_level.child_start + 1;
+      size_t const previous = cursor.positions[level - 1];
+      size_t const level_position =
+          (symbol & 1ULL) ?
+              next_bit<true>(previous, delta,
+                             path_level.ones_before_region + rank) :
+              next_bit<false>(previous, delta,
+                              path_level.region_start -
+                                  path_level.ones_before_region + rank);
+      cursor.positions[level - 1] = level_position;
+      delta = level_position - previous;
+      position = level_position - ((level - 1) * text_size_);
+      symbol >>= 1;
+    }
+    return position;
+  }
+
+  /*!
+   * \brief Prefetches the cache lines following the current occurrence of a
+   * cursor on each level, which are scanned when the cursor is advanced.
+   *
+   * \param cursor The cursor, which has been initialized.
+   */
+  inline void prefetch_cursor(LeafCursor const& cursor) const noexcept {
+    auto const data = bv_.data();
+    for (size_t level = 0; level < levels_; ++level) {
+      // We assume that a cache line has size 64 bytes, i.e., 8 words.
+      size_t const word = std::min((cursor.positions[level] / 64) + 8,
+                                   data.size() - 1);
+      __builtin_prefetch(&data[word], 0, 0);
+    }
+  }
+
+  /*!
+   * \brief Finds the delta-th bit with a given value after a position.
+   *
+   * The following words of the bit vector are scanned. If the bit is not
+   * found in the next \c ScanWords words, a select query is used.
+   *
+   * \tparam Bit Value of the bit that is searched.
+   * \param position Position after which the bit is searched.
+   * \param delta Number of bits with value \c Bit to skip (at least one).
+   * \param rank Rank of the bit that is searched (used for select).
+   * \return Position of the delta-th bit with value \c Bit after
+   * \c position.
+   */
+  template <bool Bit>
+  [[nodiscard]] inline size_t next_bit(size_t const position,
+                                       size_t delta,
+                                       size_t const rank) const noexcept {
+    auto const data = bv_.data();
+    size_t word_position = (position + 1) / 64;
+    uint64_t word = Bit ? data[word_position] : ~data[word_position];
+    word &= (~0ULL) << ((position + 1) % 64);
+    for (size_t scanned = 0; scanned < ScanWords; ++scanned) {
+      size_t const found = std::popcount(word);
+      if (found >= delta) {
+        for (; delta > 1; --delta) {
+          word &= word - 1;
+        }
+        return (word_position * 64) + std::countr_zero(word);
+      }
+      delta -= found;
+      ++word_position;
+      word = Bit ? data[word_position] : ~data[word_position];
+    }
+    return Bit ? rss_.select1(rank) : rss_.select0(rank);
+  }
+
 }; // class WaveletBase
 
 /*!
@@ -393,6 +1578,80 @@ make_wm(InputIterator begin, InputIterator end, size_t const alphabet_size) {
                      WaveletTypes::MATRIX>(begin, end, alphabet_size);
 }
 
+/*!
+ * \brief Factory function to construct a wavelet tree consuming the text
+ * to reduce the peak memory usage (see the corresponding constructor of
+ * \ref WaveletBase).
+ *
+ * \tparam BitVectorType Type of bit vector used in the wavelet tree.
+ * \tparam Symbol Type of characters in the text.
+ * \param text Text, which is empty afterwards.
+ * \param alphabet_size Size of the alphabet of the input text.
+ * \return Wavelet tree for the given input text.
+ */
+template <typename BitVectorType, typename Symbol>
+requires SmallAlphabet<Symbol>
+[[nodiscard("Wavelet tree created and not used")]] WaveletBase<
+    BitVectorType, Symbol, WaveletTypes::TREE>
+make_wt(std::vector<Symbol>&& text, size_t const alphabet_size) {
+  return WaveletBase<BitVectorType, Symbol, WaveletTypes::TREE>(
+      std::move(text), alphabet_size);
+}
+
+/*!
+ * \brief Factory function to construct a wavelet matrix consuming the text
+ * to reduce the peak memory usage (see the corresponding constructor of
+ * \ref WaveletBase).
+ *
+ * \tparam BitVectorType Type of bit vector used in the wavelet matrix.
+ * \tparam Symbol Type of characters in the text.
+ * \param text Text, which is empty afterwards.
+ * \param alphabet_size Size of the alphabet of the input text.
+ * \return Wavelet matrix for the given input text.
+ */
+template <typename BitVectorType, typename Symbol>
+requires SmallAlphabet<Symbol>
+[[nodiscard("Wavelet matrix created and not used")]] WaveletBase<
+    BitVectorType, Symbol, WaveletTypes::MATRIX>
+make_wm(std::vector<Symbol>&& text, size_t const alphabet_size) {
+  return WaveletBase<BitVectorType, Symbol, WaveletTypes::MATRIX>(
+      std::move(text), alphabet_size);
+}
+
+/*!
+ * \brief Factory function to construct a wavelet tree of a text consisting
+ * of packed symbols without unpacking the text.
+ *
+ * \tparam BitVectorType Type of bit vector used in the wavelet tree.
+ * \tparam BitsPerSymbol Number of bits per packed symbol.
+ * \param text Packed text.
+ * \param alphabet_size Size of the alphabet of the input text.
+ * \return Wavelet tree for the given input text.
+ */
+template <typename BitVectorType, size_t BitsPerSymbol>
+[[nodiscard("Wavelet tree created and not used")]] WaveletBase<
+    BitVectorType, uint8_t, WaveletTypes::TREE>
+make_wt(PackedSpan<BitsPerSymbol> const text, size_t const alphabet_size) {
+  return make_wt<BitVectorType>(text.begin(), text.end(), alphabet_size);
+}
+
+/*!
+ * \brief Factory function to construct a wavelet matrix of a text consisting
+ * of packed symbols without unpacking the text.
+ *
+ * \tparam BitVectorType Type of bit vector used in the wavelet matrix.
+ * \tparam BitsPerSymbol Number of bits per packed symbol.
+ * \param text Packed text.
+ * \param alphabet_size Size of the alphabet of the input text.
+ * \return Wavelet matrix for the given input text.
+ */
+template <typename BitVectorType, size_t BitsPerSymbol>
+[[nodiscard("Wavelet matrix created and not used")]] WaveletBase<
+    BitVectorType, uint8_t, WaveletTypes::MATRIX>
+make_wm(PackedSpan<BitsPerSymbol> const text, size_t const alphabet_size) {
+  return make_wm<BitVectorType>(text.begin(), text.end(), alphabet_size);
+}
+
 //! \}
 
 } // namespace pasta
@@ -0,0 +1,103 @@
+/*******************************************************************************
+ * appendable_wavelet_matrix_test.cpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::wavelet_tree is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::wavelet_tree is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::wavelet_tree.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+#include <tlx/die.hpp>
+#include <tlx/math/integer_log2.hpp>
+
+#include <pasta/wavelet_tree/appendable_wavelet_matrix.hpp>
+
+template <typename AppendableWaveletMatrix>
+void test_prefix(AppendableWaveletMatrix const& awm,
+                 std::vector<uint8_t> const& text, size_t const prefix_size,
+                 std::mt19937& mersenne_engine) {
+  die_unequal(awm.size(), prefix_size);
+  std::uniform_int_distribution<size_t> dist(0, prefix_size - 1);
+  for (size_t i = 0; i < 10; ++i) {
+    size_t const position = dist(mersenne_engine);
+    uint8_t const symbol = text[position];
+    die_unequal(awm[position], symbol);
+    size_t const rank =
+        std::count(text.begin(), text.begin() + position + 1, symbol);
+    die_unequal(awm.rank(position + 1, symbol), rank);
+    die_unequal(awm.select(rank, symbol), position);
+  }
+}
+
+template <typename AppendableWaveletMatrix>
+void test_complete(AppendableWaveletMatrix const& awm,
+                   std::vector<uint8_t> const& text,
+                   size_t const alphabet_size) {
+  die_unequal(awm.size(), text.size());
+  std::array<size_t, 256> occ = { 0 };
+  for (size_t i = 0; i < text.size(); ++i) {
+    die_unequal(awm[i], text[i]);
+    auto const char_occ = ++occ[text[i]];
+    die_unequal(char_occ, awm.rank(i + 1, text[i]));
+    die_unequal(i, awm.select(char_occ, text[i]));
+  }
+  for (size_t symbol = 0; symbol < alphabet_size; ++symbol) {
+    die_unequal(occ[symbol], awm.rank(text.size(), symbol));
+    die_unequal(text.size(), awm.select(occ[symbol] + 1, symbol));
+  }
+}
+
+int32_t main() {
+  std::random_device rnd_device;
+  std::mt19937 mersenne_engine(rnd_device());
+
+  for (size_t const alphabet_size : {size_t{4}, size_t{256}}) {
+    std::uniform_int_distribution<size_t> dist(0, alphabet_size - 1);
+    std::vector<uint8_t> text(500'000);
+    std::generate(text.begin(), text.end(),
+                  [&](){ return dist(mersenne_engine); });
+
+    for (bool const background_merge : {false, true}) {
+      size_t const buffer_size = 1'000;
+      pasta::AppendableWaveletMatrix<pasta::BitVector, uint8_t> awm(
+          alphabet_size, buffer_size, background_merge);
+      // Append in chunks of varying size and query in between
+      size_t appended = 0;
+      while (appended < text.size()) {
+        size_t const chunk =
+            std::min(text.size() - appended, (appended % 7'919) + 1);
+        awm.append(text.begin() + appended, text.begin() + appended + chunk);
+        appended += chunk;
+        test_prefix(awm, text, appended, mersenne_engine);
+      }
+      test_complete(awm, text, alphabet_size);
+
+      awm.wait_for_merge();
+      // Segment sizes grow geometrically
+      die_unless(awm.segments() <=
+                 tlx::integer_log2_ceil(text.size() / buffer_size) + 1);
+      die_unless(awm.merge_statistics().merges > 0);
+      test_complete(awm, text, alphabet_size);
+    }
+  }
+
+  return 0;
+}
+
+/******************************************************************************/
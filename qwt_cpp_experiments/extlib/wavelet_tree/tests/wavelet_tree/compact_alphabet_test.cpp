@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * compact_alphabet_test.cpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::wavelet_tree is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::wavelet_tree is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::wavelet_tree.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <bit>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <tlx/die.hpp>
+
+#include <pasta/utils/compact_alphabet.hpp>
+#include <pasta/wavelet_tree/wavelet_tree.hpp>
+
+// Compares the compaction with a std::map based one, and checks that the
+// compacted text can be restored.
+template <typename Symbol>
+void test_compact_alphabet(std::vector<Symbol> const& text,
+                           size_t const threads,
+                           size_t const smallest_symbol) {
+  std::map<Symbol, size_t> expected_mapping;
+  for (auto const symbol : text) {
+    expected_mapping[symbol] = 0;
+  }
+  size_t expected_size = smallest_symbol;
+  for (auto& [symbol, compact_symbol] : expected_mapping) {
+    compact_symbol = expected_size++;
+  }
+
+  std::vector<Symbol> compacted = text;
+  auto const alphabet =
+      pasta::compact_alphabet(compacted, threads, smallest_symbol);
+  die_unequal(alphabet.size(), expected_size);
+  die_unequal(alphabet.levels(),
+              size_t{std::bit_width(std::max<size_t>(expected_size, 1) - 1)});
+  die_unequal(alphabet.symbols().size(), expected_mapping.size());
+  for (size_t i = 0; i < text.size(); ++i) {
+    die_unequal(size_t{compacted[i]}, expected_mapping[text[i]]);
+    die_unequal(alphabet.original(compacted[i]), text[i]);
+  }
+
+  std::vector<Symbol> restored(text.size());
+  alphabet.restore(compacted.data(), compacted.size(), restored.data(),
+                   threads);
+  die_unless(restored == text);
+}
+
+int32_t main() {
+  std::random_device rnd_device;
+  std::mt19937 mersenne_engine(rnd_device());
+
+  // Sparse 32 bit alphabet (e.g., token or user IDs).
+  std::vector<uint32_t> ids(1'000);
+  std::generate(ids.begin(), ids.end(), [&]() { return mersenne_engine(); });
+  std::uniform_int_distribution<size_t> id_dist(0, ids.size() - 1);
+  std::vector<uint32_t> text(1'000'003);
+  std::generate(text.begin(), text.end(),
+                [&]() { return ids[id_dist(mersenne_engine)]; });
+
+  // 16 bit alphabet with symbols that are not the effective alphabet.
+  std::uniform_int_distribution<uint16_t> dist;
+  std::vector<uint16_t> small_text(500'001);
+  std::generate(small_text.begin(), small_text.end(),
+                [&]() { return static_cast<uint16_t>(dist(mersenne_engine) |
+                                                     1); });
+
+  for (size_t const threads : {1, 4}) {
+    for (size_t const smallest_symbol : {0, 1}) {
+      test_compact_alphabet(text, threads, smallest_symbol);
+      test_compact_alphabet(small_text, threads, smallest_symbol);
+    }
+  }
+  test_compact_alphabet(std::vector<uint32_t>(), 4, 0);
+  test_compact_alphabet(std::vector<uint32_t>(17, 42), 4, 0);
+
+  // The compacted text can be stored with smaller symbols and used to
+  // construct the wavelet tree/matrix directly.
+  pasta::CompactAlphabet<uint32_t> const alphabet(text.data(), text.size(), 4);
+  die_unless(alphabet.size() <= 1'000);
+  std::vector<uint16_t> compacted(text.size());
+  alphabet.compact(text.data(), text.size(), compacted.data(), 4);
+
+  auto const wm = pasta::make_wm<pasta::BitVector>(compacted.begin(),
+                                                   compacted.end(),
+                                                   alphabet.size());
+  auto const wt = pasta::make_wt<pasta::BitVector>(compacted.begin(),
+                                                   compacted.end(),
+                                                   alphabet.size());
+  std::vector<size_t> occ(alphabet.size(), 0);
+  for (size_t i = 0; i < text.size(); ++i) {
+    size_t const symbol = alphabet.compact(text[i]);
+    die_unequal(alphabet.original(wm[i]), text[i]);
+    die_unequal(alphabet.original(wt[i]), text[i]);
+    die_unequal(wm.rank(i, symbol), occ[symbol]++);
+  }
+
+  return 0;
+}
+
+/******************************************************************************/
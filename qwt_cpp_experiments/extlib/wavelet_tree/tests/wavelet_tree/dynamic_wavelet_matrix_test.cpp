@@ -0,0 +1,95 @@
+/*******************************************************************************
+ * dynamic_wavelet_matrix_test.cpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::wavelet_tree is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::wavelet_tree is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::wavelet_tree.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+#include <tlx/die.hpp>
+
+#include <pasta/wavelet_tree/dynamic_wavelet_matrix.hpp>
+
+template <typename DynamicWaveletMatrix>
+void test_dynamic_wm(DynamicWaveletMatrix const& dwm,
+                     std::vector<uint8_t> const& text,
+                     size_t const alphabet_size) {
+  die_unequal(dwm.size(), text.size());
+  std::array<size_t, 256> occ = { 0 };
+
+  for (size_t i = 0; i < text.size(); ++i) {
+    auto const result = dwm[i];
+    die_unequal(result, text[i]);
+    auto const char_occ = ++occ[result];
+    die_unequal(char_occ, dwm.rank(i + 1, result));
+    die_unequal(i, dwm.select(char_occ, result));
+  }
+  for (size_t symbol = 0; symbol < alphabet_size; ++symbol) {
+    die_unequal(occ[symbol], dwm.rank(text.size(), symbol));
+    die_unequal(text.size(), dwm.select(occ[symbol] + 1, symbol));
+  }
+}
+
+int32_t main() {
+
+  std::random_device rnd_device;
+  std::mt19937 mersenne_engine(rnd_device());
+
+  for (size_t const alphabet_size : {size_t{2}, size_t{5}, size_t{256}}) {
+    std::uniform_int_distribution<uint8_t> dist(0, alphabet_size - 1);
+
+    std::vector<uint8_t> text(20'000);
+    std::generate(text.begin(), text.end(),
+                  [&](){ return dist(mersenne_engine); });
+    pasta::DynamicWaveletMatrix<uint8_t> dwm(text.begin(), text.end(),
+                                             alphabet_size);
+    test_dynamic_wm(dwm, text, alphabet_size);
+
+    // Random insertions followed by random deletions.
+    for (size_t i = 0; i < 10'000; ++i) {
+      std::uniform_int_distribution<size_t> pos_dist(0, text.size());
+      size_t const position = pos_dist(mersenne_engine);
+      uint8_t const symbol = dist(mersenne_engine);
+      dwm.insert(position, symbol);
+      text.insert(text.begin() + position, symbol);
+    }
+    test_dynamic_wm(dwm, text, alphabet_size);
+    for (size_t i = 0; i < 25'000; ++i) {
+      std::uniform_int_distribution<size_t> pos_dist(0, text.size() - 1);
+      size_t const position = pos_dist(mersenne_engine);
+      dwm.erase(position);
+      text.erase(text.begin() + position);
+    }
+    test_dynamic_wm(dwm, text, alphabet_size);
+
+    // Building by appending results in the same wavelet matrix.
+    pasta::DynamicWaveletMatrix<uint8_t,
+                                pasta::DynamicBitVector<2, 4>> appended(
+        alphabet_size);
+    for (auto const symbol : text) {
+      appended.push_back(symbol);
+    }
+    test_dynamic_wm(appended, text, alphabet_size);
+  }
+
+  return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,76 @@
+/*******************************************************************************
+ * level_wise_construction_test.cpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::wavelet_tree is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::wavelet_tree is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::wavelet_tree.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <tlx/die.hpp>
+
+#include <pasta/wavelet_tree/level_wise_construction.hpp>
+#include <pasta/wavelet_tree/wavelet_tree.hpp>
+
+void test_level_wise_construction(size_t const alphabet_size,
+                                  size_t const text_size,
+                                  pasta::LevelWiseKernels const kernels) {
+  std::random_device rnd_device;
+  std::mt19937 mersenne_engine(rnd_device());
+  std::uniform_int_distribution<size_t> dist(0, alphabet_size - 1);
+
+  std::vector<uint8_t> text(text_size);
+  std::generate(text.begin(), text.end(),
+                [&](){ return static_cast<uint8_t>(dist(mersenne_engine)); });
+
+  // The levels must be equal to the ones computed by prefix counting.
+  auto const wm = pasta::make_wm<pasta::BitVector>(text.begin(), text.end(),
+                                                   alphabet_size);
+  auto const level_wise_wm =
+      pasta::make_wm_level_wise<pasta::BitVector>(text, alphabet_size,
+                                                  kernels);
+  for (size_t i = 0; i < text.size(); ++i) {
+    die_unequal(level_wise_wm[i], text[i]);
+  }
+  for (size_t symbol = 0; symbol < alphabet_size; ++symbol) {
+    for (size_t i = 0; i <= text.size(); i += 97) {
+      die_unequal(level_wise_wm.rank(i, symbol), wm.rank(i, symbol));
+    }
+    size_t const occurrences = std::count(text.begin(), text.end(), symbol);
+    for (size_t rank = 1; rank <= occurrences; rank += 89) {
+      die_unequal(level_wise_wm.select(rank, symbol), wm.select(rank, symbol));
+    }
+  }
+}
+
+int32_t main() {
+  // Sizes that are no multiples of the eight (64) symbols processed at once.
+  for (size_t const text_size : {size_t{7}, size_t{64}, size_t{1'001},
+                                 size_t{100'003}}) {
+    for (size_t const alphabet_size : {2, 3, 4, 17, 200, 256}) {
+      test_level_wise_construction(alphabet_size, text_size,
+                                   pasta::LevelWiseKernels::SCALAR);
+      test_level_wise_construction(alphabet_size, text_size,
+                                   pasta::LevelWiseKernels::AUTO);
+    }
+  }
+
+  return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,87 @@
+/*******************************************************************************
+ * occurrence_table_test.cpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::wavelet_tree is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::wavelet_tree is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::wavelet_tree.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+#include <tlx/die.hpp>
+
+#include <pasta/wavelet_tree/occurrence_table.hpp>
+
+template <typename OccurrenceTable>
+void test_occurrence_table(OccurrenceTable const& occ_table,
+                           std::vector<uint8_t> const& text,
+                           size_t const alphabet_size) {
+  die_unequal(occ_table.size(), text.size());
+  std::array<size_t, 256> occ = { 0 };
+
+  for (size_t i = 0; i < text.size(); ++i) {
+    auto const result = occ_table[i];
+    die_unequal(result, text[i]);
+    auto const char_occ = ++occ[result];
+    die_unequal(char_occ, occ_table.rank(i + 1, result));
+    die_unequal(i, occ_table.select(char_occ, result));
+  }
+  for (size_t symbol = 0; symbol < alphabet_size; ++symbol) {
+    die_unequal(occ[symbol], occ_table.rank(text.size(), symbol));
+    die_unequal(text.size(), occ_table.select(occ[symbol] + 1, symbol));
+    die_unequal(text.size(), occ_table.select(0, symbol));
+  }
+}
+
+template <size_t BitsPerSymbol>
+void test_alphabet(size_t const alphabet_size, size_t const text_size,
+                   bool const skewed) {
+  std::random_device rnd_device;
+  std::mt19937 mersenne_engine(rnd_device());
+  std::uniform_int_distribution<uint8_t> dist(0, alphabet_size - 1);
+
+  // A skewed text contains long runs of the same symbol, which results in
+  // the maximum counters in the blocks.
+  std::vector<uint8_t> text(text_size);
+  for (size_t i = 0; i < text_size; ++i) {
+    text[i] = skewed ? static_cast<uint8_t>((i / 100'000) % alphabet_size)
+                     : dist(mersenne_engine);
+  }
+  pasta::OccurrenceTable<BitsPerSymbol> const occ_table(text.begin(),
+                                                        text.end(),
+                                                        alphabet_size);
+  test_occurrence_table(occ_table, text, alphabet_size);
+}
+
+int32_t main() {
+  // Text sizes that are multiples of the block size, span one and
+  // multiple superblocks.
+  for (size_t const text_size : {size_t{0}, size_t{224}, size_t{1'000},
+                                 size_t{64 * 1024}, size_t{500'000}}) {
+    test_alphabet<2>(2, text_size, false);
+    test_alphabet<2>(4, text_size, false);
+    test_alphabet<4>(5, text_size, false);
+    test_alphabet<4>(16, text_size, false);
+  }
+  test_alphabet<2>(4, 700'000, true);
+  test_alphabet<4>(16, 700'000, true);
+
+  return 0;
+}
+
+/******************************************************************************/
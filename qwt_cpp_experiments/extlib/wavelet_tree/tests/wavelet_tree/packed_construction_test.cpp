@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * packed_construction_test.cpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::wavelet_tree is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::wavelet_tree is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::wavelet_tree.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include <tlx/die.hpp>
+
+#include <pasta/wavelet_tree/packed_span.hpp>
+#include <pasta/wavelet_tree/wavelet_tree.hpp>
+
+static_assert(std::random_access_iterator<pasta::PackedIterator<2>>);
+static_assert(std::random_access_iterator<pasta::PackedIterator<4>>);
+
+template <size_t BitsPerSymbol>
+void test_packed_construction(size_t const alphabet_size,
+                              size_t const text_size) {
+  std::random_device rnd_device;
+  std::mt19937 mersenne_engine(rnd_device());
+  std::uniform_int_distribution<uint8_t> dist(0, alphabet_size - 1);
+
+  std::vector<uint8_t> text(text_size);
+  std::generate(text.begin(), text.end(),
+                [&](){ return dist(mersenne_engine); });
+  std::vector<uint64_t> const packed =
+      pasta::pack_symbols<BitsPerSymbol>(text.begin(), text.end());
+  pasta::PackedSpan<BitsPerSymbol> const span(packed, text.size());
+  die_unequal(span.size(), text.size());
+  die_unless(std::equal(span.begin(), span.end(), text.begin(), text.end()));
+
+  // The wavelet tree/matrix of the packed text must be equal to the one of
+  // the unpacked text.
+  auto const wm = pasta::make_wm<pasta::BitVector>(text.begin(), text.end(),
+                                                   alphabet_size);
+  auto const packed_wm = pasta::make_wm<pasta::BitVector>(span, alphabet_size);
+  auto const wt = pasta::make_wt<pasta::BitVector>(text.begin(), text.end(),
+                                                   alphabet_size);
+  auto const packed_wt = pasta::make_wt<pasta::BitVector>(span, alphabet_size);
+  for (size_t i = 0; i < text.size(); ++i) {
+    die_unequal(packed_wm[i], text[i]);
+    die_unequal(packed_wt[i], text[i]);
+  }
+  for (size_t symbol = 0; symbol < alphabet_size; ++symbol) {
+    for (size_t i = 0; i <= text.size(); i += 97) {
+      die_unequal(packed_wm.rank(i, symbol), wm.rank(i, symbol));
+      die_unequal(packed_wt.rank(i, symbol), wt.rank(i, symbol));
+    }
+  }
+
+  // Texts that do not start at the beginning of a word.
+  if (text_size > 3) {
+    auto const offset_wm = pasta::make_wm<pasta::BitVector>(
+        span.begin() + 3, span.end(), alphabet_size);
+    for (size_t i = 3; i < text.size(); ++i) {
+      die_unequal(offset_wm[i - 3], text[i]);
+    }
+  }
+}
+
+int32_t main() {
+  for (size_t const text_size : {size_t{1}, size_t{31}, size_t{64},
+                                 size_t{1'000}, size_t{100'003}}) {
+    test_packed_construction<2>(2, text_size);
+    test_packed_construction<2>(3, text_size);
+    test_packed_construction<2>(4, text_size);
+    test_packed_construction<4>(5, text_size);
+    test_packed_construction<4>(16, text_size);
+  }
+
+  return 0;
+}
+
+/******************************************************************************/
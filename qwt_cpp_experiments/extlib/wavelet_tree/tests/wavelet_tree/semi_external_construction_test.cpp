@@ -0,0 +1,129 @@
+/*******************************************************************************
+ * semi_external_construction_test.cpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::wavelet_tree is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::wavelet_tree is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::wavelet_tree.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <tlx/die.hpp>
+
+#include <pasta/utils/reduce_alphabet.hpp>
+#include <pasta/wavelet_tree/semi_external_construction.hpp>
+#include <pasta/wavelet_tree/wavelet_tree.hpp>
+
+void test_semi_external_construction(std::string const& path,
+                                     size_t const alphabet_size,
+                                     size_t const text_size,
+                                     size_t const memory_budget) {
+  std::random_device rnd_device;
+  std::mt19937 mersenne_engine(rnd_device());
+  // Use symbols that are not already the effective alphabet.
+  std::uniform_int_distribution<uint8_t> dist(0, alphabet_size - 1);
+
+  std::vector<uint8_t> text(text_size);
+  std::generate(text.begin(), text.end(),
+                [&](){ return static_cast<uint8_t>(
+                           (dist(mersenne_engine) * 3) + 7); });
+  {
+    std::ofstream stream(path, std::ios::out | std::ios::binary);
+    stream.write(reinterpret_cast<char const*>(text.data()), text.size());
+  }
+
+  std::array<size_t, 256> mapping = {0};
+  auto const wm = pasta::make_wm_semi_external<pasta::BitVector>(
+      path, memory_budget, 0, &mapping);
+  auto const wt = pasta::make_wt_semi_external<pasta::BitVector>(
+      path, memory_budget);
+
+  std::vector<uint8_t> const raw_text = text;
+  std::array<size_t, 256> expected_mapping = {0};
+  size_t const reduced_alphabet_size =
+      pasta::reduce_alphabet(text.begin(), text.end(), &expected_mapping);
+  die_unless(mapping == expected_mapping);
+
+  // The wavelet tree/matrix must be equal to the one computed in memory.
+  auto const expected_wm = pasta::make_wm<pasta::BitVector>(
+      text.begin(), text.end(), reduced_alphabet_size);
+  auto const expected_wt = pasta::make_wt<pasta::BitVector>(
+      text.begin(), text.end(), reduced_alphabet_size);
+  for (size_t i = 0; i < text.size(); ++i) {
+    die_unequal(wm[i], text[i]);
+    die_unequal(wt[i], text[i]);
+  }
+  for (size_t symbol = 0; symbol < reduced_alphabet_size; ++symbol) {
+    for (size_t i = 0; i <= text.size(); i += 97) {
+      die_unequal(wm.rank(i, symbol), expected_wm.rank(i, symbol));
+      die_unequal(wt.rank(i, symbol), expected_wt.rank(i, symbol));
+    }
+    size_t const occurrences = std::count(text.begin(), text.end(), symbol);
+    for (size_t rank = 1; rank <= occurrences; rank += 89) {
+      die_unequal(wm.select(rank, symbol), expected_wm.select(rank, symbol));
+      die_unequal(wt.select(rank, symbol), expected_wt.select(rank, symbol));
+    }
+  }
+
+  // Only a prefix of the file is indexed.
+  if (text_size > 1'000) {
+    std::array<size_t, 256> prefix_mapping = {0};
+    auto const prefix_wm = pasta::make_wm_semi_external<pasta::BitVector>(
+        path, memory_budget, 1'000, &prefix_mapping);
+    for (size_t i = 0; i < 1'000; ++i) {
+      die_unequal(prefix_wm[i], prefix_mapping[raw_text[i]]);
+    }
+  }
+}
+
+int32_t main() {
+  std::string const path =
+      (std::filesystem::temp_directory_path() /
+       ("pasta_semi_external_test_" + std::to_string(std::random_device()())))
+          .string();
+
+  // Texts consist of at least two different symbols (with high probability).
+  for (size_t const text_size : {size_t{64}, size_t{1'000},
+                                 size_t{100'003}}) {
+    for (size_t const alphabet_size : {2, 3, 4, 17, 64}) {
+      test_semi_external_construction(path, alphabet_size, text_size, 1);
+      test_semi_external_construction(path, alphabet_size, text_size, 777);
+      test_semi_external_construction(path, alphabet_size, text_size,
+                                      1ULL << 20);
+    }
+  }
+  std::filesystem::remove(path);
+
+  bool thrown = false;
+  try {
+    auto const wm =
+        pasta::make_wm_semi_external<pasta::BitVector>(path, 1024);
+  } catch (std::runtime_error const&) {
+    thrown = true;
+  }
+  die_unless(thrown);
+
+  return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * sharded_wavelet_matrix_test.cpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::wavelet_tree is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::wavelet_tree is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::wavelet_tree.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+#include <tlx/die.hpp>
+
+#include <pasta/utils/reduce_alphabet.hpp>
+#include <pasta/wavelet_tree/sharded_wavelet_matrix.hpp>
+
+template <typename ShardedWaveletMatrix>
+void test_sharded_wm(ShardedWaveletMatrix const& swm,
+                     std::vector<uint8_t> const& text,
+                     size_t const alphabet_size) {
+  die_unequal(swm.size(), text.size());
+  std::array<size_t, 256> occ = { 0 };
+
+  for (size_t i = 0; i < text.size(); ++i) {
+    auto const result = swm[i];
+    die_unequal(result, text[i]);
+    auto const char_occ = ++occ[result];
+    die_unequal(char_occ, swm.rank(i + 1, result));
+    die_unequal(i, swm.select(char_occ, result));
+  }
+  for (size_t symbol = 0; symbol < alphabet_size; ++symbol) {
+    die_unequal(occ[symbol], swm.rank(text.size(), symbol));
+    die_unequal(text.size(), swm.select(occ[symbol] + 1, symbol));
+  }
+}
+
+int32_t main() {
+
+  std::random_device rnd_device;
+  std::mt19937 mersenne_engine(rnd_device());
+  std::uniform_int_distribution<uint8_t> dist;
+
+  std::vector<uint8_t> text(2'000'000);
+  std::generate(text.begin(), text.end(),
+                [&](){ return dist(mersenne_engine); });
+  size_t const alphabet_size = pasta::reduce_alphabet(text.begin(),
+                                                      text.end());
+
+  // Shard sizes that do and do not divide the text size.
+  for (size_t const shard_size : {size_t{100'000}, size_t{300'007},
+                                  text.size(), 2 * text.size()}) {
+    auto const swm = pasta::make_sharded_wm<pasta::BitVector>(
+        text.begin(), text.end(), alphabet_size, shard_size, 4);
+    die_unequal(swm.shards(), (text.size() + shard_size - 1) / shard_size);
+    test_sharded_wm(swm, text, alphabet_size);
+  }
+
+  return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,317 @@
+/*******************************************************************************
+ * wavelet_tree_range_queries_test.cpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::wavelet_tree is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::wavelet_tree is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::wavelet_tree.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <tlx/die.hpp>
+
+#include <pasta/wavelet_tree/wavelet_tree.hpp>
+#include <pasta/utils/reduce_alphabet.hpp>
+
+template <typename WaveletStructure>
+void test_range_search_2d(WaveletStructure const& ws,
+                          std::vector<uint8_t> const& text,
+                          size_t const start,
+                          size_t const end,
+                          size_t const lower,
+                          size_t const upper) {
+  std::vector<std::pair<size_t, size_t>> expected;
+  for (size_t i = start; i < end; ++i) {
+    if (lower <= text[i] && text[i] <= upper) {
+      expected.emplace_back(i, text[i]);
+    }
+  }
+
+  die_unequal(ws.range_search_2d(start, end, static_cast<uint8_t>(lower),
+                                 static_cast<uint8_t>(upper)),
+              expected.size());
+
+  std::vector<std::pair<size_t, size_t>> sorted_result;
+  size_t const sorted_count = ws.range_search_2d_sorted(
+      start, end, static_cast<uint8_t>(lower), static_cast<uint8_t>(upper),
+      [&](size_t const position, uint8_t const symbol) {
+        sorted_result.emplace_back(position, symbol);
+      });
+  die_unequal(sorted_count, expected.size());
+  die_unless(sorted_result == expected);
+
+  std::vector<std::pair<size_t, size_t>> result;
+  size_t const count = ws.range_search_2d(
+      start, end, static_cast<uint8_t>(lower), static_cast<uint8_t>(upper),
+      [&](size_t const position, uint8_t const symbol) {
+        result.emplace_back(position, symbol);
+      });
+  die_unequal(count, expected.size());
+  // Points are reported ordered by symbol and then position
+  std::stable_sort(expected.begin(), expected.end(),
+                   [](auto const& lhs, auto const& rhs) {
+                     return lhs.second < rhs.second;
+                   });
+  die_unless(result == expected);
+}
+
+template <typename WaveletStructure>
+void test_frequent_symbols(WaveletStructure const& ws,
+                           std::vector<uint8_t> const& text,
+                           size_t const start,
+                           size_t const end) {
+  std::array<size_t, 256> occ = {0};
+  for (size_t i = start; i < end; ++i) {
+    ++occ[text[i]];
+  }
+  std::vector<size_t> frequencies(occ.begin(), occ.end());
+  std::sort(frequencies.begin(), frequencies.end(), std::greater<size_t>());
+
+  size_t const distinct_symbols = static_cast<size_t>(
+      std::count_if(occ.begin(), occ.end(), [](size_t o) { return o > 0; }));
+
+  size_t const k = 5;
+  auto const top = ws.top_k(start, end, k);
+  die_unequal(top.size(), std::min(k, distinct_symbols));
+  for (size_t i = 0; i < top.size(); ++i) {
+    die_unequal(top[i].second, frequencies[i]);
+    die_unequal(top[i].second, occ[top[i].first]);
+  }
+
+  auto const [mode_symbol, mode_frequency] = ws.mode(start, end);
+  die_unequal(mode_frequency, frequencies[0]);
+  die_unequal(occ[mode_symbol], frequencies[0]);
+
+  auto const majority = ws.majority(start, end);
+  if (frequencies[0] > (end - start) / 2) {
+    die_unless(majority.has_value());
+    die_unequal(occ[*majority], frequencies[0]);
+  } else {
+    die_unless(!majority.has_value());
+  }
+}
+
+template <typename WaveletStructure>
+void test_distinct_intersect(
+    WaveletStructure const& ws,
+    std::vector<uint8_t> const& text,
+    std::vector<std::pair<size_t, size_t>> const& ranges) {
+  std::vector<std::array<size_t, 256>> occ(ranges.size());
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    occ[i].fill(0);
+    for (size_t j = ranges[i].first; j < ranges[i].second; ++j) {
+      ++occ[i][text[j]];
+    }
+  }
+
+  std::vector<std::pair<size_t, size_t>> expected_distinct;
+  for (size_t symbol = 0; symbol < 256; ++symbol) {
+    if (occ[0][symbol] > 0) {
+      expected_distinct.emplace_back(symbol, occ[0][symbol]);
+    }
+  }
+  auto const distinct = ws.distinct(ranges[0].first, ranges[0].second);
+  die_unequal(distinct.size(), expected_distinct.size());
+  for (size_t i = 0; i < distinct.size(); ++i) {
+    die_unequal(static_cast<size_t>(distinct[i].first),
+                expected_distinct[i].first);
+    die_unequal(distinct[i].second, expected_distinct[i].second);
+  }
+
+  std::vector<size_t> expected_intersection;
+  for (size_t symbol = 0; symbol < 256; ++symbol) {
+    if (std::all_of(occ.begin(), occ.end(),
+                    [&](auto const& o) { return o[symbol] > 0; })) {
+      expected_intersection.push_back(symbol);
+    }
+  }
+  size_t next = 0;
+  size_t const count = ws.intersect(
+      ranges, [&](uint8_t const symbol, std::span<size_t const> frequencies) {
+        die_unless(next < expected_intersection.size());
+        die_unequal(static_cast<size_t>(symbol), expected_intersection[next]);
+        die_unequal(frequencies.size(), ranges.size());
+        for (size_t i = 0; i < ranges.size(); ++i) {
+          die_unequal(frequencies[i], occ[i][symbol]);
+        }
+        ++next;
+      });
+  die_unequal(count, expected_intersection.size());
+  die_unequal(next, expected_intersection.size());
+}
+
+template <typename WaveletStructure>
+void test_occurrences(WaveletStructure const& ws,
+                      std::vector<uint8_t> const& text,
+                      size_t const start,
+                      size_t const end,
+                      size_t const symbol) {
+  std::vector<size_t> expected;
+  for (size_t i = start; i < end; ++i) {
+    if (text[i] == symbol) {
+      expected.push_back(i);
+    }
+  }
+
+  auto const occurrences =
+      ws.occurrences(start, end, static_cast<uint8_t>(symbol));
+  die_unequal(occurrences.size(), expected.size());
+  std::vector<size_t> result;
+  for (size_t const position : occurrences) {
+    result.push_back(position);
+  }
+  die_unless(result == expected);
+
+  result.clear();
+  for (size_t const position :
+       ws.template occurrences<true>(start, end, static_cast<uint8_t>(symbol))) {
+    result.push_back(position);
+  }
+  die_unless(result == expected);
+}
+
+template <typename WaveletStructure>
+void test_range_queries(WaveletStructure const& ws,
+                        std::vector<uint8_t> const& text,
+                        size_t const alphabet_size,
+                        std::mt19937& mersenne_engine) {
+  size_t const max_symbol = (size_t{1} << std::bit_width(alphabet_size - 1));
+  std::uniform_int_distribution<size_t> pos_dist(0, text.size() - 1);
+  std::uniform_int_distribution<size_t> len_dist(1, 2'000);
+  std::uniform_int_distribution<size_t> symbol_dist(0, max_symbol - 1);
+
+  for (size_t query = 0; query < 5'000; ++query) {
+    size_t const start = pos_dist(mersenne_engine);
+    size_t const end = std::min(text.size(), start + len_dist(mersenne_engine));
+    std::vector<uint8_t> sorted(text.begin() + start, text.begin() + end);
+    std::sort(sorted.begin(), sorted.end());
+
+    auto const extracted = ws.extract(start, end);
+    die_unless(std::equal(extracted.begin(), extracted.end(),
+                          text.begin() + start, text.begin() + end));
+
+    for (size_t k = 0; k < sorted.size(); k += 1 + sorted.size() / 16) {
+      die_unequal(static_cast<size_t>(ws.quantile(start, end, k)),
+                  static_cast<size_t>(sorted[k]));
+    }
+    die_unequal(static_cast<size_t>(ws.quantile(start, end, sorted.size() - 1)),
+                static_cast<size_t>(sorted.back()));
+
+    size_t const symbol = symbol_dist(mersenne_engine);
+    size_t const other = symbol_dist(mersenne_engine);
+    size_t const lower = std::min(symbol, other);
+    size_t const upper = std::max(symbol, other);
+
+    auto const first_not_less =
+        std::lower_bound(sorted.begin(), sorted.end(), symbol);
+    die_unequal(ws.count_less(start, end, static_cast<uint8_t>(symbol)),
+                static_cast<size_t>(first_not_less - sorted.begin()));
+
+    size_t const expected_range = static_cast<size_t>(
+        std::upper_bound(sorted.begin(), sorted.end(), upper) -
+        std::lower_bound(sorted.begin(), sorted.end(), lower));
+    die_unequal(ws.count_range(start, end, static_cast<uint8_t>(lower),
+                               static_cast<uint8_t>(upper)),
+                expected_range);
+    die_unequal(ws.count_range(start, end, static_cast<uint8_t>(upper),
+                               static_cast<uint8_t>(upper)),
+                static_cast<size_t>(
+                    std::upper_bound(sorted.begin(), sorted.end(), upper) -
+                    std::lower_bound(sorted.begin(), sorted.end(), upper)));
+
+    if (query % 10 == 0) {
+      test_range_search_2d(ws, text, start, end, lower, upper);
+      test_frequent_symbols(ws, text, start, end);
+      // Short intervals often have a majority
+      test_frequent_symbols(ws, text, start, std::min(end, start + 3));
+
+      std::vector<std::pair<size_t, size_t>> ranges = {{start, end}};
+      for (size_t i = 0; i < query % 3 + 1; ++i) {
+        size_t const other_start = pos_dist(mersenne_engine);
+        ranges.emplace_back(other_start,
+                            std::min(text.size(),
+                                     other_start + len_dist(mersenne_engine)));
+      }
+      test_distinct_intersect(ws, text, ranges);
+      test_occurrences(ws, text, start, end, symbol);
+      test_occurrences(ws, text, start, end, text[start]);
+    }
+
+    auto const next = ws.next_value(start, end, static_cast<uint8_t>(symbol));
+    if (first_not_less == sorted.end()) {
+      die_unless(!next.has_value());
+    } else {
+      die_unless(next.has_value());
+      die_unequal(static_cast<size_t>(*next),
+                  static_cast<size_t>(*first_not_less));
+    }
+  }
+
+  // Wide rectangles, where the occurrences on a level are far apart
+  std::uniform_int_distribution<size_t> wide_dist(0, text.size() / 2);
+  for (size_t query = 0; query < 20; ++query) {
+    size_t const start = wide_dist(mersenne_engine);
+    size_t const end = start + wide_dist(mersenne_engine);
+    size_t const symbol = symbol_dist(mersenne_engine);
+    test_range_search_2d(ws, text, start, end, symbol,
+                         std::min(max_symbol - 1, symbol + query));
+    test_occurrences(ws, text, start, end, symbol);
+
+    auto const extracted = ws.extract(start, end);
+    die_unless(std::equal(extracted.begin(), extracted.end(),
+                          text.begin() + start, text.begin() + end));
+  }
+}
+
+void test_text(std::vector<uint8_t>& text, std::mt19937& mersenne_engine) {
+  size_t const alphabet_size = pasta::reduce_alphabet(text.begin(), text.end());
+
+  auto wt = pasta::make_wt<pasta::BitVector>(text.begin(), text.end(),
+                                             alphabet_size);
+  test_range_queries(wt, text, alphabet_size, mersenne_engine);
+
+  auto wm = pasta::make_wm<pasta::BitVector>(text.begin(), text.end(),
+                                             alphabet_size);
+  test_range_queries(wm, text, alphabet_size, mersenne_engine);
+}
+
+int32_t main() {
+
+  std::random_device rnd_device;
+  std::mt19937 mersenne_engine(rnd_device());
+
+  {
+    std::uniform_int_distribution<uint8_t> dist;
+    std::vector<uint8_t> text(500'000);
+    std::generate(text.begin(), text.end(),
+                  [&](){ return dist(mersenne_engine); });
+    test_text(text, mersenne_engine);
+  }
+
+  {
+    // Alphabet that does not use all symbols representable with the levels
+    std::uniform_int_distribution<uint8_t> dist(0, 99);
+    std::vector<uint8_t> text(500'000);
+    std::generate(text.begin(), text.end(),
+                  [&](){ return dist(mersenne_engine); });
+    test_text(text, mersenne_engine);
+  }
+
+  return 0;
+}
+
+/******************************************************************************/
@@ -25,6 +25,7 @@
 #include <tlx/die.hpp>
 
 #include <pasta/wavelet_tree/wavelet_tree.hpp>
+#include <pasta/utils/byte_alphabet.hpp>
 #include <pasta/utils/reduce_alphabet.hpp>
 
 int32_t main() {
@@ -38,11 +39,23 @@ int32_t main() {
   std::generate(text.begin(), text.end(),
                 [&](){ return dist(mersenne_engine); });
 
+  // The parallel (SIMD) byte alphabet reduction must compute the same
+  // reduced text and mapping (the chunks end with less than 32 symbols).
+  std::vector<uint8_t> byte_text = text;
+  pasta::ByteHistogram byte_alphabet_mapping;
+  size_t const byte_alphabet_size = pasta::reduce_byte_alphabet(
+      byte_text.data(), byte_text.data() + byte_text.size(),
+      &byte_alphabet_mapping, 4);
+
   std::array<size_t, std::numeric_limits<
     typename decltype(text)::value_type>::max() + 1> alphabet_mapping;
   size_t alphabet_size = pasta::reduce_alphabet(text.begin(), text.end(),
                                                 &alphabet_mapping);
 
+  die_unequal(byte_alphabet_size, alphabet_size);
+  die_unless(byte_alphabet_mapping == alphabet_mapping);
+  die_unless(std::equal(byte_text.begin(), byte_text.end(), text.begin()));
+
   auto wt = pasta::make_wt<pasta::BitVector>(text.begin(), text.end(),
 					       alphabet_size);
 
@@ -78,6 +91,43 @@ int32_t main() {
     die_unequal(i, pos);
   }
 
+  // Buffering the scattered bits must not change the wavelet tree/matrix
+  // (also for texts, where the levels do not start at word boundaries).
+  size_t const levels = std::bit_width(alphabet_size - 1);
+  for (size_t const size : {text.size(), size_t{100'003}}) {
+    pasta::BitVector wt_bv(size * levels, 0);
+    pasta::BitVector buffered_wt_bv(size * levels, 0);
+    pasta::prefix_counting<pasta::WaveletTypes::TREE>(
+        text.begin(), text.begin() + size, levels, wt_bv);
+    pasta::prefix_counting<pasta::WaveletTypes::TREE, true>(
+        text.begin(), text.begin() + size, levels, buffered_wt_bv);
+    die_unless(std::ranges::equal(wt_bv.data(), buffered_wt_bv.data()));
+
+    pasta::BitVector wm_bv(size * levels, 0);
+    pasta::BitVector buffered_wm_bv(size * levels, 0);
+    pasta::prefix_counting<pasta::WaveletTypes::MATRIX>(
+        text.begin(), text.begin() + size, levels, wm_bv);
+    pasta::prefix_counting<pasta::WaveletTypes::MATRIX, true>(
+        text.begin(), text.begin() + size, levels, buffered_wm_bv);
+    die_unless(std::ranges::equal(wm_bv.data(), buffered_wm_bv.data()));
+  }
+
+  // Consuming the text must not change the wavelet tree/matrix.
+  std::vector<uint8_t> consumed_text = text;
+  auto const consuming_wm =
+      pasta::make_wm<pasta::BitVector>(std::move(consumed_text), alphabet_size);
+  die_unless(consumed_text.empty());
+  consumed_text = text;
+  auto const consuming_wt =
+      pasta::make_wt<pasta::BitVector>(std::move(consumed_text), alphabet_size);
+  die_unless(consumed_text.empty());
+  for (size_t i = 0; i < text.size(); i += 7) {
+    die_unequal(consuming_wm[i], wm[i]);
+    die_unequal(consuming_wt[i], wt[i]);
+    die_unequal(consuming_wm.rank(i, text[i]), wm.rank(i, text[i]));
+    die_unequal(consuming_wt.rank(i, text[i]), wt.rank(i, text[i]));
+  }
+
   return 0;
 }
 
@@ -0,0 +1,262 @@
+/*! \file pasta_support.hpp
+    \brief pasta_support.hpp contains adapters that expose the rank and select
+           data structures of pasta::bit_vector (FlatRank, FlatRankSelect,
+           WideRank, and WideRankSelect) through the rank and select support
+           interface of the sdsl. Thus, sdsl data structures (e.g., wm_int) can
+           use the pasta rank and select kernels on an sdsl bit_vector.
+*/
+#ifndef INCLUDED_SDSL_PASTA_SUPPORT
+#define INCLUDED_SDSL_PASTA_SUPPORT
+
+#include <sdsl/int_vector.hpp>
+#include <sdsl/util.hpp>
+
+#include <pasta/bit_vector/support/flat_rank.hpp>
+#include <pasta/bit_vector/support/flat_rank_select.hpp>
+#include <pasta/bit_vector/support/wide_rank.hpp>
+#include <pasta/bit_vector/support/wide_rank_select.hpp>
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+
+//! Namespace for the succinct data structure library.
+namespace sdsl
+{
+
+//! View of the words of an sdsl bit_vector with the members pasta's rank and select data structures read.
+/*! The pasta data structures only read the number of words (size_) and a
+ *  pointer to the words (data_.data()). Like pasta::BitVector, an sdsl
+ *  bit_vector of n bits always stores n/64+1 words, i.e., the view covers
+ *  exactly the words that are allocated.
+ */
+struct pasta_bit_vector_view {
+    typedef const uint64_t* RawDataConstAccess;
+
+    size_t                    size_;
+    std::span<const uint64_t> data_;
+
+    explicit pasta_bit_vector_view(const bit_vector& v) :
+        size_((v.size() >> 6) + 1), data_(v.data(), size_) {}
+};
+
+//! sdsl rank support using a pasta rank data structure, which it owns.
+/*! \tparam t_pasta Type of the pasta rank data structure (FlatRank, WideRank, or the
+ *                  rank and select data structures to share them with select_support_pasta).
+ *  \tparam t_b     Bit pattern `0` or `1` which should be ranked.
+ *
+ *  The pasta data structure points to the words of the bit_vector. Thus, it
+ *  is rebuilt whenever the bit_vector is set (set_vector or load), as the
+ *  words may be at another address or contain other bits, even if the
+ *  address is the same (sdsl reuses the words when an int_vector of the same
+ *  size is loaded or assigned). The pasta data structure is not serialized,
+ *  instead, it is rebuilt on load.
+ */
+template<class t_pasta, uint8_t t_b=1>
+class rank_support_pasta
+{
+        static_assert(t_b == 1u or t_b == 0u , "rank_support_pasta: bit pattern must be `0` or `1`");
+
+    public:
+        typedef bit_vector::size_type size_type;
+        typedef bit_vector            bit_vector_type;
+        enum { bit_pat = t_b };
+        enum { bit_pat_len = (uint8_t)1 };
+
+    private:
+        const bit_vector*      m_v = nullptr;
+        std::optional<t_pasta> m_pasta;
+
+        void build()
+        {
+            m_pasta.reset();
+            if (m_v != nullptr) {
+                pasta_bit_vector_view view(*m_v);
+                m_pasta.emplace(view);
+            }
+        }
+
+    public:
+        explicit rank_support_pasta(const bit_vector* v=nullptr) : m_v(v)
+        {
+            build();
+        }
+
+        rank_support_pasta(const rank_support_pasta& rs) : m_v(rs.m_v)
+        {
+            build();
+        }
+
+        rank_support_pasta(rank_support_pasta&&) = default;
+
+        rank_support_pasta& operator=(const rank_support_pasta& rs)
+        {
+            if (this != &rs) {
+                m_v = rs.m_v;
+                build();
+            }
+            return *this;
+        }
+
+        rank_support_pasta& operator=(rank_support_pasta&&) = default;
+
+        void swap(rank_support_pasta& rs)
+        {
+            std::swap(m_v, rs.m_v);
+            std::swap(m_pasta, rs.m_pasta);
+        }
+
+        //! Sets the supported bit_vector and rebuilds the data structure for its words.
+        void set_vector(const bit_vector* v=nullptr)
+        {
+            m_v = v;
+            build();
+        }
+
+        //! The pasta data structure (nullptr if no bit_vector is set).
+        const t_pasta* pasta()const
+        {
+            return m_pasta.has_value() ? &*m_pasta : nullptr;
+        }
+
+        //! Number of occurrences of the bit pattern in the prefix [0..idx-1].
+        size_type rank(size_type idx)const
+        {
+            if (t_b == 1) {
+                return m_pasta->rank1(idx);
+            }
+            return m_pasta->rank0(idx);
+        }
+
+        size_type operator()(size_type idx)const
+        {
+            return rank(idx);
+        }
+
+        size_type size()const
+        {
+            return m_v == nullptr ? 0 : m_v->size();
+        }
+
+        size_type serialize(std::ostream&, structure_tree_node* v=nullptr,
+                            std::string name="")const
+        {
+            structure_tree_node* child = structure_tree::add_child(v, name, util::class_name(*this));
+            size_type written_bytes = m_pasta.has_value() ? m_pasta->space_usage() : 0;
+            structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        void load(std::istream&, const bit_vector* v=nullptr)
+        {
+            set_vector(v);
+        }
+};
+
+//! sdsl select support using the pasta rank and select data structure of a rank_support_pasta.
+/*! \tparam t_pasta Type of the pasta rank and select data structure (FlatRankSelect or
+ *                  WideRankSelect).
+ *  \tparam t_b     Bit pattern `0` or `1` which should be selected.
+ *
+ *  pasta's rank and select data structures answer rank and select queries
+ *  for both bit patterns. Thus, the select support does not own a data
+ *  structure, instead, it uses the one of the rank support, which is set with
+ *  set_rank_support (e.g., by wm_int) and must be set again whenever the rank
+ *  support is moved or rebuilt. Its space is reported by the rank support.
+ */
+template<class t_pasta, uint8_t t_b=1>
+class select_support_pasta
+{
+        static_assert(t_b == 1u or t_b == 0u , "select_support_pasta: bit pattern must be `0` or `1`");
+
+    public:
+        typedef bit_vector::size_type size_type;
+        typedef bit_vector            bit_vector_type;
+        enum { bit_pat = t_b };
+        enum { bit_pat_len = (uint8_t)1 };
+
+    private:
+        const bit_vector* m_v = nullptr;
+        const t_pasta*    m_pasta = nullptr;
+
+    public:
+        explicit select_support_pasta(const bit_vector* v=nullptr) : m_v(v) {}
+
+        void swap(select_support_pasta& ss)
+        {
+            std::swap(m_v, ss.m_v);
+            std::swap(m_pasta, ss.m_pasta);
+        }
+
+        //! Uses the pasta data structure of the rank support rs.
+        template<uint8_t t_rank_b>
+        void set_rank_support(const rank_support_pasta<t_pasta, t_rank_b>& rs)
+        {
+            m_pasta = rs.pasta();
+        }
+
+        void set_vector(const bit_vector* v=nullptr)
+        {
+            m_v = v;
+        }
+
+        //! Position of the i-th occurrence of the bit pattern (\f$ i\geq 1\f$).
+        size_type select(size_type i)const
+        {
+            assert(m_pasta != nullptr);
+            if (t_b == 1) {
+                return m_pasta->select1(i);
+            }
+            return m_pasta->select0(i);
+        }
+
+        size_type operator()(size_type i)const
+        {
+            return select(i);
+        }
+
+        size_type size()const
+        {
+            return m_v == nullptr ? 0 : m_v->size();
+        }
+
+        size_type serialize(std::ostream&, structure_tree_node* v=nullptr,
+                            std::string name="")const
+        {
+            structure_tree_node* child = structure_tree::add_child(v, name, util::class_name(*this));
+            structure_tree::add_size(child, 0);
+            return 0;
+        }
+
+        void load(std::istream&, const bit_vector* v=nullptr)
+        {
+            set_vector(v);
+        }
+};
+
+//! pasta::FlatRankSelect for an sdsl bit_vector.
+typedef pasta::FlatRankSelect<pasta::OptimizedFor::DONT_CARE, pasta::FindL2FlatWith::LINEAR_SEARCH,
+                              pasta_bit_vector_view> pasta_flat_rank_select;
+//! pasta::WideRankSelect for an sdsl bit_vector.
+typedef pasta::WideRankSelect<pasta::OptimizedFor::DONT_CARE, pasta::FindL2WideWith::LINEAR_SEARCH,
+                              pasta_bit_vector_view> pasta_wide_rank_select;
+
+//! Rank support using pasta::FlatRankSelect (shared with select_support_pasta_flat).
+template<uint8_t t_b=1>
+using rank_support_pasta_flat = rank_support_pasta<pasta_flat_rank_select, t_b>;
+//! Select support using pasta::FlatRankSelect (shared with rank_support_pasta_flat).
+template<uint8_t t_b=1>
+using select_support_pasta_flat = select_support_pasta<pasta_flat_rank_select, t_b>;
+//! Rank support using pasta::WideRankSelect (shared with select_support_pasta_wide).
+template<uint8_t t_b=1>
+using rank_support_pasta_wide = rank_support_pasta<pasta_wide_rank_select, t_b>;
+//! Select support using pasta::WideRankSelect (shared with rank_support_pasta_wide).
+template<uint8_t t_b=1>
+using select_support_pasta_wide = select_support_pasta<pasta_wide_rank_select, t_b>;
+
+}// end namespace sdsl
+#endif
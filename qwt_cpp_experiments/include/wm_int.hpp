@@ -31,6 +31,7 @@
 #include <set> // for calculating the alphabet size
 #include <map> // for mapping a symbol to its lexicographical index
 #include <algorithm> // for std::swap
+#include <array>
 #include <stdexcept>
 #include <vector>
 #include <queue>
@@ -83,6 +84,11 @@ class wm_int
 
         struct node_type;
 
+        //! Upper bound for the number of levels (the symbols have 64 bits)
+        enum {max_levels=64};
+        //! Per-level state of a query, which can be kept on the stack
+        typedef std::array<size_type, max_levels+1>  level_array_type;
+
 
     protected:
 
@@ -96,6 +102,17 @@ class wm_int
         int_vector<64>         m_zero_cnt;     // m_zero_cnt[i] contains the number of zeros in level i
         int_vector<64>         m_rank_level;   // m_rank_level[i] contains m_tree_rank(i*size())
 
+        //! Lets the select supports that use the data structure of the rank support (e.g., select_support_pasta) use the one of m_tree_rank.
+        void share_rank_support()
+        {
+            if constexpr (requires { m_tree_select1.set_rank_support(m_tree_rank); }) {
+                m_tree_select1.set_rank_support(m_tree_rank);
+            }
+            if constexpr (requires { m_tree_select0.set_rank_support(m_tree_rank); }) {
+                m_tree_select0.set_rank_support(m_tree_rank);
+            }
+        }
+
         void copy(const wm_int& wt)
         {
             m_size          = wt.m_size;
@@ -110,6 +127,115 @@ class wm_int
             m_max_level     = wt.m_max_level;
             m_zero_cnt      = wt.m_zero_cnt;
             m_rank_level    = wt.m_rank_level;
+            share_rank_support();
+        }
+
+        //! Builds all levels in memory.
+        /*! The bits of each level are packed into words, which are written
+         *  directly into the words of tree. The stable partition of the
+         *  symbols by the bit of the level alternates between rac and one
+         *  buffer of the same size (ping-pong), i.e., no temporary files are
+         *  used.
+         */
+        template<uint8_t int_width>
+        void construct_in_memory(int_vector<int_width>& rac, bit_vector& tree)
+        {
+            tree = bit_vector(m_size*m_max_level, 0);
+            uint64_t* tree_data = tree.data();
+            int_vector<int_width> buf(m_size, 0, rac.width());
+            int_vector<int_width>* src = &rac;
+            int_vector<int_width>* dst = &buf;
+
+            for (uint32_t k=0; k<m_max_level; ++k) {
+                uint8_t   width = m_max_level-k-1;
+                size_type tree_pos = k*m_size;
+                size_type ones = 0;
+                for (size_type i=0; i<m_size; i+=64) {
+                    size_type block_size = std::min<size_type>(64, m_size-i);
+                    uint64_t  word = 0;
+                    for (size_type j=0; j<block_size; ++j) {
+                        word |= (((*src)[i+j] >> width) & 1ULL) << j;
+                    }
+                    ones += bits::cnt(word);
+                    // The level starts at bit k*m_size, which is not necessarily the
+                    // beginning of a word. Thus, the word may spill into the next one.
+                    uint8_t offset = tree_pos & 0x3FULL;
+                    tree_data[tree_pos >> 6] |= word << offset;
+                    if (offset > 0 and (word >> (64-offset)) > 0) {
+                        tree_data[(tree_pos >> 6) + 1] |= word >> (64-offset);
+                    }
+                    tree_pos += block_size;
+                }
+                size_type zeros = m_size-ones;
+                m_zero_cnt[k] = zeros;
+                // Also partition after the last level, such that equal symbols are
+                // consecutive, which is used to determine the alphabet size.
+                size_type zero_pos = 0;
+                size_type one_pos  = zeros;
+                for (size_type i=0; i<m_size; ++i) {
+                    value_type x = (*src)[i];
+                    if ((x >> width) & 1ULL) {
+                        (*dst)[one_pos++] = x;
+                    } else {
+                        (*dst)[zero_pos++] = x;
+                    }
+                }
+                std::swap(src, dst);
+            }
+            if (src != &rac) {
+                rac.swap(buf);
+            }
+        }
+
+        //! Builds all levels using temporary files in tmp_dir.
+        template<uint8_t int_width>
+        void construct_semi_external(int_vector<int_width>& rac, bit_vector& tree,
+                                     const std::string& tmp_dir)
+        {
+            std::string tmp_file_prefix = tmp_dir + "/" + util::to_string(util::pid()) + "_"
+                                          + util::to_string(util::id());
+            std::string tree_out_buf_file_name = tmp_file_prefix + "_wm_int_tree";
+            osfstream tree_out_buf(tree_out_buf_file_name, std::ios::binary | std::ios::trunc | std::ios::out);   // open buffer for tree
+            size_type bit_size = m_size*m_max_level;
+            tree_out_buf.write((char*) &bit_size, sizeof(bit_size));    // write size of bit_vector
+
+            std::string zero_buf_file_name = tmp_file_prefix + "_wm_int_zero_buf";
+
+            size_type tree_pos = 0;
+            uint64_t tree_word = 0;
+
+            for (uint32_t k=0; k<m_max_level; ++k) {
+                uint8_t        width = m_max_level-k-1;
+                const uint64_t mask  = 1ULL<<width;
+                uint64_t       x     = 0;
+                size_type      zeros = 0;
+                int_vector_buffer<> zero_buf(zero_buf_file_name, std::ios::out, 1024*1024, m_max_level);
+                for (size_t i=0; i<m_size; ++i) {
+                    x = rac[i];
+                    if (x&mask) {
+                        tree_word |= (1ULL << (tree_pos&0x3FULL));
+                        zero_buf.push_back(x);
+                    } else {
+                        rac[zeros++ ] = x;
+                    }
+                    ++tree_pos;
+                    if ((tree_pos & 0x3FULL) == 0) { // if tree_pos % 64 == 0 write old word
+                        tree_out_buf.write((char*) &tree_word, sizeof(tree_word));
+                        tree_word = 0;
+                    }
+                }
+                m_zero_cnt[k] = zeros;
+                for (size_t i=zeros; i<m_size; ++i) {
+                    rac[i] = zero_buf[i-zeros];
+                }
+            }
+            if ((tree_pos & 0x3FULL) != 0) { // if tree_pos % 64 > 0 => there are remaining entries we have to write
+                tree_out_buf.write((char*) &tree_word, sizeof(tree_word));
+            }
+            sdsl::remove(zero_buf_file_name);
+            tree_out_buf.close();
+            load_from_file(tree, tree_out_buf_file_name);
+            sdsl::remove(tree_out_buf_file_name);
         }
 
     public:
@@ -123,19 +249,23 @@ class wm_int
         {
         };
 
-        //! Semi-external constructor
+        //! Constructor
         /*! \param buf         File buffer of the int_vector for which the wm_int should be build.
          *  \param size        Size of the prefix of v, which should be indexed.
          *  \param max_level   Maximal level of the wavelet tree. If set to 0, determined automatically.
+         *  \param tmp_dir     If empty, the wavelet tree is built in memory. Otherwise, the levels
+         *                     and the partitioned symbols are buffered in (uniquely named)
+         *                     temporary files in this directory.
          *    \par Time complexity
          *        \f$ \Order{n\log|\Sigma|}\f$, where \f$n=size\f$
          *        I.e. we need \Order{n\log n} if rac is a permutation of 0..n-1.
          *    \par Space complexity
-         *        \f$ n\log|\Sigma| + O(1)\f$ bits, where \f$n=size\f$.
+         *        In memory: \f$ n\log|\Sigma|\f$ bits plus a copy of rac.
+         *        Semi-external: \f$ n\log|\Sigma| + O(1)\f$ bits, where \f$n=size\f$.
          */
         template<uint8_t int_width>
         wm_int(int_vector<int_width>& rac, size_type size,
-               uint32_t max_level=0) : m_size(size)
+               uint32_t max_level=0, const std::string& tmp_dir="") : m_size(size)
         {
             if (0 == m_size)
                 return;
@@ -168,57 +298,23 @@ class wm_int
             }
 
 
-            std::string tree_out_buf_file_name = "tmp_tree_out";//tmp_file(buf.filename(), "_m_tree");
-            osfstream tree_out_buf(tree_out_buf_file_name, std::ios::binary | std::ios::trunc | std::ios::out);   // open buffer for tree
-            size_type bit_size = m_size*m_max_level;
-            tree_out_buf.write((char*) &bit_size, sizeof(bit_size));    // write size of bit_vector
-
-            std::string zero_buf_file_name = "tmp_zero_buf";//tmp_file(buf.filename(), "_zero_buf");
-
-            size_type tree_pos = 0;
-            uint64_t tree_word = 0;
-
             m_zero_cnt = int_vector<64>(m_max_level, 0); // zeros at level i
 
-            for (uint32_t k=0; k<m_max_level; ++k) {
-                uint8_t        width = m_max_level-k-1;
-                const uint64_t mask  = 1ULL<<width;
-                uint64_t       x     = 0;
-                size_type      zeros = 0;
-                int_vector_buffer<> zero_buf(zero_buf_file_name, std::ios::out, 1024*1024, m_max_level);
-                for (size_t i=0; i<m_size; ++i) {
-                    x = rac[i];
-                    if (x&mask) {
-                        tree_word |= (1ULL << (tree_pos&0x3FULL));
-                        zero_buf.push_back(x);
-                    } else {
-                        rac[zeros++ ] = x;
-                    }
-                    ++tree_pos;
-                    if ((tree_pos & 0x3FULL) == 0) { // if tree_pos % 64 == 0 write old word
-                        tree_out_buf.write((char*) &tree_word, sizeof(tree_word));
-                        tree_word = 0;
-                    }
-                }
-                m_zero_cnt[k] = zeros;
-                for (size_t i=zeros; i<m_size; ++i) {
-                    rac[i] = zero_buf[i-zeros];
-                }
-            }
-            if ((tree_pos & 0x3FULL) != 0) { // if tree_pos % 64 > 0 => there are remaining entries we have to write
-                tree_out_buf.write((char*) &tree_word, sizeof(tree_word));
+            bit_vector tree;
+            if (tmp_dir.empty()) {
+                construct_in_memory(rac, tree);
+            } else {
+                construct_semi_external(rac, tree, tmp_dir);
             }
-            sdsl::remove(zero_buf_file_name);
-            tree_out_buf.close();
             m_sigma = std::unique(rac.begin(), rac.end()) - rac.begin();
             rac.resize(0);
-            bit_vector tree;
-            load_from_file(tree, tree_out_buf_file_name);
-            sdsl::remove(tree_out_buf_file_name);
             m_tree = bit_vector_type(std::move(tree));
-            util::init_support(m_tree_rank, &m_tree);
-            util::init_support(m_tree_select0, &m_tree);
-            util::init_support(m_tree_select1, &m_tree);
+            // Not util::init_support, which calls set_vector after building the
+            // support, and set_vector of rank_support_pasta builds it again
+            m_tree_rank    = rank_1_type(&m_tree);
+            m_tree_select0 = select_0_type(&m_tree);
+            m_tree_select1 = select_1_type(&m_tree);
+            share_rank_support();
             m_rank_level = int_vector<64>(m_max_level, 0);
             for (uint32_t k=0; k<m_rank_level.size(); ++k) {
                 m_rank_level[k] = m_tree_rank(k*m_size);
@@ -262,6 +358,7 @@ class wm_int
                 m_max_level     = std::move(wt.m_max_level);
                 m_zero_cnt      = std::move(wt.m_zero_cnt);
                 m_rank_level    = std::move(wt.m_rank_level);
+                share_rank_support();
             }
             return *this;
         }
@@ -279,6 +376,8 @@ class wm_int
                 std::swap(m_max_level,  wt.m_max_level);
                 m_zero_cnt.swap(wt.m_zero_cnt);
                 m_rank_level.swap(wt.m_rank_level);
+                share_rank_support();
+                wt.share_rank_support();
             }
         }
 
@@ -397,8 +496,8 @@ class wm_int
         {
             assert(1 <= i and i <= rank(size(), c));
             uint64_t mask = 1ULL << (m_max_level-1);
-            int_vector<64> m_path_off(max_level+1);
-            int_vector<64> m_path_rank_off(max_level+1);
+            level_array_type m_path_off;
+            level_array_type m_path_rank_off;
             m_path_off[0] = m_path_rank_off[0] = 0;
             size_type b = 0; // start position of the interval
             size_type r = i;
@@ -444,26 +543,47 @@ class wm_int
         range_search_2d(size_type lb, size_type rb, value_type vlb, value_type vrb,
                         bool report=true) const
         {
+            point_vec_type point_vec;
+            size_type cnt_answers = range_search_2d(lb, rb, vlb, vrb, point_vec, report);
+            return make_pair(cnt_answers, std::move(point_vec));
+        }
 
+        //! range_search_2d searches points in the index interval [lb..rb] and value interval [vlb..vrb].
+        /*! \param lb        Left bound of index interval (inclusive)
+         *  \param rb        Right bound of index interval (inclusive)
+         *  \param vlb       Left bound of value interval (inclusive)
+         *  \param vrb       Right bound of value interval (inclusive)
+         *  \param point_vec Caller-provided vector the matching points are written to. It is
+         *                   cleared first, i.e., its capacity is reused across queries.
+         *  \param report    Should the matching points be returned?
+         *  \return The number of found points.
+         *  \par Note
+         *       Only point_vec may allocate memory, i.e., counting (report = false) and
+         *       reporting into a vector with sufficient capacity do not allocate.
+         */
+        size_type
+        range_search_2d(size_type lb, size_type rb, value_type vlb, value_type vrb,
+                        point_vec_type& point_vec, bool report=true) const
+        {
+            point_vec.clear();
             if (vrb > (1ULL << m_max_level))
                 vrb = (1ULL << m_max_level);
             if (vlb > vrb)
-                return make_pair(0, point_vec_type());
+                return 0;
             size_type cnt_answers = 0;
-            point_vec_type point_vec;
             if (lb <= rb) {
-                std::vector<size_type> is(m_max_level+1);
-                std::vector<size_type> rank_off(m_max_level+1);
+                level_array_type is;
+                level_array_type rank_off;
                 _range_search_2d(root(), {lb, rb}, vlb, vrb, 0, is,
                                  rank_off, point_vec, report, cnt_answers);
             }
-            return make_pair(cnt_answers, point_vec);
+            return cnt_answers;
         }
 
         void
         _range_search_2d(node_type v, range_type r, value_type vlb,
-                         value_type vrb, size_type ilb, std::vector<size_type>& is,
-                         std::vector<size_type>& rank_off, point_vec_type& point_vec,
+                         value_type vrb, size_type ilb, level_array_type& is,
+                         level_array_type& rank_off, point_vec_type& point_vec,
                          bool report, size_type& cnt_answers)
         const
         {
@@ -551,6 +671,7 @@ class wm_int
             m_tree_rank.load(in, &m_tree);
             m_tree_select1.load(in, &m_tree);
             m_tree_select0.load(in, &m_tree);
+            share_rank_support();
             read_member(m_max_level, in);
             m_zero_cnt.load(in);
             m_rank_level.load(in);
@@ -618,8 +739,11 @@ class wm_int
         }
 
         //! Random access container to sequence of node v
-        auto seq(const node_type& v) const -> random_access_container<std::function<value_type(size_type)>> {
-            return random_access_container<std::function<value_type(size_type)>>([&v, this](size_type i)
+        /*! The node is captured by value and the access functor is not wrapped in a
+         *  std::function, i.e., accessing the sequence does not allocate memory.
+         */
+        auto seq(const node_type& v) const {
+            auto access = [v, this](size_type i)
             {
                 node_type vv = v;
                 while (!is_leaf(vv)) {
@@ -630,7 +754,8 @@ class wm_int
                     vv = vs[bit];
                 }
                 return sym(vv);
-            }, size(v));
+            };
+            return random_access_container<decltype(access)>(access, size(v));
         }
 
         //! Indicates if node v is empty
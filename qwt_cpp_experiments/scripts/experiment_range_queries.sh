@@ -0,0 +1,9 @@
+#!/bin/sh
+
+for text in english/big_english sources/sources dna/dna commoncrawl/cc
+do
+	for width in 16 64 256 1024 4096 16384 65536 262144 1048576
+	do
+		./../build/wavelet_tree_range_queries_benchmark -n 1GiB -q 100000 -r 5 -w ${width} /data1/Texts/qwt_tests/${text}
+	done
+done